@@ -0,0 +1,47 @@
+# Resolves #include <...> the same way as VulkanShader::ReadShaderFile(),
+# the included file is pasted in place, so the output matches the runtime source.
+# Usage: cmake -DINPUT=<shader> -DOUTPUT=<file> -DSHADER_FOLDER=<folder> -P PreprocessShader.cmake
+
+cmake_minimum_required (VERSION 3.8)
+
+function(read_shader_file path out)
+    if(NOT EXISTS "${path}")
+        message(FATAL_ERROR "Cannot open shader file ${path}")
+    endif()
+
+    # Byte order mark is replaced with spaces
+    file(READ "${path}" header LIMIT 3 HEX)
+    if(header STREQUAL "efbbbf")
+        file(READ "${path}" code OFFSET 3)
+        set(code "   ${code}")
+    else()
+        file(READ "${path}" code)
+    endif()
+    string(REPLACE "\r" "" code "${code}")
+
+    string(FIND "${code}" "#include " pos)
+    while(NOT pos EQUAL -1)
+        string(SUBSTRING "${code}" ${pos} -1 tail)
+        string(FIND "${tail}" "<" p1)
+        string(FIND "${tail}" ">" p2)
+        if(p1 EQUAL -1 OR p2 EQUAL -1 OR p2 LESS_EQUAL p1)
+            message(FATAL_ERROR "Error while loading shader program ${path}")
+        endif()
+
+        math(EXPR nameStart "${p1} + 1")
+        math(EXPR nameLength "${p2} - ${p1} - 1")
+        math(EXPR restStart "${p2} + 1")
+        string(SUBSTRING "${tail}" ${nameStart} ${nameLength} name)
+        string(SUBSTRING "${tail}" ${restStart} -1 rest)
+        string(SUBSTRING "${code}" 0 ${pos} head)
+
+        read_shader_file("${SHADER_FOLDER}/${name}" include)
+        set(code "${head}${include}${rest}")
+        string(FIND "${code}" "#include " pos)
+    endwhile()
+
+    set(${out} "${code}" PARENT_SCOPE)
+endfunction()
+
+read_shader_file("${INPUT}" code)
+file(WRITE "${OUTPUT}" "${code}")
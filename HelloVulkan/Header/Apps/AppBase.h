@@ -6,6 +6,7 @@
 #include "ResourcesShared.h"
 #include "ResourcesIBL.h"
 #include "PipelineBase.h"
+#include "PipelineHotReload.h"
 #include "FrameCounter.h"
 #include "Camera.h"
 #include "UIData.h"
@@ -15,6 +16,11 @@
 
 #include <memory>
 #include <type_traits>
+#include <future>
+#include <functional>
+#include <tuple>
+
+class Scene;
 
 class AppBase
 {
@@ -30,6 +36,9 @@ protected:
 	void OnWindowResized();
 	void DrawFrame();
 
+	// Publishes the models that a Scene loaded in the background, call it before DrawFrame()
+	void UpdateScene(Scene* scene);
+
 	// GLFW callbacks
 	void FrameBufferSizeCallback(GLFWwindow* window, int width, int height);
 	void MouseCallback(GLFWwindow* window, double xpos, double ypos);
@@ -42,6 +51,7 @@ protected:
 	void InitGLSLang();
 	void InitGLFW();
 	void InitCamera();
+	void InitShaderHotReload();
 	
 	// Functions related to the main loop
 	bool StillRunning();
@@ -67,6 +77,32 @@ protected:
 		return ptr;
 	}
 
+	// Constructs the pipeline on a worker thread so shader compilation and pipeline creation
+	// of independent pipelines overlap. Lvalue arguments are kept as references and must outlive
+	// WaitForPipelines(), which also writes the created pipeline to outPtr.
+	template<class T, class... U>
+	requires (std::is_base_of_v<PipelineBase, T>)
+	void AddPipelineAsync(T** outPtr, U&&... u)
+	{
+		// Reserve the slot so the render order matches the order of the calls
+		const size_t index = pipelines_.size();
+		pipelines_.emplace_back(nullptr);
+
+		auto task = [args = std::tuple<U...>(std::forward<U>(u)...)]() mutable -> std::unique_ptr<PipelineBase>
+		{
+			return std::apply([](auto&&... a) { return std::make_unique<T>(std::forward<decltype(a)>(a)...); }, std::move(args));
+		};
+		pendingPipelines_.push_back(
+		{
+			.index_ = index,
+			.future_ = std::async(std::launch::async, std::move(task)),
+			.setPtr_ = [outPtr](PipelineBase* pipeline) { if (outPtr) { *outPtr = static_cast<T*>(pipeline); } }
+		});
+	}
+
+	// Blocks until every pipeline added with AddPipelineAsync() is created
+	void WaitForPipelines();
+
 	template<class T, class... U>
 	requires (std::is_base_of_v<ResourcesBase, T>)
 	T* AddResources(U&&... u)
@@ -94,6 +130,18 @@ protected:
 	// A list of pipelines (graphics, compute, or raytracing)
 	std::vector<std::unique_ptr<PipelineBase>> pipelines_{};
 
+	// Pipelines that are still being created on worker threads
+	struct PendingPipeline
+	{
+		size_t index_{};
+		std::future<std::unique_ptr<PipelineBase>> future_{};
+		std::function<void(PipelineBase*)> setPtr_{};
+	};
+	std::vector<PendingPipeline> pendingPipelines_{};
+
+	// Declared after pipelines_ so it is stopped before they are destroyed
+	PipelineHotReload pipelineHotReload_{};
+
 	// A list of resources containing buffers and images
 	std::vector<std::unique_ptr<ResourcesBase>> resources_{};
 
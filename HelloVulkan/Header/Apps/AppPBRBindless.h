@@ -9,6 +9,7 @@
 #include "PipelineLightRender.h"
 
 #include <memory>
+#include <vector>
 
 /*
 Demo for bindless textures
@@ -23,6 +24,8 @@ public:
 
 	void Init();
 	void InitLights();
+	void UpdateInstanceUI();
+	void SortDrawsIfCameraMoved();
 
 private:
 	PipelinePBRBindless* pbrPtr_{};
@@ -31,6 +34,9 @@ private:
 
 	std::unique_ptr<Scene> scene_{};
 	ResourcesLight* resourcesLight_{};
+	std::vector<uint32_t> addedInstances_{}; // perModelInstanceIndex of the added Tachikomas
+	glm::vec3 drawSortPosition_{};
+	bool drawsSorted_ = false;
 };
 
 #endif
\ No newline at end of file
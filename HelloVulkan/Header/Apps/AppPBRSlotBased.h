@@ -3,6 +3,7 @@
 
 #include "AppBase.h"
 #include "Model.h"
+#include "DefaultTextures.h"
 #include "PipelineImGui.h"
 #include "ResourcesLight.h"
 
@@ -27,6 +28,7 @@ private:
 	PipelineImGui* imguiPtr_{};
 	ResourcesLight* resourcesLights_{};
 	std::unique_ptr<Model> model_{};
+	DefaultTextures defaultTextures_{};
 };
 
 #endif
\ No newline at end of file
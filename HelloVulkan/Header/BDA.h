@@ -8,8 +8,10 @@ struct BDA
 {
 	uint64_t vertexBufferAddress;
 	uint64_t indexBufferAddress;
-	uint64_t meshDataBufferAddress; // Per-mesh material
-	uint64_t _pad;
+	uint64_t meshDataBufferAddress; // Per draw
+	uint64_t materialDataBufferAddress; // Shared materials, see MeshData::materialIndex_
+	uint64_t instanceIndexBufferAddress; // Draw slots of instanced draws, zero if Scene::EnableInstancedDraws() is not called
+	uint64_t _pad; // The uniform block is a multiple of 16 bytes
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,143 @@
+#ifndef BOUNDING_VOLUME_HIERARCHY
+#define BOUNDING_VOLUME_HIERARCHY
+
+#include "BoundingBox.h"
+#include "Ray.h"
+
+#include "glm/glm.hpp"
+
+#include <array>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+struct BVHNode
+{
+	glm::vec3 min_{};
+	uint32_t leftFirst_ = 0; // Index of the left child, or the first primitive of a leaf
+	glm::vec3 max_{};
+	uint32_t primitiveCount_ = 0; // Zero for an interior node
+};
+
+/*
+Binary BVH over the bounding boxes of primitives, built with the surface area heuristic.
+Nodes are stored depth first so children always come after their parent and the right child
+is next to the left one. Refit() keeps the tree and only recomputes the bounds, which is fine
+as long as the primitives move a little.
+*/
+class BVH
+{
+public:
+	void Build(std::span<const BoundingBox> primitiveBoxes);
+	void Refit(std::span<const BoundingBox> primitiveBoxes);
+
+	[[nodiscard]] bool IsEmpty() const { return nodes_.empty(); }
+
+	/*Finds the closest primitive hit by the ray, nodes further than the closest hit are skipped.
+	hitPrimitive is bool(uint32_t primitiveIndex, float& t), returns true and t if the primitive is hit.
+	closestT is the maximum distance on input*/
+	template<typename HitFunction>
+	bool Traverse(const Ray& ray, float& closestT, uint32_t& closestPrimitive, HitFunction&& hitPrimitive) const;
+
+private:
+	void UpdateNodeBounds(uint32_t nodeIndex, std::span<const BoundingBox> primitiveBoxes);
+	void Subdivide(uint32_t nodeIndex, std::span<const BoundingBox> primitiveBoxes, std::span<const glm::vec3> centroids);
+
+	// Distance to the box along the ray, infinity if the box is missed or further than closestT
+	[[nodiscard]] static float IntersectNode(const Ray& ray, const BVHNode& node, float closestT);
+
+	std::vector<BVHNode> nodes_{};
+	std::vector<uint32_t> primitiveIndices_{};
+};
+
+template<typename HitFunction>
+bool BVH::Traverse(const Ray& ray, float& closestT, uint32_t& closestPrimitive, HitFunction&& hitPrimitive) const
+{
+	constexpr float noHit = std::numeric_limits<float>::infinity();
+	if (nodes_.empty() || IntersectNode(ray, nodes_[0], closestT) == noHit)
+	{
+		return false;
+	}
+
+	// Degenerate trees can be deeper than the array, the rest of the stack goes to overflowStack
+	bool hit = false;
+	std::array<uint32_t, 64> stack{};
+	uint32_t stackSize = 0;
+	std::vector<uint32_t> overflowStack{};
+	uint32_t nodeIndex = 0;
+	while (true)
+	{
+		const BVHNode& node = nodes_[nodeIndex];
+		if (node.primitiveCount_ > 0)
+		{
+			for (uint32_t i = 0; i < node.primitiveCount_; ++i)
+			{
+				const uint32_t primitiveIndex = primitiveIndices_[node.leftFirst_ + i];
+				float t = noHit;
+				if (hitPrimitive(primitiveIndex, t) && t < closestT)
+				{
+					closestT = t;
+					closestPrimitive = primitiveIndex;
+					hit = true;
+				}
+			}
+		}
+		else
+		{
+			// Visit the closer child first, the other one is pushed if it is hit
+			uint32_t nearChild = node.leftFirst_;
+			uint32_t farChild = node.leftFirst_ + 1;
+			float nearT = IntersectNode(ray, nodes_[nearChild], closestT);
+			float farT = IntersectNode(ray, nodes_[farChild], closestT);
+			if (farT < nearT)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearT, farT);
+			}
+			if (nearT != noHit)
+			{
+				if (farT != noHit)
+				{
+					if (stackSize < stack.size())
+					{
+						stack[stackSize++] = farChild;
+					}
+					else
+					{
+						overflowStack.push_back(farChild);
+					}
+				}
+				nodeIndex = nearChild;
+				continue;
+			}
+		}
+
+		// Pop nodes that are still closer than the closest hit, overflowStack holds the top of the stack
+		bool found = false;
+		while (stackSize > 0 || !overflowStack.empty())
+		{
+			if (!overflowStack.empty())
+			{
+				nodeIndex = overflowStack.back();
+				overflowStack.pop_back();
+			}
+			else
+			{
+				nodeIndex = stack[--stackSize];
+			}
+			if (IntersectNode(ray, nodes_[nodeIndex], closestT) != noHit)
+			{
+				found = true;
+				break;
+			}
+		}
+		if (!found)
+		{
+			break;
+		}
+	}
+	return hit;
+}
+
+#endif
\ No newline at end of file
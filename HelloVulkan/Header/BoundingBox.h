@@ -27,7 +27,7 @@ public:
 	void Transform(const glm::mat4& t);
 	[[nodiscard]] BoundingBox GetTransformed(const glm::mat4& t) const;
 
-	bool Hit(const Ray& r, float &t);
+	bool Hit(const Ray& r, float &t) const;
 };
 
 #endif
\ No newline at end of file
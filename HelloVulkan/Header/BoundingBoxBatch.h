@@ -0,0 +1,43 @@
+#ifndef BOUNDING_BOX_BATCH
+#define BOUNDING_BOX_BATCH
+
+#include "BoundingBox.h"
+
+#include "glm/glm.hpp"
+
+#include <span>
+#include <vector>
+
+/*
+Object space bounding boxes stored as structure of arrays in center-extent form.
+
+Transform() uses the center-extent formulation, the center is transformed as a point and the
+extent by the absolute value of the upper 3x3 matrix, which gives the same box as transforming
+the eight corners. Four boxes are transformed at once with SSE and written as BoundingBox.
+*/
+class BoundingBoxBatch
+{
+public:
+	void Resize(size_t count);
+	void Set(size_t index, const BoundingBox& box);
+
+	[[nodiscard]] size_t GetCount() const { return centerX_.size(); }
+
+	/*Transforms the boxes of boxIndices by the same matrix and writes them to output[boxIndex].
+	mappedOutput is optional and receives the same boxes, it is meant for a mapped buffer so it is never read*/
+	void Transform(
+		std::span<const uint32_t> boxIndices,
+		const glm::mat4& matrix,
+		BoundingBox* output,
+		BoundingBox* mappedOutput = nullptr) const;
+
+private:
+	std::vector<float> centerX_{};
+	std::vector<float> centerY_{};
+	std::vector<float> centerZ_{};
+	std::vector<float> extentX_{};
+	std::vector<float> extentY_{};
+	std::vector<float> extentZ_{};
+};
+
+#endif
@@ -20,6 +20,14 @@ namespace AppConfig
 
 	constexpr uint32_t MaxSkinningBone = 4;
 	constexpr uint32_t MaxSkinningMatrices = 100; // Per model
+
+	// Bindless textures reserved by a scene that is loaded in the background, the descriptor layout cannot grow
+	constexpr uint32_t SceneTextureCapacity = 512;
+
+	// Texture streaming, see TextureStreamer
+	constexpr VkDeviceSize TextureStreamingBudget = 256ull * 1024ull * 1024ull; // Bytes of resident mip levels
+	constexpr uint32_t TextureStreamingInitialSize = 64; // Largest resident mip of a texture when it is added
+	constexpr uint32_t TextureStreamingUploadsPerFrame = 2;
 	
 	const std::string ScreenTitle = "Hello Vulkan";
 
@@ -28,6 +36,29 @@ namespace AppConfig
 	const std::string ModelFolder = "C:/Users/azer/workspace/HelloVulkan/Assets/Models/";
 	const std::string TextureFolder = "C:/Users/azer/workspace/HelloVulkan/Assets/Textures/";
 	const std::string FontFolder = "C:/Users/azer/workspace/HelloVulkan/Assets/Fonts/";
+
+	// Compiled SPIR-V is stored here so shaders are not recompiled on every launch
+	constexpr bool UseShaderCache = true;
+	const std::string ShaderCacheFolder = "C:/Users/azer/workspace/HelloVulkan/Cache/Shaders/";
+
+	// Shaders compiled by the HelloVulkanShaders CMake target, used when the source has not changed since the build
+	constexpr bool UsePrecompiledShaders = true;
+	const std::string PrecompiledShaderFolder = "C:/Users/azer/workspace/HelloVulkan/bin/Shaders/";
+
+	// Recreate pipelines when a shader file changes while the app is running
+	constexpr bool ShaderHotReload = true;
+
+	// VkPipelineCache is loaded at startup and saved on shutdown
+	const std::string PipelineCacheFile = "C:/Users/azer/workspace/HelloVulkan/Cache/PipelineCache.bin";
+
+	// Generate mipmaps with one compute dispatch instead of one blit per mip level, when the image allows it
+	constexpr bool UseComputeMipmap = true;
+
+	// Radiance HDR files are decoded to half floats on multiple threads instead of 32-bit floats by stb_image,
+	// the decoded image is stored in the cache folder
+	constexpr bool UseHalfFloatHDR = true;
+	constexpr bool UseHDRCache = true;
+	const std::string HDRCacheFolder = "C:/Users/azer/workspace/HelloVulkan/Cache/HDR/";
 };
 
 namespace CameraConfig
@@ -62,13 +93,33 @@ namespace IBLConfig
 	constexpr uint32_t OutputDiffuseSideLength = 32;
 	constexpr uint32_t OutputSpecularSideLength = 128;
 	constexpr uint32_t LayerCount = 6;
-	constexpr VkFormat CubeFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+	// Half floats are enough for the cubemaps and halve their memory and bandwidth,
+	// VK_FORMAT_B10G11R11_UFLOAT_PACK32 halves it again but drops the alpha channel.
+	// The device must support rendering, blitting and storage writes, otherwise FallbackCubeFormat is used
+	constexpr VkFormat CubeFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+	constexpr VkFormat FallbackCubeFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+	// Cubemaps in the cache are only sampled after loading so they can use a shared exponent format.
+	// Set to VK_FORMAT_UNDEFINED to store them in CubeFormat
+	constexpr VkFormat CachedCubeFormat = VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+
+	// Compute filtering reads from the input cubemap mips so it needs far fewer samples
+	constexpr bool UseComputeFilter = true;
+	constexpr uint32_t ComputeDiffuseSampleCount = 256;
+	constexpr uint32_t ComputeSpecularSampleCount = 256;
+
+	// Diffuse irradiance as 9 spherical harmonics coefficients instead of sampling the diffuse cubemap
+	constexpr bool UseSHIrradiance = true;
+	constexpr uint32_t SHSampleSideLength = 64; // The input cubemap mip level with this size is projected
+
+	// Precomputed images are stored here, keyed by the HDR file content and the settings above
+	constexpr bool UseCache = true;
+	const std::string CacheFolder = "C:/Users/azer/workspace/HelloVulkan/Cache/IBL/";
 
 	// BRDF LUT
 	constexpr uint32_t LUTSampleCount = 1024;
 	constexpr uint32_t LUTWidth = 256;
 	constexpr uint32_t LUTHeight = 256;
-	constexpr uint32_t LUTBufferSize = 2 * sizeof(float) * LUTWidth * LUTHeight;
+	constexpr VkFormat LUTFormat = VK_FORMAT_R16G16_SFLOAT; // Must match the image format in BRDFLUT.comp
 }
 
 namespace ShadowConfig
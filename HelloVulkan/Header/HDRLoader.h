@@ -0,0 +1,50 @@
+#ifndef HDR_LOADER
+#define HDR_LOADER
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+Loads a Radiance HDR file (.hdr) as RGBA half floats, flipped vertically like stbi_loadf().
+Open() reads the header and finds where every scanline starts, then Load() decodes
+the scanlines on multiple threads straight into the output, so no float copy of the image is needed.
+The result is stored in AppConfig::HDRCacheFolder, a cached file is copied to the output as is.
+Before the cache is written the image is decoded to host memory, the output may be slow to read.
+Only new style RLE files with the -Y +X orientation are supported, Open() returns false otherwise.
+*/
+class HDRLoader
+{
+public:
+	static constexpr uint32_t BytesPerPixel = 4 * sizeof(uint16_t);
+
+	[[nodiscard]] bool Open(const std::string& filename);
+
+	[[nodiscard]] uint32_t GetWidth() const { return width_; }
+	[[nodiscard]] uint32_t GetHeight() const { return height_; }
+	[[nodiscard]] size_t GetDataSize() const { return static_cast<size_t>(width_) * height_ * BytesPerPixel; }
+
+	// The output has to hold GetDataSize() bytes, for example a mapped staging buffer
+	[[nodiscard]] bool Load(void* output);
+
+private:
+	std::string filename_{};
+	std::string cacheFile_{};
+	bool cached_ = false;
+	uint32_t width_ = 0;
+	uint32_t height_ = 0;
+
+	std::vector<uint8_t> fileData_{};
+	std::vector<size_t> scanlineOffsets_{};
+
+	[[nodiscard]] bool OpenFile();
+	[[nodiscard]] bool OpenCache();
+	[[nodiscard]] bool LoadCache(void* output);
+	void SaveCache(const void* data) const;
+
+	[[nodiscard]] bool ReadHeader(size_t& offset);
+	[[nodiscard]] bool FindScanlines(size_t offset);
+	void DecodeScanline(uint32_t scanline, uint8_t* rgbe, uint64_t* output) const;
+};
+
+#endif
\ No newline at end of file
@@ -4,10 +4,9 @@
 #include "PipelineBase.h"
 #include "VulkanContext.h"
 #include "VulkanImage.h"
-#include "VulkanBuffer.h"
 
 /*
-Compute pipeline to generate lookup table
+Compute pipeline to generate lookup table, the shader writes directly to a two channel storage image
 */
 class PipelineBRDFLUT final : PipelineBase
 {
@@ -18,14 +17,13 @@ public:
 	void SetCameraUBO(VulkanContext& ctx, CameraUBO& ubo) override {}
 	void FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer) override;
 	void CreateLUT(VulkanContext& ctx, VulkanImage* outputLUT);
-	void Execute(VulkanContext& ctx);
+	void Execute(VulkanContext& ctx, VulkanImage* outputLUT);
 
 private:
-	VulkanBuffer outBuffer_{}; // This is the lookup table which has to be transferred to an image
 	VkDescriptorSet descriptorSet_{};
 
 private:
-	void CreateDescriptor(VulkanContext& ctx);
+	void CreateDescriptorLayout(VulkanContext& ctx);
 };
 
 #endif
\ No newline at end of file
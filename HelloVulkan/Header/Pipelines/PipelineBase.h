@@ -12,6 +12,8 @@
 #include "UBOs.h"
 
 #include <string>
+#include <vector>
+#include <unordered_set>
 
 /*
 This mainly encapsulates a graphics pipeline, framebuffers, and a render pass.
@@ -41,12 +43,29 @@ public:
 	{
 	}
 
+	// A scene loaded in the background replaced its buffers or textures, see Scene::Update()
+	virtual void OnSceneUpdated(VulkanContext& ctx)
+	{
+	}
+
 	virtual void SetCameraUBO(VulkanContext& ctx, CameraUBO& ubo)
 	{
 		const uint32_t frameIndex = ctx.GetFrameIndex();
 		cameraUBOBuffers_[frameIndex].UploadBufferData(ctx, &ubo, sizeof(CameraUBO));
 	}
 
+	// Shader hot reload, a new VkPipeline that replaces *target_ at a frame boundary
+	struct ReloadedPipeline
+	{
+		VkPipeline* target_{};
+		VkPipeline pipeline_{};
+	};
+
+	// Called from the hot reload thread, a shader that fails to compile is skipped
+	[[nodiscard]] std::vector<ReloadedPipeline> RecreatePipelines(
+		VulkanContext& ctx,
+		const std::unordered_set<std::string>& changedShaders);
+
 protected:
 	VkDevice device_{};
 	PipelineConfig config_{};
@@ -64,6 +83,16 @@ protected:
 	// Multiple render target
 	std::vector<VkPipelineColorBlendAttachmentState> overridingColorBlendAttachments{};
 
+	// Everything needed to create a pipeline again when one of its shaders changes
+	struct ShaderReloadInfo
+	{
+		std::vector<std::string> shaderFiles_{};
+		VkRenderPass renderPass_{}; // Null for compute
+		VkPipelineLayout pipelineLayout_{};
+		VkPipeline* pipeline_{};
+	};
+	std::vector<ShaderReloadInfo> shaderReloadInfos_{};
+
 protected:
 	bool IsOffscreen() const
 	{
@@ -92,6 +121,20 @@ protected:
 	void CreateComputePipeline(
 		VulkanContext& ctx,
 		const std::string& shaderFile);
+
+private:
+	[[nodiscard]] VkResult BuildGraphicsPipeline(
+		VulkanContext& ctx,
+		VkRenderPass renderPass,
+		VkPipelineLayout pipelineLayout,
+		const std::vector<std::string>& shaderFiles,
+		VkPipeline* pipeline);
+
+	[[nodiscard]] VkResult BuildComputePipeline(
+		VulkanContext& ctx,
+		VkPipelineLayout pipelineLayout,
+		const std::string& shaderFile,
+		VkPipeline* pipeline);
 };
 
 #endif
\ No newline at end of file
@@ -35,6 +35,7 @@ private:
 
 	VkDescriptorSet descriptorSet_{ VK_NULL_HANDLE };
 	VkSampler inputCubemapSampler_{ VK_NULL_HANDLE }; // A sampler for the input cubemap
+	VkFormat cubeFormat_{ VK_FORMAT_UNDEFINED }; // Output cubemaps use the format of the input cubemap
 
 	// Two pipelines for each of diffuse and specular maps
 	std::vector<VkPipeline> graphicsPipelines_{};
@@ -0,0 +1,47 @@
+#ifndef PIPELINE_CUBE_FILTER_COMPUTE
+#define PIPELINE_CUBE_FILTER_COMPUTE
+
+#include "PipelineBase.h"
+#include "PipelineCubeFilter.h"
+
+#include <vector>
+
+class VulkanImage;
+
+/*
+Compute version of PipelineCubeFilter.
+All six faces of a mip level are written by one dispatch through a storage image view,
+so the specular map only needs one dispatch per mip level and no framebuffers.
+*/
+class PipelineCubeFilterCompute final : public PipelineBase
+{
+public:
+	PipelineCubeFilterCompute(VulkanContext& ctx, VulkanImage* inputCubemap);
+	~PipelineCubeFilterCompute();
+
+	void Execute(VulkanContext& ctx,
+		VulkanImage* outputCubemap,
+		CubeFilterType filterType);
+
+	void SetCameraUBO(VulkanContext& ctx, CameraUBO& ubo) override {}
+	void FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer) override;
+
+private:
+	VkSampler inputCubemapSampler_{ VK_NULL_HANDLE }; // A sampler for the input cubemap with all mip levels
+	VkDescriptorImageInfo inputImageInfo_{};
+	VkFormat cubeFormat_{ VK_FORMAT_UNDEFINED }; // Output cubemaps use the format of the input cubemap
+
+	void CreateDescriptorLayout(VulkanContext& ctx);
+
+	void InitializeOutputCubemap(VulkanContext& ctx,
+		VulkanImage* outputCubemap,
+		uint32_t numMipmap,
+		uint32_t outputSideLength);
+
+	// One 2D array view with six layers per mip level
+	void CreateOutputMipViews(VulkanContext& ctx,
+		VulkanImage* outputCubemap,
+		std::vector<VkImageView>& outputMipViews);
+};
+
+#endif
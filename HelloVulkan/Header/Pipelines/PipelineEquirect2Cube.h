@@ -12,7 +12,7 @@ Offscreen pipeline to generate a cubemap from an HDR image
 class PipelineEquirect2Cube final : public PipelineBase
 {
 public:
-	PipelineEquirect2Cube(VulkanContext& ctx, const std::string& hdrFile);
+	PipelineEquirect2Cube(VulkanContext& ctx, const std::string& hdrFile, VkFormat cubeFormat);
 	~PipelineEquirect2Cube();
 
 	void OffscreenRender(VulkanContext& ctx, VulkanImage* outputCubemap);
@@ -24,6 +24,7 @@ private:
 	VkDescriptorSet descriptorSet_{ VK_NULL_HANDLE };
 	VkFramebuffer cubeFramebuffer_{ VK_NULL_HANDLE };
 	VulkanImage inputHDRImage_{};
+	VkFormat cubeFormat_{ VK_FORMAT_UNDEFINED };
 
 private:
 	void InitializeHDRImage(VulkanContext& ctx, const std::string& hdrFile);
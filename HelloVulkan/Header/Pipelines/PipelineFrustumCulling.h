@@ -3,9 +3,14 @@
 
 #include "PipelineBase.h"
 #include "VulkanContext.h"
+#include "VulkanDescriptorSetInfo.h"
 #include "Scene.h"
 #include "Configs.h"
 
+/*
+Sets instanceCount of the indirect commands of a scene to zero or one, or for instanced draws
+compacts the visible draw slots of each mesh and counts them, see Scene::EnableInstancedDraws()
+*/
 class PipelineFrustumCulling final : public PipelineBase
 {
 public:
@@ -14,6 +19,7 @@ public:
 
 	void SetCameraUBO(VulkanContext& ctx, CameraUBO& ubo) override {}
 	void FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer) override;
+	void OnSceneUpdated(VulkanContext& ctx) override;
 
 	void SetFrustumUBO(VulkanContext& ctx, FrustumUBO& ubo)
 	{
@@ -25,11 +31,13 @@ private:
 	void Execute(VulkanContext& ctx, VkCommandBuffer commandBuffer, uint32_t frameIndex);
 
 	void CreateDescriptor(VulkanContext& ctx);
+	void UpdateDescriptorSets(VulkanContext& ctx);
 
 private:
 	Scene* scene_{};
 	std::vector<VulkanBuffer> frustumBuffers_{};
 	std::array<VkDescriptorSet, AppConfig::FrameCount> descriptorSets_{};
+	VulkanDescriptorSetInfo descriptorSetInfo_{};
 };
 
 #endif
\ No newline at end of file
@@ -16,14 +16,27 @@ public:
 
 	void FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer) override;
 
+	// GPU picking reads the instance ID of the clicked pixel when the frame index comes back
+	void UpdateFromUIData(VulkanContext& ctx, UIData& uiData) override;
+
 private:
 	void CreateBDABuffer(VulkanContext& ctx);
 	void CreateDescriptor(VulkanContext& ctx);
+	void CreatePickBuffers(VulkanContext& ctx);
+	void CopyPickedTexel(VulkanContext& ctx, VkCommandBuffer commandBuffer);
+	void ReadPickedInstance(VulkanContext& ctx, UIData& uiData);
 
 	Scene* scene_{};
 	ResourcesGBuffer* resourcesGBuffer_{};
 	VulkanBuffer bdaBuffer_{};
 	std::array<VkDescriptorSet, AppConfig::FrameCount> descriptorSets_{};
+
+	// Picking, one host visible texel per frame in flight
+	std::array<VulkanBuffer, AppConfig::FrameCount> pickBuffers_{};
+	std::array<bool, AppConfig::FrameCount> pickSubmitted_{};
+	bool pickRequested_ = false;
+	uint32_t pickX_ = 0;
+	uint32_t pickY_ = 0;
 };
 
 #endif
\ No newline at end of file
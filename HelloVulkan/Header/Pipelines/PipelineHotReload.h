@@ -0,0 +1,58 @@
+#ifndef PIPELINE_HOT_RELOAD
+#define PIPELINE_HOT_RELOAD
+
+#include "PipelineBase.h"
+#include "VulkanContext.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <filesystem>
+#include <unordered_map>
+
+/*
+Watches the shader folder on a background thread. When a shader or an include file changes,
+only the pipelines using it are recreated on that thread, then ApplyChanges() swaps
+the new VkPipeline objects in at a frame boundary.
+*/
+class PipelineHotReload
+{
+public:
+	PipelineHotReload() = default;
+	~PipelineHotReload();
+
+	// Not copyable or movable
+	PipelineHotReload(const PipelineHotReload&) = delete;
+	PipelineHotReload& operator=(const PipelineHotReload&) = delete;
+	PipelineHotReload(PipelineHotReload&&) = delete;
+	PipelineHotReload& operator=(PipelineHotReload&&) = delete;
+
+	// Pipelines must outlive the watcher, call Stop() before destroying them
+	void Start(VulkanContext& ctx, const std::vector<std::unique_ptr<PipelineBase>>& pipelines);
+	void Stop();
+
+	// Called from the main thread before recording a frame
+	void ApplyChanges(VulkanContext& ctx);
+
+private:
+	void Watch(const std::stop_token& stopToken);
+	[[nodiscard]] std::unordered_map<std::string, std::filesystem::file_time_type> GetFileTimes() const;
+
+private:
+	static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(500);
+
+	VulkanContext* ctx_{};
+	std::vector<PipelineBase*> pipelines_{};
+
+	std::jthread thread_{};
+	std::mutex mutex_{};
+	std::condition_variable_any condition_{};
+
+	// Created by the watcher thread, not yet swapped in
+	std::vector<PipelineBase::ReloadedPipeline> reloadedPipelines_{};
+};
+
+#endif
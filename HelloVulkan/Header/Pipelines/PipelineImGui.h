@@ -31,6 +31,7 @@ public:
 	void ImGuizmoShow(glm::mat4& modelMatrix, const int editMode);
 	void ImGuizmoShowOption(int* editMode);
 	void ImGuizmoManipulateScene(VulkanContext& ctx, UIData* uiData);
+	void ImGuizmoShowHovered(const BoundingBox& box);
 
 	void SetCameraUBO(VulkanContext& ctx, CameraUBO& ubo) override {}
 	void FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer) override;
@@ -28,6 +28,7 @@ public:
 	 void SetPBRPushConstants(const PushConstPBR& pbrPC) { pc_ = pbrPC; };
 
 	void FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer) override;
+	void OnSceneUpdated(VulkanContext& ctx) override;
 	
 	void UpdateFromUIData(VulkanContext& ctx, UIData& uiData) override
 	{
@@ -36,7 +37,9 @@ public:
 
 private:
 	void CreateBDABuffer(VulkanContext& ctx);
+	void CreateSpecializationConstants();
 	void CreateDescriptor(VulkanContext& ctx);
+	void UpdateDescriptorSets(VulkanContext& ctx);
 
 	bool useSkinning_;
 	Scene* scene_;
@@ -44,7 +47,16 @@ private:
 	ResourcesIBL* resourcesIBL_;
 	PushConstPBR pc_;
 	VulkanBuffer bdaBuffer_;
-	std::vector<VkDescriptorSet> descriptorSets_;
+	VulkanBuffer feedbackPlaceholderBuffer_;
+	// Specialization constants
+	struct SpecializationData
+	{
+		uint32_t textureFeedback_; // Fragment shader
+		uint32_t instancedDraws_; // Vertex shader
+	};
+	SpecializationData specializationData_{};
+	std::array<VkDescriptorSet, AppConfig::FrameCount> descriptorSets_;
+	VulkanDescriptorSetInfo descriptorSetInfo_;
 };
 
 #endif
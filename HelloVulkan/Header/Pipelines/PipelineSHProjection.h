@@ -0,0 +1,46 @@
+#ifndef PIPELINE_SH_PROJECTION
+#define PIPELINE_SH_PROJECTION
+
+#include "PipelineBase.h"
+#include "VulkanBuffer.h"
+#include "PushConstants.h"
+
+class VulkanImage;
+
+/*
+Compute pipeline that projects the environment cubemap into 9 spherical harmonics coefficients.
+The coefficients replace the diffuse cubemap lookup in PBR/Ambient.glsl, the diffuse cubemap
+is still written from them so it can be displayed and bound by the PBR pipelines.
+*/
+class PipelineSHProjection final : public PipelineBase
+{
+public:
+	// The input cubemap should already be mipmapped, the output buffer holds a SHIrradianceUBO
+	PipelineSHProjection(VulkanContext& ctx, VulkanImage* inputCubemap, VulkanBuffer* outputBuffer);
+	~PipelineSHProjection();
+
+	void Execute(VulkanContext& ctx, VulkanImage* outputDiffuseCubemap);
+
+	void SetCameraUBO(VulkanContext& ctx, CameraUBO& ubo) override {}
+	void FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer) override;
+
+private:
+	VkSampler inputCubemapSampler_{ VK_NULL_HANDLE };
+	VkDescriptorImageInfo inputImageInfo_{};
+	VkFormat cubeFormat_{ VK_FORMAT_UNDEFINED }; // The diffuse cubemap uses the format of the input cubemap
+	VulkanBuffer* outputBuffer_{};
+	VulkanBuffer partialBuffer_{}; // Written by the first pass, one partial sum per workgroup
+
+	uint32_t sampleSideLength_{ 0 };
+	float sampleMipLevel_{ 0.f };
+	uint32_t groupCountPerSide_{ 0 };
+
+	void CreateDescriptorLayout(VulkanContext& ctx);
+
+	void InitializeOutputCubemap(VulkanContext& ctx, VulkanImage* outputCubemap);
+
+	void Dispatch(VkCommandBuffer commandBuffer, const PushConstSHProjection& pc, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+	static void ComputeToComputeBarrier(VkCommandBuffer commandBuffer);
+};
+
+#endif
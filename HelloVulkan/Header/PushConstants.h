@@ -18,6 +18,31 @@ struct PushConstCubeFilter
 	uint32_t outputDiffuseSampleCount = 1u;
 };
 
+// For generating specular and diffuse maps with a compute shader
+struct PushConstCubeFilterCompute
+{
+	float roughness = 0.f;
+	uint32_t sampleCount = 1u;
+	uint32_t filterType = 0u;
+};
+
+// For projecting a cubemap into spherical harmonics
+struct PushConstSHProjection
+{
+	uint32_t pass = 0u;
+	uint32_t sampleSideLength = 1u;
+	float sampleMipLevel = 0.f;
+	uint32_t partialCount = 0u;
+};
+
+// For generating all mip levels with one dispatch
+struct PushConstSinglePassDownsample
+{
+	uint32_t mipCount = 0u;
+	uint32_t workGroupCountX = 0u;
+	uint32_t workGroupCountY = 0u;
+};
+
 // Additional customization for PBR
 struct PushConstPBR
 {
@@ -11,7 +11,8 @@
 struct ResourcesGBuffer : ResourcesBase
 {
 public:
-	ResourcesGBuffer();
+	// The instance ID attachment is only needed for GPU picking
+	ResourcesGBuffer(bool useInstanceID = false);
 	~ResourcesGBuffer();
 
 	void Create(VulkanContext& ctx);
@@ -19,6 +20,7 @@ public:
 	void OnWindowResized(VulkanContext& ctx) override;
 
 	float GetNoiseDimension() const;
+	[[nodiscard]] bool UseInstanceID() const { return useInstanceID_; }
 
 	void UpdateFromUIData(VulkanContext& ctx, UIData& uiData) override
 	{
@@ -37,7 +39,11 @@ public:
 	// Needed for depth test
 	VulkanImage depth_;
 
+	// Index of the instance plus one, pixels without an instance keep the clear value
+	VulkanImage instanceID_;
+
 private:
+	bool useInstanceID_ = false;
 	std::vector<glm::vec4> ssaoKernel_{};
 };
 
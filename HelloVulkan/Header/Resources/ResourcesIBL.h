@@ -4,6 +4,9 @@
 #include "VulkanContext.h"
 #include "ResourcesBase.h"
 #include "VulkanImage.h"
+#include "VulkanBuffer.h"
+
+#include <string>
 
 struct ResourcesIBL : ResourcesBase
 {
@@ -15,6 +18,20 @@ public:
 private:
 	void Create(VulkanContext& ctx, const std::string& hdrFile);
 	void SetDebugNames(VulkanContext& ctx);
+	void CreateSHIrradianceBuffer(VulkanContext& ctx);
+
+	// IBLConfig::CubeFormat if the device supports it, otherwise IBLConfig::FallbackCubeFormat.
+	// The shared exponent cache format is only used if the device can sample it
+	void ChooseCubeFormats(VulkanContext& ctx);
+
+	// Disk cache of the precomputed images
+	[[nodiscard]] std::string GetCacheFilePath(const std::string& hdrFile) const;
+	bool LoadFromCache(VulkanContext& ctx, const std::string& cacheFile);
+	void SaveToCache(VulkanContext& ctx, const std::string& cacheFile);
+
+private:
+	VkFormat cubeFormat_{ VK_FORMAT_UNDEFINED };
+	VkFormat cachedCubeFormat_{ VK_FORMAT_UNDEFINED }; // VK_FORMAT_UNDEFINED keeps cubeFormat_
 
 public:
 	float cubemapMipmapCount_ = 0.0f;
@@ -22,6 +39,7 @@ public:
 	VulkanImage diffuseCubemap_{};
 	VulkanImage specularCubemap_{};
 	VulkanImage brdfLut_{};
+	VulkanBuffer shIrradianceBuffer_{}; // SHIrradianceUBO
 };
 
 #endif
\ No newline at end of file
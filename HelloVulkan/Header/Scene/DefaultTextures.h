@@ -0,0 +1,39 @@
+#ifndef DEFAULT_TEXTURES
+#define DEFAULT_TEXTURES
+
+#include "VulkanContext.h"
+#include "VulkanImage.h"
+
+#include <array>
+#include <vector>
+
+// Texture indices below DefaultTextureCount point to these textures
+enum class DefaultTexture : uint32_t
+{
+	Black = 0u,
+	Normal = 1u
+};
+
+constexpr uint32_t DefaultTextureCount = 2u;
+
+/*
+1x1 textures that replace missing PBR textures, shared by every model of a scene.
+They are always the first elements of the bindless texture array.
+*/
+class DefaultTextures
+{
+public:
+	DefaultTextures() = default;
+	~DefaultTextures() = default;
+
+	void Create(VulkanContext& ctx);
+	void Destroy();
+
+	[[nodiscard]] VulkanImage* Get(uint32_t textureIndex) { return &images_[textureIndex]; }
+	[[nodiscard]] std::vector<VkDescriptorImageInfo> GetImageInfos() const;
+
+private:
+	std::array<VulkanImage, DefaultTextureCount> images_{};
+};
+
+#endif
\ No newline at end of file
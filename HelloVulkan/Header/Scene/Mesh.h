@@ -6,6 +6,7 @@
 #include "TextureMapper.h"
 #include "VertexData.h"
 #include "ScenePODs.h"
+#include "DefaultTextures.h"
 
 #include <vector>
 #include <unordered_map>
@@ -33,6 +34,9 @@ private:
 	uint32_t vertexCount_ = 0;
 	uint32_t indexCount_ = 0;
 
+	// Index in Model::nodes_, zero if the mesh is baked into model space
+	uint32_t nodeIndex_ = 0;
+
 public:
 	Mesh() = default;
 	~Mesh() = default;
@@ -61,20 +65,44 @@ public:
 	[[nodiscard]] uint32_t GetIndexCount() const { return indexCount_; }
 	[[nodiscard]] uint32_t GetVertexOffset() const { return vertexOffset_; }
 	[[nodiscard]] uint32_t GetVertexCount() const { return vertexCount_; }
+	[[nodiscard]] uint32_t GetNodeIndex() const { return nodeIndex_; }
+	void SetNodeIndex(uint32_t nodeIndex) { nodeIndex_ = nodeIndex; }
+
+	// textureIndexOffset is the number of textures of the previous models, default textures are not offset.
+	// useDefaultTextures is for a model whose textures are still loading
+	[[nodiscard]] uint32_t GetTextureIndex(TextureType textureType, uint32_t textureIndexOffset, bool useDefaultTextures = false)
+	{
+		if (useDefaultTextures)
+		{
+			return textureType == TextureType::Normal ?
+				static_cast<uint32_t>(DefaultTexture::Normal) :
+				static_cast<uint32_t>(DefaultTexture::Black);
+		}
+		const uint32_t textureIndex = textureIndices_[textureType];
+		return textureIndex < DefaultTextureCount ? textureIndex : textureIndex + textureIndexOffset;
+	}
 
-	[[nodiscard]] MeshData GetMeshData(uint32_t textureIndexOffset, uint32_t modelMatrixIndex)
+	[[nodiscard]] MeshData GetMeshData(uint32_t modelMatrixIndex, uint32_t materialIndex) const
 	{
 		return
 		{
 			.vertexOffset_ = vertexOffset_,
 			.indexOffset_ = indexOffset_,
 			.modelMatrixIndex_ = modelMatrixIndex,
-			.albedo_ = textureIndices_[TextureType::Albedo] + textureIndexOffset,
-			.normal_ = textureIndices_[TextureType::Normal] + textureIndexOffset,
-			.metalness_ = textureIndices_[TextureType::Metalness] + textureIndexOffset,
-			.roughness_ = textureIndices_[TextureType::Roughness] + textureIndexOffset,
-			.ao_ = textureIndices_[TextureType::AmbientOcclusion] + textureIndexOffset,
-			.emissive_ = textureIndices_[TextureType::Emissive] + textureIndexOffset,
+			.materialIndex_ = materialIndex
+		};
+	}
+
+	[[nodiscard]] MaterialData GetMaterialData(uint32_t textureIndexOffset, bool useDefaultTextures = false)
+	{
+		return
+		{
+			.albedo_ = GetTextureIndex(TextureType::Albedo, textureIndexOffset, useDefaultTextures),
+			.normal_ = GetTextureIndex(TextureType::Normal, textureIndexOffset, useDefaultTextures),
+			.metalness_ = GetTextureIndex(TextureType::Metalness, textureIndexOffset, useDefaultTextures),
+			.roughness_ = GetTextureIndex(TextureType::Roughness, textureIndexOffset, useDefaultTextures),
+			.ao_ = GetTextureIndex(TextureType::AmbientOcclusion, textureIndexOffset, useDefaultTextures),
+			.emissive_ = GetTextureIndex(TextureType::Emissive, textureIndexOffset, useDefaultTextures),
 			.material_ = GetMaterialType()
 		};
 	}
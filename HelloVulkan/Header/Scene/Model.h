@@ -5,6 +5,7 @@
 #include "UBOs.h"
 #include "ScenePODs.h"
 #include "TextureMapper.h"
+#include "DefaultTextures.h"
 #include "VulkanContext.h"
 #include "VulkanImage.h"
 
@@ -20,7 +21,12 @@ public:
 	std::string filepath_{};
 	std::vector<Mesh> meshes_{};
 
-	// NOTE Textures are stored in Model regardless of bindless textures or Slot-Based
+	// Breadth-first so parents come before their children, the first node is the root of an instance
+	// and is moved by the model matrix. Without ModelCreateInfo::nodeHierarchy it is the only node
+	std::vector<ModelNode> nodes_{};
+
+	// NOTE Textures are stored in Model regardless of bindless textures or Slot-Based,
+	// missing textures are replaced by DefaultTextures which are not in this list
 	std::vector<VulkanImage> textureList_{};
 
 	// Optional per-frame buffers for model matrix
@@ -36,15 +42,18 @@ public:
 private:
 	const aiScene* scene_{};
 	bool bindlessTexture_ = false;
+	bool deferTextures_ = false;
 	VkDevice device_{};
 	std::string directory_{};
+	DefaultTextures* defaultTextures_{}; // Not owned
 
 	// Skinning
 	int boneCounter_ = 0;
 	bool processAnimation_ = false;
 
-	// string key is the filename, int value points to elements in textureList_
+	// string key is the filename, int value is a texture index, see GetTexture()
 	std::unordered_map<std::string, uint32_t> textureMap_{};
+	std::vector<std::string> textureFilenames_{}; // Same order as textureList_
 
 public:
 	Model() = default;
@@ -52,16 +61,26 @@ public:
 
 	void Destroy();
 
-	void LoadSlotBased(VulkanContext& ctx, const std::string& path);
+	void LoadSlotBased(VulkanContext& ctx, DefaultTextures* defaultTextures, const std::string& path);
+	// If deferTextures is true only the texture indices are assigned,
+	// the images are created later from GetTextureFilePaths() and passed to SetTextures()
 	void LoadBindless(VulkanContext& ctx,
+		DefaultTextures* defaultTextures,
 		const ModelCreateInfo& modelInfo,
-		SceneData& sceneData
+		SceneData& sceneData,
+		bool deferTextures = false
 	);
 
 	[[nodiscard]] const aiScene* GetAssimpScene() const { return scene_; }
+	// Indices below DefaultTextureCount are the default textures,
+	// the rest are elements of textureList_ offset by DefaultTextureCount
 	[[nodiscard]] VulkanImage* GetTexture(uint32_t textureIndex);
-	[[nodiscard]] uint32_t GetTextureCount() const { return static_cast<uint32_t>(textureList_.size()); }
+	[[nodiscard]] uint32_t GetTextureCount() const { return static_cast<uint32_t>(textureFilenames_.size()); }
+	[[nodiscard]] bool TexturesLoaded() const { return textureList_.size() == textureFilenames_.size(); }
+	[[nodiscard]] std::vector<std::string> GetTextureFilePaths() const;
+	void SetTextures(std::vector<VulkanImage>&& textures);
 	[[nodiscard]] uint32_t GetMeshCount() const { return static_cast<uint32_t>(meshes_.size()); }
+	[[nodiscard]] uint32_t GetNodeCount() const { return static_cast<uint32_t>(nodes_.size()); }
 	[[nodiscard]] int GetBoneCounter() const { return boneCounter_; }
 	[[nodiscard]] int ProcessAnimation() const { return processAnimation_; }
 
@@ -69,9 +88,7 @@ public:
 	void SetModelUBO(VulkanContext& ctx, ModelUBO ubo);
 
 private:
-	void CreateDefaultTextures(VulkanContext& ctx);
 	void AddTexture(VulkanContext& ctx, const std::string& textureFilename);
-	void AddTexture(VulkanContext& ctx, const std::string& textureName, void* data, int width, int height);
 	[[nodiscard]] std::unordered_map<TextureType, uint32_t> GetTextureIndices(VulkanContext& ctx, const aiMesh* mesh);
 
 	// Entry point
@@ -88,6 +105,11 @@ private:
 		const aiNode* node,
 		const glm::mat4& parentTransform);
 
+	// Keeps the node transforms, meshes stay in the space of their node
+	void ProcessNodeHierarchy(
+		VulkanContext& ctx,
+		SceneData& sceneData);
+
 	void ProcessMesh(
 		VulkanContext& ctx,
 		SceneData& sceneData,
@@ -4,13 +4,24 @@
 #include "BDA.h"
 #include "UBOs.h"
 #include "Model.h"
+#include "DefaultTextures.h"
+#include "TextureStreamer.h"
 #include "Animation.h"
 #include "Animator.h"
 #include "ScenePODs.h"
 #include "BoundingBox.h"
+#include "BVH.h"
+#include "BoundingBoxBatch.h"
+#include "SceneGraph.h"
 
 #include <vector>
+#include <string>
 #include <span>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <atomic>
 
 /*
 A scene used for indirect draw + bindless resources that contains SSBO buffers for vertices, indices, and mesh data.
@@ -30,22 +41,68 @@ Scene
 
 A scene has multiple models, each model is loaded from a file (fbx, glTF, etc.), and a model has multiple meshes.
 A single mesh requires one draw call. For example, if the scene has 10 meshes, 10 draw calls will be issued.
+Each draw has a MeshData with the geometry offsets, the model matrix, and an index into materialDataArray_,
+the textures and material type of a mesh are stored once no matter how many copies are drawn.
 The scene representation supports instances, each is defined as a copy of a mesh.
 Instances only duplicate the draw call of a mesh, so this is different than hardware instancing.
 
+EnableInstancedDraws() adds a second layout with one draw call per unique mesh, its instanceCount is the
+number of copies. The draw slots of the copies are listed in instanceIndexBuffer_ and the vertex shader reads
+the slot with gl_InstanceIndex, frustum culling compacts the visible slots to the front of each list.
+
+Every model instance has one model matrix per node of the model, see Model::nodes_. The matrices are
+the world transforms of sceneGraph_ so moving a node also moves its children, for example a turret
+on top of a vehicle. Models without ModelCreateInfo::nodeHierarchy only have the root node.
+
+Model instances can be added and removed at runtime. The draws are kept in one range of slots per
+material so the material ranges stay contiguous, each range has room to grow. A removed draw becomes
+a hole that draws nothing and goes to the free list of its range. A range that is full is reallocated
+with twice the capacity, and the ranges are compacted once holes are half of the used slots.
+Matrices of removed instances are reused by the next instance of the same model.
+Changes are applied by Update(), the pipelines refresh their descriptors in OnSceneUpdated() when buffers were recreated.
+A re-sort that keeps the capacities moves the draws inside the existing buffers.
+
+Inside a material range the draws are sorted by a packed key of material, model, mesh, and a depth bucket,
+see SortDraws(). The ranges double as the draw range table so GetOffsetAndDrawCount() does not search.
+
+If loadAsync is true the models are loaded on a background thread, geometry first, then textures.
+The scene starts empty and Update() publishes whatever finished loading, meshes are drawn
+with the default textures until their own textures arrive. Scenes with animation are loaded synchronously.
 */
 class Scene
 {
 public:
-	Scene(VulkanContext& ctx, const std::span<ModelCreateInfo> modelInfoArray);
+	Scene(VulkanContext& ctx, const std::span<ModelCreateInfo> modelInfoArray, bool loadAsync = false);
 	~Scene();
 
+	// Call between frames, returns true if the buffers or the textures were recreated
+	[[nodiscard]] bool Update(VulkanContext& ctx);
+	[[nodiscard]] bool IsLoading() const { return loadThread_.joinable() && !loadFinished_; }
+
+	// Call before the pipelines are created, the descriptor sets have to be updated with
+	// TextureStreamer::TakeChangedTextures() every frame, see PipelinePBRBindless
+	void EnableTextureStreaming(VulkanContext& ctx);
+	// Call once per frame after the fence of the current frame is signaled
+	void UpdateTextureStreaming(VulkanContext& ctx);
+	[[nodiscard]] bool UseTextureStreaming() const { return textureStreaming_; }
+	[[nodiscard]] TextureStreamer* GetTextureStreamer() { return &textureStreamer_; }
+
+	// Call before the pipelines are created, see instancedIndirectBuffer_
+	void EnableInstancedDraws(VulkanContext& ctx);
+	[[nodiscard]] bool UseInstancedDraws() const { return instancedDraws_; }
+	[[nodiscard]] uint32_t GetDrawGroupCount() const { return drawGroupCount_; }
+
 	[[nodiscard]] uint32_t GetInstanceCount() const { return static_cast<uint32_t>(meshDataArray_.size()); }
 	[[nodiscard]] std::vector<VkDescriptorImageInfo> GetImageInfos() const;
 	[[nodiscard]] BDA GetBDA() const;
 	[[nodiscard]] int GetClickedInstanceIndex(const Ray& ray);
+	[[nodiscard]] bool IsInstanceClickable(uint32_t instanceIndex) const;
+
+	// Closest triangle of a clickable instance, the instance BVH is traversed first then the triangle BVH of the mesh
+	[[nodiscard]] bool PickTriangle(const Ray& ray, ScenePickResult& result);
 
 	// TODO rename to GetDrawOffsetAndCount
+	// Constant time, the draw count includes the holes of removed instances which draw nothing
 	void GetOffsetAndDrawCount(MaterialType matType, VkDeviceSize& offset, uint32_t& drawCount) const;
 	void GetVertexOffsetAndCount(const uint32_t instanceIndex, uint32_t& vertexStart, uint32_t& vertexCount) const;
 	void GetIndexOffsetAndCount(const uint32_t instanceIndex, uint32_t& indexStart, uint32_t& indexCount) const;
@@ -53,7 +110,7 @@ public:
 	const std::span<VertexData> GetVertices(const uint32_t instanceIndex);
 	const std::span<uint32_t> GetIndices(const uint32_t instanceIndex);
 
-	/*Update model matrix and update the buffer
+	/*Update model matrix of the root node, the buffers are updated by UploadModelMatrices()
 	Need two indices to access instanceMapArray_
 		First index is modelIndex
 		Second index is perModelInstanceIndex*/
@@ -63,7 +120,7 @@ public:
 		const uint32_t modelIndex,
 		const uint32_t perModelInstanceIndex);
 
-	/*Only update the buffer of model matrix
+	/*Same as UpdateNodeWorldMatrix() for the root node of an instance
 	Need two indices to access instanceMapArray_
 		First index is modelIndex
 		Second index is perModelInstanceIndex*/
@@ -71,11 +128,44 @@ public:
 		VulkanContext& ctx,
 		const uint32_t modelIndex,
 		const uint32_t perModelInstanceIndex);
+
+	// For code that modifies modelSSBOs_[matrixIndex] directly, the children of the node follow it
+	void UpdateNodeWorldMatrix(uint32_t matrixIndex);
+
+	// Model matrix index of a named node of a model instance, the names come from the model file
+	[[nodiscard]] bool FindNode(
+		const uint32_t modelIndex,
+		const uint32_t perModelInstanceIndex,
+		const std::string& nodeName,
+		uint32_t& matrixIndex) const;
+
+	// Transform relative to the parent node, the world matrices are updated by UploadModelMatrices()
+	void SetNodeLocalTransform(uint32_t matrixIndex, const glm::mat4& localTransform);
+	[[nodiscard]] const glm::mat4& GetNodeLocalTransform(uint32_t matrixIndex) const { return sceneGraph_.GetLocalTransform(matrixIndex); }
 	
+	/*Call once per frame after the fence of the current frame is signaled.
+	World matrices of the moved nodes are recomputed first, then changed matrices are merged into contiguous ranges and uploaded to the buffer of the current frame,
+	the other frames in flight catch up when their frame index comes back*/
+	void UploadModelMatrices(VulkanContext& ctx);
+
 	void CreateIndirectBuffer(
 		VulkanContext& ctx,
 		VulkanBuffer& indirectBuffer);
 
+	/*Spawns a copy of a loaded model and returns its perModelInstanceIndex, or -1 on failure.
+	Indices of removed instances are reused. The instance is drawn after the next Update(),
+	UpdateModelMatrix() can be called before that*/
+	[[nodiscard]] int AddModelInstance(const uint32_t modelIndex, const glm::mat4& modelMatrix);
+	void RemoveModelInstance(const uint32_t modelIndex, const uint32_t perModelInstanceIndex);
+
+	// CreateDataStructures() resets the instances when a model or its textures finish loading
+	[[nodiscard]] bool CanEditInstances() const;
+
+	/*Reorders the draws of each material front to back from viewPosition, transparent draws back to front.
+	Applied by the next Update() which waits for the device, so call it after the camera moved far.
+	Returns false while the scene is loading*/
+	[[nodiscard]] bool SortDraws(const glm::vec3& viewPosition);
+
 	void UpdateAnimation(VulkanContext& ctx, float deltaTime);
 
 private:
@@ -83,7 +173,27 @@ private:
 
 	void CreateAnimationResources(VulkanContext& ctx);
 	void CreateBindlessResources(VulkanContext& ctx);
+	void DestroyBindlessResources();
 	void CreateDataStructures();
+	void CreateDrawSlotBuffers(VulkanContext& ctx);
+	bool CreateInstancedDrawBuffers(VulkanContext& ctx);
+	void DestroyInstancedDrawBuffers();
+	void CreateModelMatrixBuffers(VulkanContext& ctx, uint32_t matrixCapacity);
+	[[nodiscard]] bool ApplyInstanceChanges(VulkanContext& ctx);
+	void RelayoutDrawSlots(const std::array<uint32_t, MaterialTypeCount>& capacities, std::vector<uint32_t>& changedSlots);
+	[[nodiscard]] uint32_t AllocateDrawSlot(MaterialType material);
+	void FreeDrawSlot(uint32_t slot);
+	[[nodiscard]] uint32_t AllocateMatrixBlock(uint32_t modelIndex);
+	[[nodiscard]] uint32_t AddMaterial(const MaterialData& materialData);
+	[[nodiscard]] VkDrawIndirectCommand GetDrawCommand(uint32_t slot) const;
+	void ResizeDirtyModelMatrixBits();
+	void AddStreamedTextures(VulkanContext& ctx);
+	void MarkModelMatrixDirty(uint32_t matrixIndex);
+	void ClearDirtyModelMatrices();
+	[[nodiscard]] const BVH& GetMeshBVH(uint32_t modelIndex, uint32_t perModelMeshIndex);
+
+	void LoadModelsAsync(VulkanContext& ctx, std::vector<ModelCreateInfo> modelInfoArray, std::stop_token stopToken);
+	void StopLoading();
 	
 public:
 	uint32_t triangleCount_ = 0;
@@ -94,6 +204,10 @@ public:
 	std::vector<MeshData> meshDataArray_{}; // Content is sent to meshDataBuffer_
 	std::vector<InstanceData> instanceDataArray_{};
 	std::vector<BoundingBox> transformedBoundingBoxes_{}; // Content is sent to transformedBoundingBoxBuffer_
+	BoundingBoxBatch originalBoundingBoxes_{}; // Object space boxes of instanceDataArray_ for fast transforms
+
+	// Deduplicated so it is shorter than the arrays above, content is sent to materialDataBuffer_
+	std::vector<MaterialData> materialDataArray_{};
 	
 	// Animation
 	VulkanBuffer boneIDBuffer_{};
@@ -107,24 +221,90 @@ public:
 	VulkanBuffer indexBuffer_{};
 	VulkanBuffer indirectBuffer_{};
 	VulkanBuffer meshDataBuffer_{};
+	VulkanBuffer materialDataBuffer_{};
 	std::array<VulkanBuffer, AppConfig::FrameCount> modelSSBOBuffers_{}; // Frame-in-flight
 
 	// Frustum culling
 	VulkanBuffer transformedBoundingBoxBuffer_{}; // TODO No Frame-in-flight but somenow not giving error
+
+	// Hardware instancing, only created if EnableInstancedDraws() is called
+	VulkanBuffer instancedIndirectBuffer_{}; // One command per unique mesh, firstInstance is the start of its list in instanceIndexBuffer_
+	VulkanBuffer instancedIndirectResetBuffer_{}; // Same commands with instanceCount zero, copied before culling
+	VulkanBuffer instanceIndexBuffer_{}; // Draw slots of each command
+	VulkanBuffer drawGroupIndexBuffer_{}; // Command of each draw slot, DrawGroupNone for holes
 	
 private:
 	std::vector<Model> models_{};
+	DefaultTextures defaultTextures_{}; // Shared by all models
+
+	// Picking, the BVH is refitted on the next pick after a bounding box changes
+	BVH instanceBVH_{};
+	bool instanceBVHDirty_ = false;
+	std::vector<std::vector<BVH>> meshBVHs_{}; // Object space triangles, built when a ray first reaches the mesh
+
+	bool textureStreaming_ = false;
+	TextureStreamer textureStreamer_{};
+
+	bool instancedDraws_ = false;
+	uint32_t drawGroupCount_ = 0;
 
 	/*Update model matrix and update the buffer
 	Need two indices to access instanceMapArray_
 		First index is modelIndex
 		Second index is perModelInstanceIndex*/
 	std::vector<std::vector<InstanceMap>> instanceMapArray_{};
+	std::vector<std::vector<uint32_t>> matrixInstanceIndices_{}; // Global instance indices that use each matrix, sorted
+	SceneGraph sceneGraph_{}; // Same length as modelSSBOs_
+	std::vector<std::vector<BoundingBox>> meshBoundingBoxes_{}; // Object space, per model and mesh
+	std::vector<std::vector<uint32_t>> meshMaterialIndices_{}; // Index to materialDataArray_, per model and mesh
+
+	// Runtime instances, slots from first_ + used_ to first_ + capacity_ are free as well
+	struct DrawSlotRange
+	{
+		uint32_t first_ = 0;
+		uint32_t used_ = 0;
+		uint32_t capacity_ = 0;
+		std::vector<uint32_t> freeSlots_{}; // Holes below first_ + used_
+	};
+	std::array<DrawSlotRange, MaterialTypeCount> drawSlotRanges_{}; // Indexed by MaterialType
+	std::vector<std::vector<uint32_t>> freeMatrixBlocks_{}; // Per model, first matrix of each removed instance
+	uint32_t matrixCapacity_ = 0; // Length of modelSSBOBuffers_
+	std::vector<std::pair<uint32_t, uint32_t>> addedInstances_{}; // modelIndex and perModelInstanceIndex
+	std::vector<std::pair<uint32_t, uint32_t>> removedInstances_{};
+	glm::vec3 drawSortViewPosition_{};
+	bool drawSortRequested_ = false;
+
+	// Bitsets of changed matrices, one per frame in flight and one for the bounding boxes
+	std::array<std::vector<uint64_t>, AppConfig::FrameCount> dirtyMatrixBits_{};
+	std::array<bool, AppConfig::FrameCount> matricesDirty_{};
+	std::vector<uint64_t> dirtyBoundingBoxBits_{};
+	bool boundingBoxesDirty_ = false;
 
 	// Animation
 	std::vector<glm::mat4> skinningMatrices_{};
 	std::vector<Animation> animations_{};
 	std::vector<Animator> animators_{};
+
+	// Background loading
+	struct LoadedModel
+	{
+		Model model_;
+		SceneData sceneData_; // Vertices and indices of this model only
+	};
+	struct LoadedTextures
+	{
+		uint32_t modelIndex_;
+		std::vector<VulkanImage> textures_;
+	};
+	uint32_t modelCount_ = 0; // Including the models that are still loading
+	uint32_t textureCapacity_ = 0; // Size of the bindless texture array without the default textures
+	std::map<std::pair<uint32_t, uint32_t>, ModelUBO> pendingModelMatrices_{}; // For models that are still loading and added instances
+	std::mutex loadMutex_{};
+	std::vector<LoadedModel> loadedModels_{};
+	std::vector<LoadedTextures> loadedTextures_{};
+	std::exception_ptr loadException_{};
+	std::atomic<bool> loadFinished_ = false;
+	std::jthread loadThread_{}; // Last member so it is stopped before the others are destroyed
 };
 
 #endif
\ No newline at end of file
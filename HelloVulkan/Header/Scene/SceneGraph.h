@@ -0,0 +1,85 @@
+#ifndef SCENE_GRAPH
+#define SCENE_GRAPH
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+constexpr uint32_t SceneGraphNoParent = std::numeric_limits<uint32_t>::max();
+
+/*
+Hierarchy of transforms stored as flat arrays in topological order, a parent always comes before
+its children. A node index is the same as its model matrix index in Scene::modelSSBOs_.
+
+Changing a local transform only flags the node, UpdateWorldTransforms() then walks the arrays once
+starting at the first flagged node. A node is recomputed if it is flagged or its parent was recomputed,
+so only the subtrees that moved pay for a matrix multiplication.
+*/
+class SceneGraph
+{
+public:
+	// Parents have to be added before their children, returns the index of the node
+	uint32_t AddNode(uint32_t parentIndex, const glm::mat4& localTransform);
+	void Clear();
+
+	void SetLocalTransform(uint32_t nodeIndex, const glm::mat4& localTransform);
+
+	// Sets the local transform that gives this world transform, uses the world transform of the parent
+	// from the last UpdateWorldTransforms()
+	void SetWorldTransform(uint32_t nodeIndex, const glm::mat4& worldTransform);
+
+	[[nodiscard]] uint32_t GetNodeCount() const { return static_cast<uint32_t>(parents_.size()); }
+	[[nodiscard]] uint32_t GetParent(uint32_t nodeIndex) const { return parents_[nodeIndex]; }
+	[[nodiscard]] const glm::mat4& GetLocalTransform(uint32_t nodeIndex) const { return localTransforms_[nodeIndex]; }
+	[[nodiscard]] const glm::mat4& GetWorldTransform(uint32_t nodeIndex) const { return worldTransforms_[nodeIndex]; }
+	[[nodiscard]] bool IsDirty() const { return firstDirty_ < parents_.size(); }
+
+	// onWorldChanged is void(uint32_t nodeIndex, const glm::mat4& worldTransform), called in increasing node order
+	template<typename WorldChangedFunction>
+	void UpdateWorldTransforms(WorldChangedFunction&& onWorldChanged);
+
+private:
+	void MarkDirty(uint32_t nodeIndex);
+
+	std::vector<glm::mat4> localTransforms_{};
+	std::vector<glm::mat4> worldTransforms_{};
+	std::vector<uint32_t> parents_{};
+	std::vector<uint8_t> dirty_{}; // Not std::vector<bool> so the flags can be read without bit masking
+	uint32_t firstDirty_ = std::numeric_limits<uint32_t>::max();
+};
+
+template<typename WorldChangedFunction>
+void SceneGraph::UpdateWorldTransforms(WorldChangedFunction&& onWorldChanged)
+{
+	if (!IsDirty())
+	{
+		return;
+	}
+
+	// Nodes before firstDirty_ are clean so their children only change if flagged themselves
+	const uint32_t nodeCount = GetNodeCount();
+	for (uint32_t i = firstDirty_; i < nodeCount; ++i)
+	{
+		const uint32_t parent = parents_[i];
+		if (parent != SceneGraphNoParent && dirty_[parent])
+		{
+			dirty_[i] = 1;
+		}
+		if (!dirty_[i])
+		{
+			continue;
+		}
+		worldTransforms_[i] = parent == SceneGraphNoParent ?
+			localTransforms_[i] :
+			worldTransforms_[parent] * localTransforms_[i];
+		onWorldChanged(i, worldTransforms_[i]);
+	}
+
+	std::fill(dirty_.begin() + firstDirty_, dirty_.end(), uint8_t{ 0 });
+	firstDirty_ = std::numeric_limits<uint32_t>::max();
+}
+
+#endif
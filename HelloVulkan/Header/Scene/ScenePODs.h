@@ -6,6 +6,7 @@
 #include "Configs.h"
 
 #include <vector>
+#include <string>
 #include <array>
 
 #include "glm/glm.hpp"
@@ -51,16 +52,12 @@ enum class MaterialType : uint32_t
 	Specular = 2,
 	Light = 3,
 };
+constexpr uint32_t MaterialTypeCount = 4;
 
 // For bindless textures
-struct MeshData
+// Shared by every mesh with the same textures and material type, see Scene::materialDataArray_
+struct MaterialData
 {
-	uint32_t vertexOffset_ = 0;
-	uint32_t indexOffset_ = 0;
-
-	// Pointing to modelSSBO_
-	uint32_t modelMatrixIndex_ = 0;
-
 	// PBR Texture IDs
 	uint32_t albedo_ = 0;
 	uint32_t normal_ = 0;
@@ -69,8 +66,22 @@ struct MeshData
 	uint32_t ao_ = 0;
 	uint32_t emissive_ = 0;
 
-	// For sorting
 	MaterialType material_{};
+
+	bool operator==(const MaterialData&) const = default;
+};
+
+// One per draw slot, 16 bytes so four fit in a cache line
+struct MeshData
+{
+	uint32_t vertexOffset_ = 0;
+	uint32_t indexOffset_ = 0;
+
+	// Pointing to modelSSBO_
+	uint32_t modelMatrixIndex_ = 0;
+
+	// Pointing to Scene::materialDataArray_
+	uint32_t materialIndex_ = 0;
 };
 
 struct InstanceData
@@ -84,17 +95,46 @@ struct InstanceData
 	uint32_t perModelMeshIndex_ = 0;
 
 	MeshData meshData_{};
+	MaterialType material_{}; // For sorting, same as the material of meshData_.materialIndex_
 	BoundingBox originalBoundingBox_{};
+
+	// Free draw slot that draws nothing, see Scene::RemoveModelInstance()
+	bool removed_ = false;
+};
+
+// Result of Scene::PickTriangle()
+struct ScenePickResult
+{
+	int instanceIndex_ = -1;
+	uint32_t triangleIndex_ = 0; // Triangle of the mesh, its indices start at indexOffset_ + 3 * triangleIndex_
+	glm::vec2 barycentric_{}; // Weights of the second and third vertex
+	float distance_ = 0.0f; // Along the ray in world space
 };
 
-// Needed for updating bounding boxes
+// Model instances added or removed at runtime wait for Scene::Update()
+enum class InstanceState : uint32_t
+{
+	Alive = 0,
+	Adding = 1,
+	Removing = 2,
+	Removed = 3,
+};
+
+// Needed for updating model matrices
 struct InstanceMap
 {
-	// Pointing to modelSSBO_
+	// Pointing to modelSSBO_, this is the root node of the instance
 	uint32_t modelMatrixIndex_ = 0;
 
-	// List of global instance indices that share the same model matrix
-	std::vector<uint32_t> instanceDataIndices_{};
+	InstanceState state_ = InstanceState::Alive;
+};
+
+// Node of a model hierarchy, see Model::nodes_
+struct ModelNode
+{
+	std::string name_{};
+	glm::mat4 localTransform_ = glm::mat4(1.0f);
+	uint32_t parentIndex_ = 0; // Index in Model::nodes_, not used by the first node
 };
 
 struct ModelCreateInfo
@@ -108,6 +148,10 @@ struct ModelCreateInfo
 	bool playAnimation = false;
 
 	bool clickable = false;
+
+	// Meshes are not baked into model space so nodes can be moved with Scene::SetNodeLocalTransform().
+	// No effect if the model plays an animation
+	bool nodeHierarchy = false;
 };
 
 // Skinning
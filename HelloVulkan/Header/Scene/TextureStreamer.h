@@ -0,0 +1,86 @@
+#ifndef TEXTURE_STREAMER
+#define TEXTURE_STREAMER
+
+#include "VulkanContext.h"
+#include "VulkanImage.h"
+#include "VulkanBuffer.h"
+#include "Configs.h"
+
+#include <array>
+#include <vector>
+#include <unordered_map>
+
+/*
+Keeps only the mip levels of bindless textures that are needed on screen.
+
+AddTexture() copies the full mip chain to system memory and replaces the image with its small mips.
+The fragment shader writes the finest mip level it needs per texture index to a feedback buffer,
+see Bindless/TextureFeedback.glsl. Update() reads the feedback of the previous use of the frame index,
+recreates a few images with more mip levels, and drops mip levels of the least recently used textures
+when AppConfig::TextureStreamingBudget is exceeded.
+
+A replaced image is destroyed after every frame in flight stopped using it, so the owner of the
+descriptor sets has to write TakeChangedTextures() into the set of the current frame each frame.
+*/
+class TextureStreamer
+{
+public:
+	TextureStreamer() = default;
+	~TextureStreamer() = default;
+
+	// textureCount is the length of the bindless texture array
+	void Create(VulkanContext& ctx, uint32_t textureCount);
+	void Destroy();
+
+	// The image needs all its mip levels, it is destroyed and replaced by an image owned by the streamer
+	void AddTexture(VulkanContext& ctx, uint32_t textureIndex, VulkanImage& image);
+
+	// Call once per frame after the fence of the current frame is signaled
+	void Update(VulkanContext& ctx);
+
+	[[nodiscard]] bool IsStreamed(uint32_t textureIndex) const { return textures_.contains(textureIndex); }
+	[[nodiscard]] VkDescriptorImageInfo GetDescriptorImageInfo(uint32_t textureIndex) const;
+	[[nodiscard]] std::vector<uint32_t> TakeChangedTextures(uint32_t frameIndex);
+	[[nodiscard]] VulkanBuffer* GetFeedbackBuffer(uint32_t frameIndex) { return &feedbackBuffers_[frameIndex]; }
+	[[nodiscard]] VkDeviceSize GetResidentSize() const { return residentSize_; }
+
+private:
+	struct StreamedTexture
+	{
+		uint32_t width_ = 0;
+		uint32_t height_ = 0;
+		uint32_t mipCount_ = 0;
+		uint32_t initialMip_ = 0; // Never evicted
+		uint32_t residentMip_ = 0; // Finest mip level on the GPU
+		uint32_t requestedMip_ = 0;
+		uint64_t lastUsedFrame_ = 0;
+		std::vector<char> mipData_{}; // All mip levels, tightly packed
+		std::vector<size_t> mipOffsets_{};
+		VulkanImage image_{};
+	};
+
+	struct RetiredImage
+	{
+		uint64_t frame_;
+		VulkanImage image_;
+	};
+
+	void ReadFeedback(uint32_t frameIndex);
+	void StreamIn(VulkanContext& ctx);
+	[[nodiscard]] bool EvictLeastRecentlyUsed(VulkanContext& ctx, VkDeviceSize requiredSize, uint32_t excludedIndex);
+	void SetResidentMip(VulkanContext& ctx, uint32_t textureIndex, StreamedTexture& texture, uint32_t mip);
+	void ClearFeedback(uint32_t frameIndex);
+
+	// Size of the mip levels from mip to the last one
+	[[nodiscard]] static VkDeviceSize GetMipChainSize(const StreamedTexture& texture, uint32_t mip);
+
+	uint32_t textureCount_ = 0;
+	uint64_t frameCounter_ = 0;
+	VkDeviceSize residentSize_ = 0;
+	std::unordered_map<uint32_t, StreamedTexture> textures_{}; // Key is the bindless texture index
+	std::array<VulkanBuffer, AppConfig::FrameCount> feedbackBuffers_{};
+	std::array<std::vector<uint32_t>, AppConfig::FrameCount> changedTextures_{};
+	std::vector<RetiredImage> retiredImages_{};
+};
+
+#endif
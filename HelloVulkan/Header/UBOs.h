@@ -115,4 +115,13 @@ struct SSAOUBO
 	float noiseSize;
 };
 
+// Diffuse irradiance as L2 spherical harmonics, see PBR/SHIrradiance.glsl
+struct SHIrradianceUBO
+{
+	alignas(16)
+	glm::vec4 coefficients[9];
+	alignas(4)
+	uint32_t enabled;
+};
+
 #endif
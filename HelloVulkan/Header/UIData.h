@@ -53,6 +53,8 @@ public:
 	int gizmoMode_ = 0;
 	int gizmoModelIndex = -1;
 	int gizmoInstanceIndex = -1;
+	int hoveredInstanceIndex_ = -1; // Instance under the mouse when a gizmo mode is selected
+	bool gpuPicking_ = false; // Read the instance ID buffer instead of casting a ray when clicking
 
 	bool renderInfiniteGrid_ = true;
 	bool renderDebug_ = false;
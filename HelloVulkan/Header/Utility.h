@@ -1,8 +1,14 @@
 #ifndef UTILITY_HEADER
 #define UTILITY_HEADER
 
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <random>
 #include <span>
+#include <string>
+#include <thread>
 
 namespace Utility
 {
@@ -49,6 +55,72 @@ namespace Utility
 		return levels;
 	}
 
+	// 64-bit FNV-1a, pass the previous result as seed to hash several blocks
+	inline uint64_t Hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= static_cast<uint64_t>(bytes[i]);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// File named after a hash in a cache folder, extension includes the dot
+	inline std::string GetCacheFilePath(const std::string& folder, uint64_t hash, const std::string& extension)
+	{
+		char hashString[17];
+		snprintf(hashString, sizeof(hashString), "%016llx", static_cast<unsigned long long>(hash));
+		return folder + hashString + extension;
+	}
+
+	/*Writes the parts one after another to a temporary file that is renamed to path so a partially written file
+	is never read. The thread ID and a random number are part of the temporary name because two threads or two
+	processes can write the same file, the parent folder is created if needed. Returns false if the file cannot be written*/
+	inline bool WriteFileAtomically(const std::string& path, std::span<const std::span<const char>> parts)
+	{
+		std::error_code ec;
+		const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+		if (!parent.empty())
+		{
+			std::filesystem::create_directories(parent, ec);
+		}
+
+		const std::string tempFile = path + "." +
+			std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + "." +
+			std::to_string(std::random_device{}()) + ".tmp";
+		{
+			std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+			bool written = file.is_open();
+			for (const std::span<const char> bytes : parts)
+			{
+				written = written && file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+			}
+			if (!written)
+			{
+				file.close();
+				std::filesystem::remove(tempFile, ec);
+				return false;
+			}
+		}
+		std::filesystem::rename(tempFile, path, ec);
+		if (ec)
+		{
+			// Another writer may have renamed the same content first
+			std::filesystem::remove(tempFile, ec);
+			return std::filesystem::exists(path, ec);
+		}
+		return true;
+	}
+
+	inline bool WriteFileAtomically(const std::string& path, std::span<const char> bytes)
+	{
+		const std::span<const char> parts[] = { bytes };
+		return WriteFileAtomically(path, std::span<const std::span<const char>>(parts));
+	}
+
 	template<class T, std::size_t N>
 	auto SubSpan(std::span<T, N> s, std::size_t offset, std::size_t width)
 	{
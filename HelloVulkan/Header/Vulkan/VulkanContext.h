@@ -11,6 +11,39 @@
 
 #include <vector>
 #include <array>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+
+class VulkanMipmapGenerator;
+
+/*
+Command buffer returned by VulkanContext::BeginOneTime*Command(), it holds the queue lock until
+VulkanContext::EndOneTime*Command() submits it. If the scope is left before that, for example by an exception,
+the command buffer is freed without being submitted and the lock is released
+*/
+class OneTimeCommand
+{
+public:
+	OneTimeCommand(VkDevice device, VkCommandPool pool, std::recursive_mutex& mutex);
+	~OneTimeCommand();
+
+	OneTimeCommand(const OneTimeCommand&) = delete;
+	OneTimeCommand& operator=(const OneTimeCommand&) = delete;
+
+	[[nodiscard]] VkCommandBuffer GetCommandBuffer() const { return commandBuffer_; }
+
+private:
+	friend class VulkanContext;
+
+	// Submits, waits for the queue and frees the command buffer
+	void Submit(VkQueue queue);
+
+	std::unique_lock<std::recursive_mutex> lock_;
+	VkDevice device_{};
+	VkCommandPool pool_{};
+	VkCommandBuffer commandBuffer_{};
+};
 
 struct SwapchainSupportDetails
 {
@@ -43,6 +76,34 @@ struct FrameData
 	}
 };
 
+// VkSamplerCreateInfo without sType and pNext, used as the key of the sampler cache
+struct SamplerKey
+{
+	VkSamplerCreateFlags flags_;
+	VkFilter magFilter_;
+	VkFilter minFilter_;
+	VkSamplerMipmapMode mipmapMode_;
+	VkSamplerAddressMode addressModeU_;
+	VkSamplerAddressMode addressModeV_;
+	VkSamplerAddressMode addressModeW_;
+	float mipLodBias_;
+	VkBool32 anisotropyEnable_;
+	float maxAnisotropy_;
+	VkBool32 compareEnable_;
+	VkCompareOp compareOp_;
+	float minLod_;
+	float maxLod_;
+	VkBorderColor borderColor_;
+	VkBool32 unnormalizedCoordinates_;
+
+	bool operator==(const SamplerKey&) const = default;
+};
+
+struct SamplerKeyHash
+{
+	size_t operator()(const SamplerKey& key) const;
+};
+
 struct ContextConfig
 {
 	bool supportRaytracing_{ false }; // If raytracing is enabled then buffer device address is also enabled
@@ -60,7 +121,7 @@ class VulkanContext
 {
 public:
 	VulkanContext() = default;
-	~VulkanContext() = default;
+	~VulkanContext();
 
 	// Not copyable or movable
 	VulkanContext(const VulkanContext&) = delete;
@@ -81,10 +142,14 @@ public:
 		uint32_t height);
 	VkResult GetNextSwapchainImage(VkSemaphore nextSwapchainImageSemaphore);
 
-	[[nodiscard]] VkCommandBuffer BeginOneTimeGraphicsCommand() const;
-	void EndOneTimeGraphicsCommand(VkCommandBuffer commandBuffer) const;
-	[[nodiscard]] VkCommandBuffer BeginOneTimeComputeCommand() const;
-	void EndOneTimeComputeCommand(VkCommandBuffer commandBuffer) const;
+	[[nodiscard]] OneTimeCommand BeginOneTimeGraphicsCommand() const;
+	void EndOneTimeGraphicsCommand(OneTimeCommand& command) const;
+
+	// One-time commands can be submitted from worker threads, hold this lock to use the queues directly
+	[[nodiscard]] std::unique_lock<std::recursive_mutex> LockQueues() const { return std::unique_lock<std::recursive_mutex>(oneTimeCommandMutex_); }
+
+	[[nodiscard]] OneTimeCommand BeginOneTimeComputeCommand() const;
+	void EndOneTimeComputeCommand(OneTimeCommand& command) const;
 
 	// Getters
 	[[nodiscard]] VkDevice GetDevice() const { return device_; }
@@ -100,6 +165,7 @@ public:
 	[[nodiscard]] VkQueue GetComputeQueue() const { return computeQueue_; }
 	[[nodiscard]] VkFormat GetDepthFormat() const { return depthFormat_; };
 	[[nodiscard]] VmaAllocator GetVMAAllocator() const { return vmaAllocator_; }
+	[[nodiscard]] VkPipelineCache GetPipelineCache() const { return pipelineCache_; }
 	[[nodiscard]] bool SupportBufferDeviceAddress() const { return config_.supportRaytracing_ || config_.suportBufferDeviceAddress_; }
 
 	// Getters related to swapchain
@@ -122,6 +188,16 @@ public:
 	[[nodiscard]] uint32_t GetFrameIndex() const;
 	[[nodiscard]] TracyVkCtx GetTracyContext() const { return frameDataArray_[GetFrameIndex()].tracyContext_; }
 
+	// Created on first use
+	[[nodiscard]] VulkanMipmapGenerator* GetMipmapGenerator();
+
+	// Samplers with the same parameters are shared, they are destroyed with the context.
+	// The pNext chain is not part of the key
+	[[nodiscard]] VkSampler GetSampler(const VkSamplerCreateInfo& samplerInfo);
+
+	// Whether images of this format can be created with all the features
+	[[nodiscard]] bool IsFormatSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features) const;
+
 	// Debugging
 	void SetVkObjectName(void* objectHandle, VkObjectType objType, const char* name) const;
 	void InsertDebugLabel(VkCommandBuffer commandBuffer, const char* label, uint32_t colorRGBA) const;
@@ -148,12 +224,17 @@ private:
 	VkResult CreateSemaphore(VkSemaphore* outSemaphore) const;
 	VkResult CreateFence(VkFence* fence) const;
 	VkResult CreateCommandBuffer(VkCommandPool pool, VkCommandBuffer* commandBuffer) const;
-	VkResult CreateCommandPool(uint32_t family, VkCommandPool* pool) const;
+	VkResult CreateCommandPool(uint32_t family, VkCommandPoolCreateFlags flags, VkCommandPool* pool) const;
 
 	void GetQueues();
 	void AllocateFrameInFlightData();
 	void AllocateVMA(VulkanInstance& instance);
 
+	// Pipeline cache
+	void CreatePipelineCache();
+	void SavePipelineCache() const;
+	[[nodiscard]] bool IsPipelineCacheCompatible(const std::vector<char>& cacheData) const;
+
 	void GetRaytracingPropertiesAndFeatures();
 	void ChainFeatures();
 
@@ -182,12 +263,14 @@ private:
 	// Graphics
 	uint32_t graphicsFamily_{ 0 };
 	VkQueue graphicsQueue_{};
-	VkCommandPool graphicsCommandPool_{};
+	VkCommandPool graphicsCommandPool_{}; // Frame command buffers, only used by the main thread
+	VkCommandPool oneTimeGraphicsCommandPool_{}; // Guarded by oneTimeCommandMutex_
 
 	// Compute
 	uint32_t computeFamily_{ 0 };
 	VkQueue computeQueue_{};
 	VkCommandPool computeCommandPool_{};
+	VkCommandPool oneTimeComputeCommandPool_{}; // Guarded by oneTimeCommandMutex_
 
 	std::vector<uint32_t> deviceQueueIndices_{};
 
@@ -196,6 +279,18 @@ private:
 
 	VmaAllocator vmaAllocator_{};
 
+	// Shared by every pipeline and serialized to disk on shutdown
+	VkPipelineCache pipelineCache_{};
+
+	std::unique_ptr<VulkanMipmapGenerator> mipmapGenerator_{};
+
+	std::unordered_map<SamplerKey, VkSampler, SamplerKeyHash> samplerCache_{};
+	std::mutex samplerCacheMutex_;
+
+	// Held by OneTimeCommand from BeginOneTime*Command() until EndOneTime*Command() because
+	// command pools and queues need external synchronization when pipelines are created on worker threads
+	mutable std::recursive_mutex oneTimeCommandMutex_;
+
 	ContextConfig config_{};
 
 	// Raytracing and bindless
@@ -24,6 +24,15 @@ public:
 
 	void UpdateSet(VulkanContext& ctx, const VulkanDescriptorSetInfo& descriptorInfo, VkDescriptorSet* set);
 
+	// Writes one element of an image array, for example a bindless texture that was replaced
+	void UpdateImageArrayElement(
+		VulkanContext& ctx,
+		VkDescriptorSet set,
+		uint32_t bindingIndex,
+		uint32_t arrayElement,
+		const VkDescriptorImageInfo& imageInfo,
+		VkDescriptorType dsType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+
 	void Destroy();
 
 private:
@@ -19,6 +19,8 @@ struct DescriptorWrite
 	uint32_t descriptorCount_ = 1u;
 	VkDescriptorType descriptorType_;
 	VkShaderStageFlags shaderStage_;
+	// For example VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT for a bindless array
+	VkDescriptorBindingFlags bindingFlags_ = 0;
 };
 
 class VulkanDescriptorSetInfo
@@ -42,6 +44,11 @@ public:
 		const VulkanImage* image,
 		VkDescriptorType dsType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 		VkShaderStageFlags stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT);
+	// For a view or a sampler that is not owned by a VulkanImage
+	void AddImage(
+		const VkDescriptorImageInfo& imageInfo,
+		VkDescriptorType dsType,
+		VkShaderStageFlags stageFlags);
 	void UpdateBuffer(const VulkanBuffer* buffer, size_t bindingIndex);
 	void UpdateImage(const VulkanImage* image, size_t bindingIndex);
 
@@ -50,7 +57,10 @@ public:
 	void AddImageArray(
 		const std::vector<VkDescriptorImageInfo>& imageArray,
 		VkDescriptorType dsType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-		VkShaderStageFlags stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT);
+		VkShaderStageFlags stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+		VkDescriptorBindingFlags bindingFlags = 0);
+	// The array cannot be bigger than the one in the descriptor layout
+	void UpdateImageArray(const std::vector<VkDescriptorImageInfo>& imageArray, size_t bindingIndex);
 
 	// Raytracing
 	void AddAccelerationStructure(VkShaderStageFlags stageFlags);
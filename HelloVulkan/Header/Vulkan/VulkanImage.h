@@ -4,6 +4,7 @@
 #include "VulkanContext.h"
 
 #include <string>
+#include <vector>
 
 class VulkanImage
 {
@@ -24,6 +25,7 @@ public:
 	uint32_t mipCount_{ 0 };
 	uint32_t layerCount_{ 0 };
 	VkFormat imageFormat_{ VK_FORMAT_UNDEFINED };
+	VkImageUsageFlags imageUsage_{ 0 };
 	VkSampleCountFlagBits multisampleCount_{ VK_SAMPLE_COUNT_1_BIT };
 
 public:
@@ -39,6 +41,7 @@ public:
 		mipCount_(0),
 		layerCount_(0),
 		imageFormat_(VK_FORMAT_UNDEFINED),
+		imageUsage_(0),
 		multisampleCount_(VK_SAMPLE_COUNT_1_BIT)
 	{
 	}
@@ -61,6 +64,8 @@ public:
 		int width,
 		int height);
 
+	// Half floats when AppConfig::UseHalfFloatHDR is set and the file is supported by HDRLoader,
+	// otherwise 32-bit floats decoded by stb_image
 	void CreateFromHDR(
 		VulkanContext& ctx,
 		const char* filename);
@@ -74,6 +79,7 @@ public:
 		VkFilter maxFilter = VK_FILTER_LINEAR,
 		VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
 
+	// Shared through VulkanContext::GetSampler(), not destroyed with the image
 	void CreateDefaultSampler(
 		VulkanContext& ctx,
 		float minLod = 0.f,
@@ -105,6 +111,29 @@ public:
 		VkFormat texFormat,
 		VkImageCreateFlags flags = 0);
 
+	// All mip levels and layers, tightly packed and ordered by mip level then layer
+	void CreateImageFromMipData(
+		VulkanContext& ctx,
+		const void* imageData,
+		uint32_t texWidth,
+		uint32_t texHeight,
+		uint32_t mipmapCount,
+		uint32_t layerCount,
+		VkFormat texFormat,
+		VkImageCreateFlags flags = 0);
+
+	// Byte count of the imageData of CreateImageFromMipData(), zero if the format is unknown
+	[[nodiscard]] static VkDeviceSize GetMipDataSize(
+		uint32_t texWidth,
+		uint32_t texHeight,
+		uint32_t mipmapCount,
+		uint32_t layerCount,
+		VkFormat texFormat);
+
+	// Reads back all mip levels and layers in the same order as CreateImageFromMipData(),
+	// the image has to be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	[[nodiscard]] std::vector<char> DownloadImageData(VulkanContext& ctx);
+
 	// This is used for offscreen rendering as a color attachment
 	void CreateColorAttachment(
 		VulkanContext& ctx, 
@@ -121,6 +150,8 @@ public:
 		VkSampleCountFlagBits sampleCount = VK_SAMPLE_COUNT_1_BIT,
 		VkImageUsageFlags additionalUsage = 0);
 
+	// Uses VulkanMipmapGenerator if the image has VK_IMAGE_USAGE_STORAGE_BIT, otherwise one blit per mip level.
+	// currentImageLayout is the layout of mip 0, the other mip levels are overwritten
 	void GenerateMipmap(
 		VulkanContext& ctx,
 		uint32_t maxMipLevels,
@@ -205,7 +236,22 @@ private:
 		const void* imageData,
 		VkImageLayout sourceImageLayout = VK_IMAGE_LAYOUT_UNDEFINED);
 
-	uint32_t BytesPerTexFormat(VkFormat fmt);
+	// Decodes into a mapped staging buffer, returns false if HDRLoader cannot load the file
+	[[nodiscard]] bool CreateFromHalfFloatHDR(
+		VulkanContext& ctx,
+		const char* filename);
+
+	static uint32_t BytesPerTexFormat(VkFormat fmt);
+
+	static VkSamplerCreateInfo GetSamplerCreateInfo(
+		float minLod,
+		float maxLod,
+		VkFilter minFilter,
+		VkFilter maxFilter,
+		VkSamplerAddressMode addressMode);
+
+	// One copy region per mip level, each covers all layers
+	std::vector<VkBufferImageCopy> GetMipCopyRegions(VkDeviceSize& totalSize);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef VULKAN_MIPMAP_GENERATOR
+#define VULKAN_MIPMAP_GENERATOR
+
+#include "VulkanContext.h"
+#include "VulkanBuffer.h"
+#include "VulkanDescriptorManager.h"
+
+#include <vector>
+
+class VulkanImage;
+
+// Image views and a descriptor set for one image, keep it if the image is downsampled every frame
+struct MipmapTarget
+{
+	VulkanImage* image_{};
+	uint32_t mipCount_{ 0 };
+	uint32_t workGroupCountX_{ 0 };
+	uint32_t workGroupCountY_{ 0 };
+	VkImageView sourceView_{ VK_NULL_HANDLE };
+	std::vector<VkImageView> mipViews_{};
+	VkDescriptorSet descriptorSet_{ VK_NULL_HANDLE };
+};
+
+/*
+Generates all mip levels of an image with a single compute dispatch, see SinglePassDownsample.comp.
+The image needs VK_IMAGE_USAGE_STORAGE_BIT, at most 13 mip levels, and at most 6 layers,
+otherwise VulkanImage::GenerateMipmap() falls back to one blit per mip level.
+*/
+class VulkanMipmapGenerator
+{
+public:
+	void Create(VulkanContext& ctx);
+	void Destroy();
+
+	[[nodiscard]] static bool IsSupported(VulkanContext& ctx, const VulkanImage* image, uint32_t mipCount);
+
+	// Blocking, all mip levels end in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	void GenerateMipmap(VulkanContext& ctx, VulkanImage* image, uint32_t mipCount, VkImageLayout currentImageLayout);
+
+	// Allocate from a shared descriptor pool, hold VulkanContext::LockQueues() if other threads generate mipmaps
+	void CreateTarget(VulkanContext& ctx, VulkanImage* image, uint32_t mipCount, MipmapTarget& target);
+	void DestroyTarget(VulkanContext& ctx, MipmapTarget& target);
+
+	// Mip 0 was last written as a color attachment or by a transfer,
+	// all mip levels end in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	void RecordCommand(VkCommandBuffer commandBuffer, const MipmapTarget& target, VkImageLayout currentImageLayout);
+
+private:
+	VkDevice device_{ VK_NULL_HANDLE };
+	VkSampler sampler_{ VK_NULL_HANDLE };
+	VkPipelineLayout pipelineLayout_{ VK_NULL_HANDLE };
+	VkPipeline pipeline_{ VK_NULL_HANDLE };
+	VulkanDescriptorManager descriptorManager_{};
+	VulkanBuffer mip6Buffer_{}; // Mip 6 of every workgroup, read by the last workgroup
+	VulkanBuffer counterBuffer_{}; // Finished workgroups per layer, reset by the shader
+
+	void CreateSampler(VulkanContext& ctx);
+	void CreateBuffers(VulkanContext& ctx);
+	void CreateDescriptorLayout(VulkanContext& ctx);
+	void CreatePipeline(VulkanContext& ctx);
+};
+
+#endif
\ No newline at end of file
@@ -91,6 +91,9 @@ public:
 		VkFramebuffer framebuffer,
 		uint32_t cubeSideLength);
 
+	// The color attachments are cleared to one by default, integer attachments need their own value
+	void SetClearColor(uint32_t attachmentIndex, const VkClearColorValue& color);
+
 	void Destroy();
 
 	VkRenderPass GetHandle() const { return handle_;}
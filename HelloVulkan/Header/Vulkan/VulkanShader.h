@@ -30,6 +30,10 @@ public:
 		VkShaderStageFlagBits shaderStage,
 		const char* entryPoint);
 
+	// Include cache and dependency graph, shared by every shader
+	[[nodiscard]] static std::vector<std::string> GetDependentShaders(const std::string& file);
+	static void InvalidateIncludeCache(const std::string& file);
+
 private:
 	std::vector<unsigned int> spirv_{};
 	VkShaderModule shaderModule_{};
@@ -38,8 +42,18 @@ private:
 private:
 	[[nodiscard]] size_t CompileShaderFile(const char* file);
 	[[nodiscard]] std::string ReadShaderFile(const char* fileName);
+	[[nodiscard]] static std::string ResolveIncludes(const std::string& code, std::vector<std::string>& includedFiles);
+	[[nodiscard]] static std::string ReadTextFile(const char* fileName);
 	[[nodiscard]] size_t CompileShader(glslang_stage_t stage, const char* shaderSource);
 	void PrintShaderSource(const char* text);
+
+	// SPIR-V cache, the key is a hash of the resolved source, the stage, and the glslang target
+	[[nodiscard]] std::string GetCacheFilePath(glslang_stage_t stage, const std::string& shaderSource) const;
+	[[nodiscard]] bool LoadFromCache(const std::string& cacheFile);
+	void SaveToCache(const std::string& cacheFile) const;
+
+	// Precompiled SPIR-V, only used if the shipped source matches the resolved source
+	[[nodiscard]] bool LoadPrecompiled(const std::string& file, const std::string& shaderSource);
 };
 
 #endif
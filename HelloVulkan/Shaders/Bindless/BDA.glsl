@@ -9,12 +9,20 @@ readonly buffer IndexArray { uint indices []; };
 layout(std430, buffer_reference, buffer_reference_align = 4)
 readonly buffer MeshDataArray { MeshData meshes []; };
 
+layout(std430, buffer_reference, buffer_reference_align = 4)
+readonly buffer MaterialDataArray { MaterialData materials []; };
+
+layout(std430, buffer_reference, buffer_reference_align = 4)
+readonly buffer InstanceIndexArray { uint instanceIndices []; };
+
 struct BDA
 {
 	// These hold the addresses of the buffers
 	VertexArray vertexReference;
 	IndexArray indexReference;
 	MeshDataArray meshReference;
+	MaterialDataArray materialReference;
+	InstanceIndexArray instanceIndexReference; // Only valid for instanced draws
 	uint _pad1;
 	uint _pad2;
 };
\ No newline at end of file
@@ -1,10 +1,6 @@
-struct MeshData
+// Shared by every mesh with the same textures and material type
+struct MaterialData
 {
-	uint vertexOffset;
-	uint indexOffset;
-
-	uint modelMatrixIndex;
-
 	uint albedo;
 	uint normal;
 	uint metalness;
@@ -13,4 +9,15 @@ struct MeshData
 	uint emissive;
 
 	uint material;
+};
+
+// One per draw
+struct MeshData
+{
+	uint vertexOffset;
+	uint indexOffset;
+
+	uint modelMatrixIndex;
+
+	uint materialIndex;
 };
\ No newline at end of file
@@ -9,6 +9,7 @@ Fragment shader for
 	* Bindless textures
 	* PBR+IBL
 	* Naive forward shading (non clustered)
+	* Texture streaming feedback
 */
 
 // Include files
@@ -16,6 +17,7 @@ Fragment shader for
 #include <LightData.glsl>
 #include <PBR/PBRHeader.glsl>
 #include <PBR/PBRPushConstants.glsl>
+#include <PBR/SHIrradiance.glsl>
 #include <PBR/Hammersley.glsl>
 #include <PBR/NormalTBN.glsl>
 #include <Bindless/VertexData.glsl>
@@ -32,6 +34,9 @@ layout(location = 0) out vec4 fragColor;
 
 layout(push_constant) uniform PC { PBRPushConstant pc; };
 
+// Zero if the scene does not stream its textures
+layout(constant_id = 0) const uint TEXTURE_FEEDBACK = 0;
+
 layout(set = 0, binding = 0) uniform CameraBlock { CameraUBO camUBO; }; // UBO
 layout(set = 0, binding = 2) uniform BDABlock { BDA bda; }; // UBO
 layout(set = 0, binding = 3) readonly buffer Lights { LightData lights []; };// SSBO
@@ -43,6 +48,12 @@ layout(set = 0, binding = 6) uniform sampler2D brdfLUT;
 // NOTE This requires descriptor indexing feature
 layout(set = 0, binding = 7) uniform sampler2D pbrTextures[];
 
+layout(set = 0, binding = 8) uniform SHBlock { SHIrradianceUBO shIrradiance; }; // UBO
+
+layout(set = 0, binding = 9) buffer TextureFeedback { uint textureFeedback[]; }; // SSBO
+
+#include <Bindless/TextureFeedback.glsl>
+
 #include <PBR/Radiance.glsl>
 #include <PBR/Ambient.glsl>
 
@@ -54,8 +65,12 @@ float LinearDepth(float z, float near, float far)
 void main()
 {
 	MeshData mData = bda.meshReference.meshes[meshIndex];
+	MaterialData matData = bda.materialReference.materials[mData.materialIndex];
+
+	// Before the discard below
+	WriteTextureFeedback(matData, TextureFeedbackLod(texCoord));
 
-	vec4 albedo4 = texture(pbrTextures[nonuniformEXT(mData.albedo)], texCoord).rgba;
+	vec4 albedo4 = texture(pbrTextures[nonuniformEXT(matData.albedo)], texCoord).rgba;
 	albedo4 += vec4(vertexColor, 0.0);
 
 	// TODO This kills performance
@@ -66,11 +81,11 @@ void main()
 
 	// Material properties
 	vec3 albedo = pow(albedo4.rgb, vec3(2.2)); // Conversion from SRGB (gamma corrected) to UNORM (linear)
-	vec3 emissive = texture(pbrTextures[nonuniformEXT(mData.emissive)], texCoord).rgb;
-	vec3 texNormalValue = texture(pbrTextures[nonuniformEXT(mData.normal)], texCoord).xyz * 2.0 - 1.0;
-	float metallic = texture(pbrTextures[nonuniformEXT(mData.metalness)], texCoord).b;
-	float roughness = texture(pbrTextures[nonuniformEXT(mData.roughness)], texCoord).g;
-	float ao = texture(pbrTextures[nonuniformEXT(mData.ao)], texCoord).r;
+	vec3 emissive = texture(pbrTextures[nonuniformEXT(matData.emissive)], texCoord).rgb;
+	vec3 texNormalValue = texture(pbrTextures[nonuniformEXT(matData.normal)], texCoord).xyz * 2.0 - 1.0;
+	float metallic = texture(pbrTextures[nonuniformEXT(matData.metalness)], texCoord).b;
+	float roughness = texture(pbrTextures[nonuniformEXT(matData.roughness)], texCoord).g;
+	float ao = texture(pbrTextures[nonuniformEXT(matData.ao)], texCoord).r;
 	float alphaRoughness = AlphaDirectLighting(roughness);
 
 	// Input lighting data
@@ -20,9 +20,13 @@ layout(set = 0, binding = 0) uniform CameraBlock { CameraUBO camUBO; }; // UBO
 layout(set = 0, binding = 1) readonly buffer ModelUBOs { ModelUBO modelUBOs[]; }; // SSBO
 layout(set = 0, binding = 2) uniform BDABlock { BDA bda; }; // UBO
 
+// One draw per mesh, gl_InstanceIndex includes firstInstance so it points into the list of the mesh
+layout(constant_id = 1) const uint INSTANCED_DRAWS = 0;
+
 void main()
 {
-	MeshData meshData = bda.meshReference.meshes[gl_BaseInstance];
+	uint slot = INSTANCED_DRAWS > 0 ? bda.instanceIndexReference.instanceIndices[gl_InstanceIndex] : gl_BaseInstance;
+	MeshData meshData = bda.meshReference.meshes[slot];
 	uint vOffset = meshData.vertexOffset;
 	uint iOffset = meshData.indexOffset;
 	uint vIndex = bda.indexReference.indices[iOffset + gl_VertexIndex] + vOffset;
@@ -35,6 +39,6 @@ void main()
 	texCoord = vec2(vertexData.uvX,vertexData.uvY);
 	normal = normalMatrix * vertexData.normal;
 	vertexColor = vertexData.color.xyz;
-	meshIndex = gl_BaseInstance;
+	meshIndex = slot;
 	gl_Position =  camUBO.projection * camUBO.view * vec4(worldPos, 1.0);
 }
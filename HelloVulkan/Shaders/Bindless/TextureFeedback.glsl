@@ -0,0 +1,32 @@
+// Texture streaming feedback, decoded by TextureStreamer::ReadFeedback()
+// Needs textureFeedback[] and TEXTURE_FEEDBACK declared before this file is included
+
+const float FEEDBACK_LOD_OFFSET = 32.0;
+const float FEEDBACK_LOD_SCALE = 256.0;
+
+// Mip level of a 1x1 texture so it does not depend on the resident size of the texture,
+// has to be called in uniform control flow because of the derivatives
+float TextureFeedbackLod(vec2 uv)
+{
+	vec2 dx = dFdx(uv);
+	vec2 dy = dFdy(uv);
+	return 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-20));
+}
+
+// Only one pixel in a 4x4 block writes to keep the atomics cheap
+void WriteTextureFeedback(MaterialData matData, float uvLod)
+{
+	uvec2 p = uvec2(gl_FragCoord.xy);
+	if (TEXTURE_FEEDBACK == 0u || ((p.x | p.y) & 3u) != 0u)
+	{
+		return;
+	}
+
+	uint value = uint(clamp((uvLod + FEEDBACK_LOD_OFFSET) * FEEDBACK_LOD_SCALE, 0.0, 65535.0));
+	atomicMin(textureFeedback[matData.albedo], value);
+	atomicMin(textureFeedback[matData.normal], value);
+	atomicMin(textureFeedback[matData.metalness], value);
+	atomicMin(textureFeedback[matData.roughness], value);
+	atomicMin(textureFeedback[matData.ao], value);
+	atomicMin(textureFeedback[matData.emissive], value);
+}
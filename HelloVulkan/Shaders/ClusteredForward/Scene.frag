@@ -15,6 +15,7 @@ Fragment shader for PBR+IBL, naive forward shading (non clustered)
 #include <LightData.glsl>
 #include <PBR/PBRHeader.glsl>
 #include <PBR/PBRPushConstants.glsl>
+#include <PBR/SHIrradiance.glsl>
 #include <PBR/Hammersley.glsl>
 #include <PBR/NormalTBN.glsl>
 #include <ClusteredForward/Header.glsl>
@@ -48,6 +49,8 @@ layout(set = 0, binding = 9) uniform sampler2D brdfLUT;
 
 layout(set = 0, binding = 10) uniform sampler2D pbrTextures[] ;
 
+layout(set = 0, binding = 11) uniform SHBlock { SHIrradianceUBO shIrradiance; }; // UBO
+
 #include <ClusteredForward/Radiance.glsl>
 #include <PBR/Ambient.glsl>
 
@@ -79,9 +82,10 @@ void main()
 
 	// Buffer device address
 	MeshData mData = bda.meshReference.meshes[meshIndex];
+	MaterialData matData = bda.materialReference.materials[mData.materialIndex];
 
 	// PBR + IBL
-	vec4 albedo4 = texture(pbrTextures[nonuniformEXT(mData.albedo)], texCoord).rgba;
+	vec4 albedo4 = texture(pbrTextures[nonuniformEXT(matData.albedo)], texCoord).rgba;
 
 	// A performance trick by using a use specialization constant
 	// so this part will be removed if material type is not transparent
@@ -95,11 +99,11 @@ void main()
 
 	// PBR + IBL, Material properties
 	vec3 albedo = pow(albedo4.rgb, vec3(2.2)); // Conversion from SRGB (gamma corrected) to UNORM (linear)
-	vec3 emissive = texture(pbrTextures[nonuniformEXT(mData.emissive)], texCoord).rgb;
-	vec3 texNormalValue = texture(pbrTextures[nonuniformEXT(mData.normal)], texCoord).xyz * 2.0 - 1.0;
-	float metallic = texture(pbrTextures[nonuniformEXT(mData.metalness)], texCoord).b;
-	float roughness = texture(pbrTextures[nonuniformEXT(mData.roughness)], texCoord).g;
-	float ao = texture(pbrTextures[nonuniformEXT(mData.ao)], texCoord).r;
+	vec3 emissive = texture(pbrTextures[nonuniformEXT(matData.emissive)], texCoord).rgb;
+	vec3 texNormalValue = texture(pbrTextures[nonuniformEXT(matData.normal)], texCoord).xyz * 2.0 - 1.0;
+	float metallic = texture(pbrTextures[nonuniformEXT(matData.metalness)], texCoord).b;
+	float roughness = texture(pbrTextures[nonuniformEXT(matData.roughness)], texCoord).g;
+	float ao = texture(pbrTextures[nonuniformEXT(matData.ao)], texCoord).r;
 	float alphaRoughness = AlphaDirectLighting(roughness);
 
 	// Input lighting data
@@ -15,6 +15,7 @@ layout(location = 4) in flat uint meshIndex;
 
 layout(location = 0) out vec4 gPosition;
 layout(location = 1) out vec3 gNormal;
+layout(location = 2) out uint gInstanceID; // Discarded if the G-buffer has no instance ID attachment
 
 layout(set = 0, binding = 0) uniform CameraBlock { CameraUBO camUBO; }; // UBO
 layout(set = 0, binding = 2) uniform BDABlock { BDA bda; }; // UBO
@@ -28,7 +29,8 @@ float LinearDepth(float z, float near, float far)
 void main()
 {
 	MeshData mData = bda.meshReference.meshes[meshIndex];
-	float alpha = texture(pbrTextures[nonuniformEXT(mData.albedo)], texCoord).a;
+	MaterialData matData = bda.materialReference.materials[mData.materialIndex];
+	float alpha = texture(pbrTextures[nonuniformEXT(matData.albedo)], texCoord).a;
 	if (alpha < 0.5)
 	{
 		discard;
@@ -37,4 +39,5 @@ void main()
 	// TODO gl_FragCoord.z is always 1.0 for some reason
 	gPosition = vec4(viewPos, LinearDepth(fragPos.z, camUBO.cameraNear, camUBO.cameraFar));
 	gNormal = normalize(normal) * 0.5 + 0.5;
+	gInstanceID = meshIndex + 1; // Zero is reserved for no instance
 }
\ No newline at end of file
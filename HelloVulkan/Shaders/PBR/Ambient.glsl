@@ -15,7 +15,16 @@ vec3 Ambient(
 	vec3 kD = 1.0 - kS;
 	kD *= 1.0 - metallic;
 
-	vec3 irradiance = texture(diffuseMap, N).rgb;
+	// Spherical harmonics save a cubemap fetch, enabled is the same for every pixel
+	vec3 irradiance;
+	if (shIrradiance.enabled == 1u)
+	{
+		irradiance = EvaluateSH(shIrradiance.coefficients, N);
+	}
+	else
+	{
+		irradiance = texture(diffuseMap, N).rgb;
+	}
 	vec3 diffuse = irradiance * albedo;
 
 	// Sample both the pre-filter map and the BRDF lut and combine them together as
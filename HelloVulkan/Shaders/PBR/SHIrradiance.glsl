@@ -0,0 +1,35 @@
+// Diffuse irradiance as 9 spherical harmonics coefficients (L2)
+// The coefficients already include the cosine lobe convolution and the division by PI,
+// so EvaluateSH() returns the same value as the diffuse cubemap.
+// https://cseweb.ucsd.edu/~ravir/papers/envmap/envmap.pdf
+struct SHIrradianceUBO
+{
+	vec4 coefficients[9];
+	uint enabled;
+};
+
+void SHBasis(vec3 d, out float Y[9])
+{
+	Y[0] = 0.282095;
+	Y[1] = 0.488603 * d.y;
+	Y[2] = 0.488603 * d.z;
+	Y[3] = 0.488603 * d.x;
+	Y[4] = 1.092548 * d.x * d.y;
+	Y[5] = 1.092548 * d.y * d.z;
+	Y[6] = 0.315392 * (3.0 * d.z * d.z - 1.0);
+	Y[7] = 1.092548 * d.x * d.z;
+	Y[8] = 0.546274 * (d.x * d.x - d.y * d.y);
+}
+
+vec3 EvaluateSH(vec4 coefficients[9], vec3 N)
+{
+	float Y[9];
+	SHBasis(N, Y);
+
+	vec3 irradiance = vec3(0.0);
+	for (int i = 0; i < 9; ++i)
+	{
+		irradiance += coefficients[i].rgb * Y[i];
+	}
+	return max(irradiance, vec3(0.0));
+}
@@ -21,6 +21,7 @@ Fragment shader for
 #include <LightData.glsl>
 #include <PBR/PBRHeader.glsl>
 #include <PBR/PBRPushConstants.glsl>
+#include <PBR/SHIrradiance.glsl>
 #include <PBR/Hammersley.glsl>
 #include <PBR/NormalTBN.glsl>
 #include <Bindless/VertexData.glsl>
@@ -55,6 +56,8 @@ layout(set = 0, binding = 9) uniform sampler2D ssaoTex;
 // NOTE This requires descriptor indexing feature
 layout(set = 0, binding = 10) uniform sampler2D pbrTextures[];
 
+layout(set = 0, binding = 11) uniform SHBlock { SHIrradianceUBO shIrradiance; }; // UBO
+
 // PCF or Poisson
 #include <ShadowMapping/Shadow.glsl>
 
@@ -66,8 +69,9 @@ void main()
 {
 	// This uses buffer device address
 	MeshData mData = bda.meshReference.meshes[meshIndex];
+	MaterialData matData = bda.materialReference.materials[mData.materialIndex];
 
-	vec4 albedo4 = texture(pbrTextures[nonuniformEXT(mData.albedo)], texCoord).rgba;
+	vec4 albedo4 = texture(pbrTextures[nonuniformEXT(matData.albedo)], texCoord).rgba;
 
 	// A performance trick by using a use specialization constant
 	// so this part will be removed if material type is not transparent
@@ -81,11 +85,11 @@ void main()
 
 	// Material properties
 	vec3 albedo = pow(albedo4.rgb, vec3(2.2)); // Conversion from SRGB (gamma corrected) to UNORM (linear)
-	vec3 emissive = texture(pbrTextures[nonuniformEXT(mData.emissive)], texCoord).rgb;
-	vec3 texNormalValue = texture(pbrTextures[nonuniformEXT(mData.normal)], texCoord).xyz * 2.0 - 1.0;
-	float metallic = texture(pbrTextures[nonuniformEXT(mData.metalness)], texCoord).b;
-	float roughness = texture(pbrTextures[nonuniformEXT(mData.roughness)], texCoord).g;
-	float ao = texture(pbrTextures[nonuniformEXT(mData.ao)], texCoord).r;
+	vec3 emissive = texture(pbrTextures[nonuniformEXT(matData.emissive)], texCoord).rgb;
+	vec3 texNormalValue = texture(pbrTextures[nonuniformEXT(matData.normal)], texCoord).xyz * 2.0 - 1.0;
+	float metallic = texture(pbrTextures[nonuniformEXT(matData.metalness)], texCoord).b;
+	float roughness = texture(pbrTextures[nonuniformEXT(matData.roughness)], texCoord).g;
+	float ao = texture(pbrTextures[nonuniformEXT(matData.ao)], texCoord).r;
 	float alphaRoughness = AlphaDirectLighting(roughness);
 
 	// SSAO
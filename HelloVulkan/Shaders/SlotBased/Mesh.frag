@@ -11,6 +11,7 @@ Fragment shader for PBR+IBL, naive forward shading (non clustered)
 #include <CameraUBO.glsl>
 #include <PBR/PBRHeader.glsl>
 #include <PBR/PBRPushConstants.glsl>
+#include <PBR/SHIrradiance.glsl>
 #include <PBR/Hammersley.glsl>
 #include <PBR/NormalTBN.glsl>
 
@@ -35,6 +36,8 @@ layout(set = 0, binding = 9) uniform samplerCube specularMap;
 layout(set = 0, binding = 10) uniform samplerCube diffuseMap;
 layout(set = 0, binding = 11) uniform sampler2D brdfLUT;
 
+layout(set = 0, binding = 12) uniform SHBlock { SHIrradianceUBO shIrradiance; }; // UBO
+
 #include <PBR/Radiance.glsl>
 #include <PBR/Ambient.glsl>
 
@@ -2,6 +2,7 @@
 #include "Configs.h"
 #include "ResourcesShared.h"
 #include "VulkanCheck.h"
+#include "Scene.h"
 
 #include "volk.h"
 #include "imgui_impl_vulkan.h"
@@ -33,6 +34,14 @@ void AppBase::InitVulkan(ContextConfig config)
 	vulkanContext_.Create(vulkanInstance_, config);
 }
 
+void AppBase::InitShaderHotReload()
+{
+	if constexpr (AppConfig::ShaderHotReload)
+	{
+		pipelineHotReload_.Start(vulkanContext_, pipelines_);
+	}
+}
+
 void AppBase::InitGLSLang()
 {
 	glslang_initialize_process();
@@ -93,6 +102,9 @@ void AppBase::InitGLFW()
 // TODO Analyze this function for possible performance improvement
 void AppBase::DrawFrame()
 {
+	// Swap in pipelines whose shaders were edited
+	pipelineHotReload_.ApplyChanges(vulkanContext_);
+
 	FrameData& frameData = vulkanContext_.GetCurrentFrameData();
 	{
 		ZoneScopedNC("WaitForFences", tracy::Color::GreenYellow);
@@ -156,6 +168,7 @@ void AppBase::DrawFrame()
 			.pSignalSemaphores = &(frameData.graphicsQueueSemaphore_)
 		};
 	
+		const auto queueLock = vulkanContext_.LockQueues();
 		VK_CHECK(vkQueueSubmit(vulkanContext_.GetGraphicsQueue(), 1, &submitInfo, frameData.queueSubmitFence_));
 	}
 	
@@ -174,7 +187,11 @@ void AppBase::DrawFrame()
 			.pImageIndices = &swapchainImageIndex
 		};
 
-		VkResult result = vkQueuePresentKHR(vulkanContext_.GetGraphicsQueue(), &presentInfo);
+		VkResult result = VK_SUCCESS;
+		{
+			const auto queueLock = vulkanContext_.LockQueues();
+			result = vkQueuePresentKHR(vulkanContext_.GetGraphicsQueue(), &presentInfo);
+		}
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || shouldRecreateSwapchain_)
 		{
 			OnWindowResized();
@@ -228,6 +245,19 @@ void AppBase::FillCommandBuffer(VkCommandBuffer commandBuffer)
 	VK_CHECK(vkEndCommandBuffer(commandBuffer));
 }
 
+void AppBase::UpdateScene(Scene* scene)
+{
+	if (!scene->Update(vulkanContext_))
+	{
+		return;
+	}
+
+	for (const auto& pip : pipelines_)
+	{
+		pip->OnSceneUpdated(vulkanContext_);
+	}
+}
+
 // Recreate resources when window is resized
 void AppBase::OnWindowResized()
 {
@@ -240,7 +270,10 @@ void AppBase::OnWindowResized()
 		glfwWaitEvents();
 	}
 
-	vkDeviceWaitIdle(vulkanContext_.GetDevice());
+	{
+		const auto queueLock = vulkanContext_.LockQueues();
+		vkDeviceWaitIdle(vulkanContext_.GetDevice());
+	}
 
 	vulkanContext_.RecreateSwapchainResources(
 		vulkanInstance_,
@@ -282,6 +315,7 @@ bool AppBase::StillRunning()
 {
 	if (glfwWindowShouldClose(glfwWindow_))
 	{
+		const auto queueLock = vulkanContext_.LockQueues();
 		vkDeviceWaitIdle(vulkanContext_.GetDevice());
 		return false;
 	}
@@ -293,8 +327,34 @@ void AppBase::PollEvents()
 	glfwPollEvents();
 }
 
+void AppBase::WaitForPipelines()
+{
+	// Wait for all of them before rethrowing so no worker is left running
+	std::exception_ptr exception{};
+	for (PendingPipeline& pending : pendingPipelines_)
+	{
+		try
+		{
+			pipelines_[pending.index_] = pending.future_.get();
+			pending.setPtr_(pipelines_[pending.index_].get());
+		}
+		catch (...)
+		{
+			if (!exception) { exception = std::current_exception(); }
+		}
+	}
+	pendingPipelines_.clear();
+
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+}
+
 void AppBase::DestroyResources()
 {
+	pipelineHotReload_.Stop();
+
 	for (auto& res : resources_) { res.reset(); }
 	for (auto& pip : pipelines_) { pip.reset(); }
 
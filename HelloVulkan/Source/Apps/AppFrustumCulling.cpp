@@ -32,35 +32,38 @@ void AppFrustumCulling::Init()
 	InitScene();
 
 	// Pipelines
-	AddPipeline<PipelineClear>(vulkanContext_); // This is responsible to clear swapchain image
-	AddPipeline<PipelineSkybox>(
+	AddPipelineAsync<PipelineClear>(nullptr, vulkanContext_); // This is responsible to clear swapchain image
+	AddPipelineAsync<PipelineSkybox>(nullptr,
 		vulkanContext_,
 		&(resourcesIBL_->diffuseCubemap_),
 		resourcesShared_,
 		// This is the first offscreen render pass so we need to clear the color attachment and depth attachment
 		RenderPassBit::ColorClear | RenderPassBit::DepthClear);
-	cullingPtr_ = AddPipeline<PipelineFrustumCulling>(vulkanContext_, scene_.get());
-	pbrPtr_ = AddPipeline<PipelinePBRBindless>(
+	AddPipelineAsync<PipelineFrustumCulling>(&cullingPtr_, vulkanContext_, scene_.get());
+	AddPipelineAsync<PipelinePBRBindless>(&pbrPtr_,
 		vulkanContext_,
 		scene_.get(),
 		resourcesLight_,
 		resourcesIBL_,
 		resourcesShared_,
 		false);
-	infGridPtr_ = AddPipeline<PipelineInfiniteGrid>(vulkanContext_, resourcesShared_, 0.0f);
-	boxRenderPtr_ = AddPipeline<PipelineAABBRender>(vulkanContext_, resourcesShared_, scene_.get());
-	linePtr_ = AddPipeline<PipelineLine>(vulkanContext_, resourcesShared_, scene_.get());
-	lightPtr_ = AddPipeline<PipelineLightRender>(
+	AddPipelineAsync<PipelineInfiniteGrid>(&infGridPtr_, vulkanContext_, resourcesShared_, 0.0f);
+	AddPipelineAsync<PipelineAABBRender>(&boxRenderPtr_, vulkanContext_, resourcesShared_, scene_.get());
+	AddPipelineAsync<PipelineLine>(&linePtr_, vulkanContext_, resourcesShared_, scene_.get());
+	AddPipelineAsync<PipelineLightRender>(&lightPtr_,
 		vulkanContext_,
 		resourcesLight_,
 		resourcesShared_);
 	// Resolve multiSampledColorImage_ to singleSampledColorImage_
-	AddPipeline<PipelineResolveMS>(vulkanContext_, resourcesShared_);
+	AddPipelineAsync<PipelineResolveMS>(nullptr, vulkanContext_, resourcesShared_);
 	// This is on-screen render pass that transfers singleSampledColorImage_ to swapchain image
-	AddPipeline<PipelineTonemap>(vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
+	AddPipelineAsync<PipelineTonemap>(nullptr, vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
 	imguiPtr_ = AddPipeline<PipelineImGui>(vulkanContext_, vulkanInstance_.GetInstance(), glfwWindow_, scene_.get(), camera_.get());
 	// Present swapchain image
-	AddPipeline<PipelineFinish>(vulkanContext_);
+	AddPipelineAsync<PipelineFinish>(nullptr, vulkanContext_);
+
+	// Pipelines are created on worker threads, wait for all of them
+	WaitForPipelines();
 }
 
 void AppFrustumCulling::InitScene()
@@ -76,6 +79,8 @@ void AppFrustumCulling::InitScene()
 		.playAnimation = false
 	}};
 	scene_ = std::make_unique<Scene>(vulkanContext_, dataArray);
+	// Every copy of a Zaku mesh is one instance of the same draw
+	scene_->EnableInstancedDraws(vulkanContext_);
 	uint32_t iter = 0;
 
 	for (uint32_t x = 0; x < xCount; ++x)
@@ -134,6 +139,8 @@ void AppFrustumCulling::UpdateUI()
 
 void AppFrustumCulling::UpdateUBOs()
 {
+	scene_->UploadModelMatrices(vulkanContext_);
+
 	CameraUBO ubo = camera_->GetCameraUBO();
 	for (auto& pipeline : pipelines_)
 	{
@@ -159,6 +166,7 @@ void AppFrustumCulling::MainLoop()
 		.supportWideLines_ = true
 		});
 	Init();
+	InitShaderHotReload();
 
 	// Main loop
 	while (StillRunning())
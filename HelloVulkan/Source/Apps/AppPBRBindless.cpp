@@ -11,6 +11,9 @@
 #include "glm/ext.hpp"
 #include "imgui_impl_vulkan.h"
 
+// Sorting the draws waits for the device so it only happens after the camera moved this far
+constexpr float DrawSortCameraDistance = 5.0f;
+
 AppPBRBindless::AppPBRBindless()
 {
 }
@@ -40,7 +43,8 @@ void AppPBRBindless::Init()
 			.playAnimation = false
 		},
 	};
-	scene_ = std::make_unique<Scene>(vulkanContext_, dataArray);
+	scene_ = std::make_unique<Scene>(vulkanContext_, dataArray, true); // Loaded in the background
+	scene_->EnableTextureStreaming(vulkanContext_);
 
 	// Tachikoma model matrix
 	glm::mat4 modelMatrix(1.f);
@@ -49,32 +53,35 @@ void AppPBRBindless::Init()
 	scene_->UpdateModelMatrix(vulkanContext_, { .model = modelMatrix }, 1, 0);
 
 	// Pipelines
-	AddPipeline<PipelineClear>(vulkanContext_); // This is responsible to clear swapchain image
+	AddPipelineAsync<PipelineClear>(nullptr, vulkanContext_); // This is responsible to clear swapchain image
 	// This draws a cube
-	AddPipeline<PipelineSkybox>(
+	AddPipelineAsync<PipelineSkybox>(nullptr,
 		vulkanContext_,
 		&(resourcesIBL_->diffuseCubemap_),
 		resourcesShared_,
 		// This is the first offscreen render pass so we need to clear the color attachment and depth attachment
 		RenderPassBit::ColorClear | RenderPassBit::DepthClear);
-	pbrPtr_ = AddPipeline<PipelinePBRBindless>(
+	AddPipelineAsync<PipelinePBRBindless>(&pbrPtr_,
 		vulkanContext_,
 		scene_.get(),
 		resourcesLight_,
 		resourcesIBL_,
 		resourcesShared_,
 		false);
-	lightPtr_ = AddPipeline<PipelineLightRender>(
+	AddPipelineAsync<PipelineLightRender>(&lightPtr_,
 		vulkanContext_,
 		resourcesLight_,
 		resourcesShared_);
 	// Resolve multiSampledColorImage_ to singleSampledColorImage_
-	AddPipeline<PipelineResolveMS>(vulkanContext_, resourcesShared_);
+	AddPipelineAsync<PipelineResolveMS>(nullptr, vulkanContext_, resourcesShared_);
 	// This is on-screen render pass that transfers singleSampledColorImage_ to swapchain image
-	AddPipeline<PipelineTonemap>(vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
+	AddPipelineAsync<PipelineTonemap>(nullptr, vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
 	imguiPtr_ = AddPipeline<PipelineImGui>(vulkanContext_, vulkanInstance_.GetInstance(), glfwWindow_);
 	// Present swapchain image
-	AddPipeline<PipelineFinish>(vulkanContext_);
+	AddPipelineAsync<PipelineFinish>(nullptr, vulkanContext_);
+
+	// Pipelines are created on worker threads, wait for all of them
+	WaitForPipelines();
 }
 
 void AppPBRBindless::InitLights()
@@ -102,7 +109,14 @@ void AppPBRBindless::UpdateUI()
 	imguiPtr_->ImGuiSetWindow("Bindless Textures", 450, 350);
 	imguiPtr_->ImGuiShowFrameData(&frameCounter_);
 	ImGui::Text("Triangle Count: %i", scene_->triangleCount_);
+	if (scene_->IsLoading())
+	{
+		ImGui::Text("Loading scene...");
+	}
+	ImGui::Text("Resident Textures: %.1f MB",
+		static_cast<double>(scene_->GetTextureStreamer()->GetResidentSize()) / (1024.0 * 1024.0));
 	ImGui::Checkbox("Render Lights", &uiData_.renderLights_);
+	UpdateInstanceUI();
 	imguiPtr_->ImGuiShowPBRConfig(&uiData_.pbrPC_, resourcesIBL_->cubemapMipmapCount_);
 	imguiPtr_->ImGuiEnd();
 
@@ -112,8 +126,45 @@ void AppPBRBindless::UpdateUI()
 	}
 }
 
+// Runtime instances, the scene applies the changes in UpdateScene()
+void AppPBRBindless::UpdateInstanceUI()
+{
+	ImGui::BeginDisabled(!scene_->CanEditInstances());
+	if (ImGui::Button("Add Tachikoma"))
+	{
+		glm::mat4 modelMatrix(1.f);
+		modelMatrix = glm::translate(modelMatrix, glm::vec3(-1.5f + 0.5f * static_cast<float>(addedInstances_.size() % 7), 0.62f, 1.0f));
+		const int instanceIndex = scene_->AddModelInstance(1, modelMatrix);
+		if (instanceIndex >= 0)
+		{
+			addedInstances_.push_back(static_cast<uint32_t>(instanceIndex));
+		}
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Remove Tachikoma") && !addedInstances_.empty())
+	{
+		scene_->RemoveModelInstance(1, addedInstances_.back());
+		addedInstances_.pop_back();
+	}
+	ImGui::EndDisabled();
+}
+
+void AppPBRBindless::SortDrawsIfCameraMoved()
+{
+	const glm::vec3 position = camera_->Position();
+	if ((!drawsSorted_ || glm::distance(position, drawSortPosition_) > DrawSortCameraDistance) &&
+		scene_->SortDraws(position))
+	{
+		drawSortPosition_ = position;
+		drawsSorted_ = true;
+	}
+}
+
 void AppPBRBindless::UpdateUBOs()
 {
+	scene_->UploadModelMatrices(vulkanContext_);
+	scene_->UpdateTextureStreaming(vulkanContext_);
+
 	CameraUBO ubo = camera_->GetCameraUBO();
 	for (auto& pipeline : pipelines_)
 	{
@@ -130,6 +181,7 @@ void AppPBRBindless::MainLoop()
 		.supportBindlessTextures_ = true,
 	});
 	Init();
+	InitShaderHotReload();
 
 	// Main loop
 	while (StillRunning())
@@ -137,6 +189,8 @@ void AppPBRBindless::MainLoop()
 		PollEvents();
 		ProcessTiming();
 		ProcessInput();
+		SortDrawsIfCameraMoved();
+		UpdateScene(scene_.get());
 		DrawFrame();
 	}
 
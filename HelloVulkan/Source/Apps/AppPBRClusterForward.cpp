@@ -43,16 +43,16 @@ void AppPBRClusterForward::Init()
 	scene_ = std::make_unique<Scene>(vulkanContext_, dataArray);
 
 	// Pipelines
-	AddPipeline<PipelineClear>(vulkanContext_); // This is responsible to clear swapchain image
-	AddPipeline<PipelineSkybox>(
+	AddPipelineAsync<PipelineClear>(nullptr, vulkanContext_); // This is responsible to clear swapchain image
+	AddPipelineAsync<PipelineSkybox>(nullptr,
 		vulkanContext_,
 		&(resourcesIBL_->environmentCubemap_),
 		resourcesShared_,
 		// This is the first offscreen render pass so we need to clear the color attachment and depth attachment
 		RenderPassBit::ColorClear | RenderPassBit::DepthClear);
-	aabbPtr_ = AddPipeline<PipelineAABBGenerator>(vulkanContext_, resCF_);
-	lightCullPtr_ = AddPipeline<PipelineLightCulling>(vulkanContext_, resourcesLight_, resCF_);
-	pbrOpaquePtr_ = AddPipeline<PipelinePBRClusterForward>(
+	AddPipelineAsync<PipelineAABBGenerator>(&aabbPtr_, vulkanContext_, resCF_);
+	AddPipelineAsync<PipelineLightCulling>(&lightCullPtr_, vulkanContext_, resourcesLight_, resCF_);
+	AddPipelineAsync<PipelinePBRClusterForward>(&pbrOpaquePtr_,
 		vulkanContext_,
 		scene_.get(),
 		resourcesLight_,
@@ -60,7 +60,7 @@ void AppPBRClusterForward::Init()
 		resourcesIBL_,
 		resourcesShared_,
 		MaterialType::Opaque);
-	pbrTransparentPtr_ = AddPipeline<PipelinePBRClusterForward>(
+	AddPipelineAsync<PipelinePBRClusterForward>(&pbrTransparentPtr_,
 		vulkanContext_,
 		scene_.get(),
 		resourcesLight_,
@@ -68,14 +68,17 @@ void AppPBRClusterForward::Init()
 		resourcesIBL_,
 		resourcesShared_,
 		MaterialType::Transparent);
-	lightPtr_ = AddPipeline<PipelineLightRender>(vulkanContext_, resourcesLight_, resourcesShared_);
+	AddPipelineAsync<PipelineLightRender>(&lightPtr_, vulkanContext_, resourcesLight_, resourcesShared_);
 	// Resolve multiSampledColorImage_ to singleSampledColorImage_
-	AddPipeline<PipelineResolveMS>(vulkanContext_, resourcesShared_);
+	AddPipelineAsync<PipelineResolveMS>(nullptr, vulkanContext_, resourcesShared_);
 	// This is on-screen render pass that transfers singleSampledColorImage_ to swapchain image
-	AddPipeline<PipelineTonemap>(vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
+	AddPipelineAsync<PipelineTonemap>(nullptr, vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
 	imguiPtr_ = AddPipeline<PipelineImGui>(vulkanContext_, vulkanInstance_.GetInstance(), glfwWindow_);
 	// Present swapchain image
-	AddPipeline<PipelineFinish>(vulkanContext_);
+	AddPipelineAsync<PipelineFinish>(nullptr, vulkanContext_);
+
+	// Pipelines are created on worker threads, wait for all of them
+	WaitForPipelines();
 }
 
 void AppPBRClusterForward::InitLights()
@@ -119,6 +122,8 @@ void AppPBRClusterForward::InitLights()
 
 void AppPBRClusterForward::UpdateUBOs()
 {
+	scene_->UploadModelMatrices(vulkanContext_);
+
 	// Camera UBO
 	CameraUBO ubo = camera_->GetCameraUBO();
 	for (auto& pipeline : pipelines_)
@@ -165,6 +170,7 @@ void AppPBRClusterForward::MainLoop()
 		});
 
 	Init();
+	InitShaderHotReload();
 
 	// Main loop
 	while (StillRunning())
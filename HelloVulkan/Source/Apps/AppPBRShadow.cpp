@@ -24,7 +24,7 @@ void AppPBRShadow::Init()
 	resourcesShadow_ = AddResources<ResourcesShadow>();
 	resourcesShadow_->CreateSingleShadowMap(vulkanContext_);
 
-	resourcesGBuffer_ = AddResources<ResourcesGBuffer>();
+	resourcesGBuffer_ = AddResources<ResourcesGBuffer>(true); // Instance ID for GPU picking
 	resourcesGBuffer_->Create(vulkanContext_);
 
 	InitLights();
@@ -41,7 +41,8 @@ void AppPBRShadow::Init()
 		},
 		{
 			.filename = AppConfig::ModelFolder + "Tachikoma/Tachikoma.gltf",
-			.clickable = true
+			.clickable = true,
+			.nodeHierarchy = true // The gizmo can move the parts separately
 		},
 		{
 			.filename = AppConfig::ModelFolder + "Hexapod/Hexapod.gltf",
@@ -64,18 +65,18 @@ void AppPBRShadow::Init()
 	scene_->UpdateModelMatrix(vulkanContext_, { .model = modelMatrix }, 2, 0);
 
 	// Pipelines
-	AddPipeline<PipelineClear>(vulkanContext_); // This is responsible to clear swapchain image
-	AddPipeline<PipelineSkybox>(
+	AddPipelineAsync<PipelineClear>(nullptr, vulkanContext_); // This is responsible to clear swapchain image
+	AddPipelineAsync<PipelineSkybox>(nullptr,
 		vulkanContext_,
 		&(resourcesIBL_->diffuseCubemap_),
 		resourcesShared_,
 		// This is the first offscreen render pass so we need to clear the color attachment and depth attachment
 		RenderPassBit::ColorClear | RenderPassBit::DepthClear);
-	gPtr_ = AddPipeline<PipelineGBuffer>(vulkanContext_, scene_.get(), resourcesGBuffer_);
-	ssaoPtr_ = AddPipeline<PipelineSSAO>(vulkanContext_, resourcesGBuffer_);
-	shadowPtr_ = AddPipeline<PipelineShadow>(vulkanContext_, scene_.get(), resourcesShadow_);
+	AddPipelineAsync<PipelineGBuffer>(&gPtr_, vulkanContext_, scene_.get(), resourcesGBuffer_);
+	AddPipelineAsync<PipelineSSAO>(&ssaoPtr_, vulkanContext_, resourcesGBuffer_);
+	AddPipelineAsync<PipelineShadow>(&shadowPtr_, vulkanContext_, scene_.get(), resourcesShadow_);
 	// Opaque pass
-	pbrOpaquePtr_ = AddPipeline<PipelinePBRShadow>(
+	AddPipelineAsync<PipelinePBRShadow>(&pbrOpaquePtr_,
 		vulkanContext_,
 		scene_.get(),
 		resourcesLight_,
@@ -85,7 +86,7 @@ void AppPBRShadow::Init()
 		resourcesGBuffer_,
 		MaterialType::Opaque);
 	// Transparent pass
-	pbrTransparentPtr_ = AddPipeline<PipelinePBRShadow>(
+	AddPipelineAsync<PipelinePBRShadow>(&pbrTransparentPtr_,
 		vulkanContext_,
 		scene_.get(),
 		resourcesLight_,
@@ -94,14 +95,17 @@ void AppPBRShadow::Init()
 		resourcesShared_,
 		resourcesGBuffer_,
 		MaterialType::Transparent);
-	lightPtr_ = AddPipeline<PipelineLightRender>(vulkanContext_, resourcesLight_, resourcesShared_);
+	AddPipelineAsync<PipelineLightRender>(&lightPtr_, vulkanContext_, resourcesLight_, resourcesShared_);
 	// Resolve multiSampledColorImage_ to singleSampledColorImage_
-	AddPipeline<PipelineResolveMS>(vulkanContext_, resourcesShared_);
+	AddPipelineAsync<PipelineResolveMS>(nullptr, vulkanContext_, resourcesShared_);
 	// This is on-screen render pass that transfers singleSampledColorImage_ to swapchain image
-	AddPipeline<PipelineTonemap>(vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
+	AddPipelineAsync<PipelineTonemap>(nullptr, vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
 	imguiPtr_ = AddPipeline<PipelineImGui>(vulkanContext_, vulkanInstance_.GetInstance(), glfwWindow_, scene_.get(), camera_.get());
 	// Present swapchain image
-	AddPipeline<PipelineFinish>(vulkanContext_);
+	AddPipelineAsync<PipelineFinish>(nullptr, vulkanContext_);
+
+	// Pipelines are created on worker threads, wait for all of them
+	WaitForPipelines();
 }
 
 void AppPBRShadow::InitLights()
@@ -137,6 +141,7 @@ void AppPBRShadow::UpdateUI()
 	ImGui::Text("Triangle Count: %i", scene_->triangleCount_);
 	ImGui::Checkbox("Render Lights", &uiData_.renderLights_);
 	imguiPtr_->ImGuizmoShowOption(&uiData_.gizmoMode_);
+	ImGui::Checkbox("GPU Picking", &uiData_.gpuPicking_);
 	ImGui::SeparatorText("Shading");
 	imguiPtr_->ImGuiShowPBRConfig(&uiData_.pbrPC_, resourcesIBL_->cubemapMipmapCount_);
 
@@ -174,6 +179,8 @@ void AppPBRShadow::UpdateUI()
 
 void AppPBRShadow::UpdateUBOs()
 {
+	scene_->UploadModelMatrices(vulkanContext_);
+
 	CameraUBO ubo = camera_->GetCameraUBO();
 	for (auto& pipeline : pipelines_)
 	{
@@ -193,6 +200,7 @@ void AppPBRShadow::MainLoop()
 		.supportMSAA_ = true
 		});
 	Init();
+	InitShaderHotReload();
 
 	// Main loop
 	while (StillRunning())
@@ -31,35 +31,39 @@ void AppPBRSlotBased::Init()
 	// Image-Based Lighting
 	resourcesIBL_ = AddResources<ResourcesIBL>(vulkanContext_, AppConfig::TextureFolder + "piazza_bologni_1k.hdr");
 
+	defaultTextures_.Create(vulkanContext_);
 	model_ = std::make_unique<Model>();
-	model_->LoadSlotBased(vulkanContext_, AppConfig::ModelFolder + "DamagedHelmet/DamagedHelmet.gltf");
+	model_->LoadSlotBased(vulkanContext_, &defaultTextures_, AppConfig::ModelFolder + "DamagedHelmet/DamagedHelmet.gltf");
 	model_->SetModelUBO(vulkanContext_, { .model = glm::mat4(1.0f) });
 	std::vector<Model*> models = { model_.get() };
 
 	// Pipelines have to be created in order
-	AddPipeline<PipelineClear>(vulkanContext_); // This is responsible to clear swapchain image
+	AddPipelineAsync<PipelineClear>(nullptr, vulkanContext_); // This is responsible to clear swapchain image
 	// This draws a cube
-	AddPipeline<PipelineSkybox>(
+	AddPipelineAsync<PipelineSkybox>(nullptr,
 		vulkanContext_,
 		&(resourcesIBL_->environmentCubemap_),
 		resourcesShared_,
 		// This is the first offscreen render pass so we need to clear the color attachment and depth attachment
 		RenderPassBit::ColorClear | RenderPassBit::DepthClear);
-	AddPipeline<PipelinePBRSlotBased>(
+	AddPipelineAsync<PipelinePBRSlotBased>(nullptr,
 		vulkanContext_,
 		models,
 		resourcesLights_,
 		resourcesIBL_,
 		resourcesShared_);
-	AddPipeline<PipelineInfiniteGrid>(vulkanContext_, resourcesShared_, -1.0f);
-	AddPipeline<PipelineLightRender>(vulkanContext_, resourcesLights_, resourcesShared_);
+	AddPipelineAsync<PipelineInfiniteGrid>(nullptr, vulkanContext_, resourcesShared_, -1.0f);
+	AddPipelineAsync<PipelineLightRender>(nullptr, vulkanContext_, resourcesLights_, resourcesShared_);
 	// Resolve multiSampledColorImage_ to singleSampledColorImage_
-	AddPipeline<PipelineResolveMS>(vulkanContext_, resourcesShared_);
+	AddPipelineAsync<PipelineResolveMS>(nullptr, vulkanContext_, resourcesShared_);
 	// This is on-screen render pass that transfers singleSampledColorImage_ to swapchain image
-	AddPipeline<PipelineTonemap>(vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
+	AddPipelineAsync<PipelineTonemap>(nullptr, vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
 	imguiPtr_ = AddPipeline<PipelineImGui>(vulkanContext_, vulkanInstance_.GetInstance(), glfwWindow_);
 	// Present swapchain image
-	AddPipeline<PipelineFinish>(vulkanContext_);
+	AddPipelineAsync<PipelineFinish>(nullptr, vulkanContext_);
+
+	// Pipelines are created on worker threads, wait for all of them
+	WaitForPipelines();
 }
 
 void AppPBRSlotBased::InitLights()
@@ -114,6 +118,7 @@ void AppPBRSlotBased::MainLoop()
 		.supportMSAA_ = true
 		});
 	Init();
+	InitShaderHotReload();
 
 	// Main loop
 	while (StillRunning())
@@ -125,5 +130,6 @@ void AppPBRSlotBased::MainLoop()
 	}
 
 	model_->Destroy();
+	defaultTextures_.Destroy();
 	DestroyResources();
 }
\ No newline at end of file
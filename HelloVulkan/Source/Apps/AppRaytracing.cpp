@@ -21,10 +21,13 @@ void AppRaytracing::Init()
 	};
 	scene_ = std::make_unique<Scene>(vulkanContext_, dataArray);
 
-	AddPipeline<PipelineClear>(vulkanContext_);
-	rtxPtr_ = AddPipeline<PipelineRaytracing>(vulkanContext_, scene_.get());
+	AddPipelineAsync<PipelineClear>(nullptr, vulkanContext_);
+	AddPipelineAsync<PipelineRaytracing>(&rtxPtr_, vulkanContext_, scene_.get());
 	imguiPtr_ = AddPipeline<PipelineImGui>(vulkanContext_, vulkanInstance_.GetInstance(), glfwWindow_);
-	AddPipeline<PipelineFinish>(vulkanContext_);
+	AddPipelineAsync<PipelineFinish>(nullptr, vulkanContext_);
+
+	// Pipelines are created on worker threads, wait for all of them
+	WaitForPipelines();
 
 	// Add a listener when the camera is changed
 	camera_->ChangedEvent_.AddListener([this]()
@@ -73,6 +76,8 @@ void AppRaytracing::UpdateUI()
 
 void AppRaytracing::UpdateUBOs()
 {
+	scene_->UploadModelMatrices(vulkanContext_);
+
 	rtxPtr_->SetRaytracingUBO(vulkanContext_,
 		camera_->GetInverseProjectionMatrix(),
 		camera_->GetInverseViewMatrix(),
@@ -90,6 +95,7 @@ void AppRaytracing::MainLoop()
 		});
 
 	Init();
+	InitShaderHotReload();
 
 	// Main loop
 	while (StillRunning())
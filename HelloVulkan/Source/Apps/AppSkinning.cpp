@@ -42,20 +42,20 @@ void AppSkinning::Init()
 	InitScene();
 
 	// Pipelines
-	AddPipeline<PipelineClear>(vulkanContext_); // This is responsible to clear swapchain image
+	AddPipelineAsync<PipelineClear>(nullptr, vulkanContext_); // This is responsible to clear swapchain image
 	// This draws a cube
-	AddPipeline<PipelineSkybox>(
+	AddPipelineAsync<PipelineSkybox>(nullptr,
 		vulkanContext_,
 		&(resourcesIBL_->diffuseCubemap_),
 		resourcesShared_,
 		// This is the first offscreen render pass so we need to clear the color attachment and depth attachment
 		RenderPassBit::ColorClear | RenderPassBit::DepthClear);
-	AddPipeline<PipelineSkinning>(vulkanContext_, scene_.get());
-	gPtr_ = AddPipeline<PipelineGBuffer>(vulkanContext_, scene_.get(), resourcesGBuffer_);
-	ssaoPtr_ = AddPipeline<PipelineSSAO>(vulkanContext_, resourcesGBuffer_);
-	shadowPtr_ = AddPipeline<PipelineShadow>(vulkanContext_, scene_.get(), resourcesShadow_);
+	AddPipelineAsync<PipelineSkinning>(nullptr, vulkanContext_, scene_.get());
+	AddPipelineAsync<PipelineGBuffer>(&gPtr_, vulkanContext_, scene_.get(), resourcesGBuffer_);
+	AddPipelineAsync<PipelineSSAO>(&ssaoPtr_, vulkanContext_, resourcesGBuffer_);
+	AddPipelineAsync<PipelineShadow>(&shadowPtr_, vulkanContext_, scene_.get(), resourcesShadow_);
 	// Opaque pass
-	pbrOpaquePtr_ = AddPipeline<PipelinePBRShadow>(
+	AddPipelineAsync<PipelinePBRShadow>(&pbrOpaquePtr_,
 		vulkanContext_,
 		scene_.get(),
 		resourcesLight_,
@@ -65,7 +65,7 @@ void AppSkinning::Init()
 		resourcesGBuffer_,
 		MaterialType::Opaque);
 	// Transparent pass
-	pbrTransparentPtr_ = AddPipeline<PipelinePBRShadow>(
+	AddPipelineAsync<PipelinePBRShadow>(&pbrTransparentPtr_,
 		vulkanContext_,
 		scene_.get(),
 		resourcesLight_,
@@ -74,14 +74,17 @@ void AppSkinning::Init()
 		resourcesShared_,
 		resourcesGBuffer_,
 		MaterialType::Transparent);
-	lightPtr_ = AddPipeline<PipelineLightRender>(vulkanContext_, resourcesLight_, resourcesShared_);
+	AddPipelineAsync<PipelineLightRender>(&lightPtr_, vulkanContext_, resourcesLight_, resourcesShared_);
 	// Resolve multiSampledColorImage_ to singleSampledColorImage_
-	AddPipeline<PipelineResolveMS>(vulkanContext_, resourcesShared_);
+	AddPipelineAsync<PipelineResolveMS>(nullptr, vulkanContext_, resourcesShared_);
 	// This is on-screen render pass that transfers singleSampledColorImage_ to swapchain image
-	AddPipeline<PipelineTonemap>(vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
+	AddPipelineAsync<PipelineTonemap>(nullptr, vulkanContext_, &(resourcesShared_->singleSampledColorImage_));
 	imguiPtr_ = AddPipeline<PipelineImGui>(vulkanContext_, vulkanInstance_.GetInstance(), glfwWindow_, scene_.get(), camera_.get());
 	// Present swapchain image
-	AddPipeline<PipelineFinish>(vulkanContext_);
+	AddPipelineAsync<PipelineFinish>(nullptr, vulkanContext_);
+
+	// Pipelines are created on worker threads, wait for all of them
+	WaitForPipelines();
 }
 
 void AppSkinning::InitScene()
@@ -199,6 +202,7 @@ void AppSkinning::UpdateUI()
 
 void AppSkinning::UpdateUBOs()
 {
+	scene_->UploadModelMatrices(vulkanContext_);
 	scene_->UpdateAnimation(vulkanContext_, frameCounter_.GetDeltaSecond());
 
 	CameraUBO ubo = camera_->GetCameraUBO();
@@ -221,6 +225,7 @@ void AppSkinning::MainLoop()
 		.supportBindlessTextures_ = true,
 	});
 	Init();
+	InitShaderHotReload();
 
 	// Main loop
 	while (StillRunning())
@@ -0,0 +1,205 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <numeric>
+
+constexpr uint32_t BVHBinCount = 12;
+// Nodes up to this size stay leaves if splitting does not lower the SAH cost, larger nodes are
+// always split unless their centroids cannot be separated
+constexpr uint32_t BVHMaxLeafSize = 4;
+
+struct BVHBin
+{
+	glm::vec3 min_{ std::numeric_limits<float>::max() };
+	glm::vec3 max_{ std::numeric_limits<float>::lowest() };
+	uint32_t count_ = 0;
+};
+
+static float SurfaceArea(const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+	const glm::vec3 e = glm::max(boxMax - boxMin, glm::vec3(0.0f));
+	return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+void BVH::Build(std::span<const BoundingBox> primitiveBoxes)
+{
+	nodes_.clear();
+	primitiveIndices_.clear();
+	const uint32_t primitiveCount = static_cast<uint32_t>(primitiveBoxes.size());
+	if (primitiveCount == 0)
+	{
+		return;
+	}
+
+	primitiveIndices_.resize(primitiveCount);
+	std::iota(primitiveIndices_.begin(), primitiveIndices_.end(), 0u);
+
+	std::vector<glm::vec3> centroids(primitiveCount);
+	for (uint32_t i = 0; i < primitiveCount; ++i)
+	{
+		centroids[i] = primitiveBoxes[i].GetCenter();
+	}
+
+	// A binary tree with one primitive per leaf has 2n - 1 nodes, no reallocation while subdividing
+	nodes_.reserve(2 * static_cast<size_t>(primitiveCount) - 1);
+	nodes_.push_back({ .leftFirst_ = 0, .primitiveCount_ = primitiveCount });
+	UpdateNodeBounds(0, primitiveBoxes);
+	Subdivide(0, primitiveBoxes, centroids);
+}
+
+void BVH::Refit(std::span<const BoundingBox> primitiveBoxes)
+{
+	// Children come after their parent
+	for (size_t i = nodes_.size(); i-- > 0;)
+	{
+		BVHNode& node = nodes_[i];
+		if (node.primitiveCount_ > 0)
+		{
+			UpdateNodeBounds(static_cast<uint32_t>(i), primitiveBoxes);
+			continue;
+		}
+		const BVHNode& left = nodes_[node.leftFirst_];
+		const BVHNode& right = nodes_[node.leftFirst_ + 1];
+		node.min_ = glm::min(left.min_, right.min_);
+		node.max_ = glm::max(left.max_, right.max_);
+	}
+}
+
+void BVH::UpdateNodeBounds(uint32_t nodeIndex, std::span<const BoundingBox> primitiveBoxes)
+{
+	BVHNode& node = nodes_[nodeIndex];
+	node.min_ = glm::vec3(std::numeric_limits<float>::max());
+	node.max_ = glm::vec3(std::numeric_limits<float>::lowest());
+	for (uint32_t i = 0; i < node.primitiveCount_; ++i)
+	{
+		const BoundingBox& box = primitiveBoxes[primitiveIndices_[node.leftFirst_ + i]];
+		node.min_ = glm::min(node.min_, glm::vec3(box.min_));
+		node.max_ = glm::max(node.max_, glm::vec3(box.max_));
+	}
+}
+
+// Binned SAH, see "On fast Construction of SAH-based Bounding Volume Hierarchies" by Ingo Wald
+void BVH::Subdivide(uint32_t nodeIndex, std::span<const BoundingBox> primitiveBoxes, std::span<const glm::vec3> centroids)
+{
+	const uint32_t first = nodes_[nodeIndex].leftFirst_;
+	const uint32_t count = nodes_[nodeIndex].primitiveCount_;
+	if (count <= 1)
+	{
+		return;
+	}
+
+	// Bins are placed over the centroids, not over the node bounds
+	glm::vec3 centroidMin(std::numeric_limits<float>::max());
+	glm::vec3 centroidMax(std::numeric_limits<float>::lowest());
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const glm::vec3& c = centroids[primitiveIndices_[first + i]];
+		centroidMin = glm::min(centroidMin, c);
+		centroidMax = glm::max(centroidMax, c);
+	}
+
+	float bestCost = std::numeric_limits<float>::max();
+	int bestAxis = -1;
+	uint32_t bestSplit = 0;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+
+		std::array<BVHBin, BVHBinCount> bins{};
+		const float scale = static_cast<float>(BVHBinCount) / extent;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const uint32_t primitiveIndex = primitiveIndices_[first + i];
+			const uint32_t b = std::min(BVHBinCount - 1,
+				static_cast<uint32_t>((centroids[primitiveIndex][axis] - centroidMin[axis]) * scale));
+			const BoundingBox& box = primitiveBoxes[primitiveIndex];
+			bins[b].min_ = glm::min(bins[b].min_, glm::vec3(box.min_));
+			bins[b].max_ = glm::max(bins[b].max_, glm::vec3(box.max_));
+			++bins[b].count_;
+		}
+
+		// Sweep from both sides to get the area and count left and right of each split plane
+		std::array<float, BVHBinCount - 1> leftArea{};
+		std::array<uint32_t, BVHBinCount - 1> leftCount{};
+		BVHBin left{};
+		for (uint32_t i = 0; i < BVHBinCount - 1; ++i)
+		{
+			left.min_ = glm::min(left.min_, bins[i].min_);
+			left.max_ = glm::max(left.max_, bins[i].max_);
+			left.count_ += bins[i].count_;
+			leftArea[i] = left.count_ > 0 ? SurfaceArea(left.min_, left.max_) : 0.0f;
+			leftCount[i] = left.count_;
+		}
+		BVHBin right{};
+		for (uint32_t i = BVHBinCount - 1; i > 0; --i)
+		{
+			right.min_ = glm::min(right.min_, bins[i].min_);
+			right.max_ = glm::max(right.max_, bins[i].max_);
+			right.count_ += bins[i].count_;
+			const float rightArea = right.count_ > 0 ? SurfaceArea(right.min_, right.max_) : 0.0f;
+			const float cost = leftCount[i - 1] * leftArea[i - 1] + right.count_ * rightArea;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i;
+			}
+		}
+	}
+
+	// Stop if splitting is not cheaper than intersecting every primitive of the node
+	const BVHNode& node = nodes_[nodeIndex];
+	const float leafCost = static_cast<float>(count) * SurfaceArea(node.min_, node.max_);
+	if (bestAxis < 0 || (count <= BVHMaxLeafSize && bestCost >= leafCost))
+	{
+		return;
+	}
+
+	const float scale = static_cast<float>(BVHBinCount) / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	auto middle = std::partition(
+		primitiveIndices_.begin() + first,
+		primitiveIndices_.begin() + first + count,
+		[&](uint32_t primitiveIndex)
+		{
+			const uint32_t b = std::min(BVHBinCount - 1,
+				static_cast<uint32_t>((centroids[primitiveIndex][bestAxis] - centroidMin[bestAxis]) * scale));
+			return b < bestSplit;
+		});
+	const uint32_t leftCount = static_cast<uint32_t>(middle - primitiveIndices_.begin()) - first;
+	if (leftCount == 0 || leftCount == count)
+	{
+		return;
+	}
+
+	const uint32_t leftIndex = static_cast<uint32_t>(nodes_.size());
+	nodes_.push_back({ .leftFirst_ = first, .primitiveCount_ = leftCount });
+	nodes_.push_back({ .leftFirst_ = first + leftCount, .primitiveCount_ = count - leftCount });
+	nodes_[nodeIndex].leftFirst_ = leftIndex;
+	nodes_[nodeIndex].primitiveCount_ = 0;
+
+	UpdateNodeBounds(leftIndex, primitiveBoxes);
+	UpdateNodeBounds(leftIndex + 1, primitiveBoxes);
+	Subdivide(leftIndex, primitiveBoxes, centroids);
+	Subdivide(leftIndex + 1, primitiveBoxes, centroids);
+}
+
+float BVH::IntersectNode(const Ray& ray, const BVHNode& node, float closestT)
+{
+	const glm::vec3 t1 = (node.min_ - ray.origin_) * ray.dirFrac_;
+	const glm::vec3 t2 = (node.max_ - ray.origin_) * ray.dirFrac_;
+	const glm::vec3 tSmall = glm::min(t1, t2);
+	const glm::vec3 tLarge = glm::max(t1, t2);
+	const float tMin = std::max(std::max(tSmall.x, tSmall.y), tSmall.z);
+	const float tMax = std::min(std::min(tLarge.x, tLarge.y), tLarge.z);
+
+	// Same as BoundingBox::Hit(), tMin is negative if the ray starts inside the box
+	if (tMax < 0.0f || tMin > tMax || tMin >= closestT)
+	{
+		return std::numeric_limits<float>::infinity();
+	}
+	return tMin;
+}
\ No newline at end of file
@@ -31,24 +31,14 @@ BoundingBox::BoundingBox(const std::span<VertexData> vertexDataArray)
 	max_ = glm::vec4(vMax, 1.0);
 }
 
+// Same box as transforming the eight corners but without expanding them, see BoundingBoxBatch
 void BoundingBox::Transform(const glm::mat4& t)
 {
-	glm::vec3 corners[] = {
-		glm::vec3(min_.x, min_.y, min_.z),
-		glm::vec3(min_.x, max_.y, min_.z),
-		glm::vec3(min_.x, min_.y, max_.z),
-		glm::vec3(min_.x, max_.y, max_.z),
-		glm::vec3(max_.x, min_.y, min_.z),
-		glm::vec3(max_.x, max_.y, min_.z),
-		glm::vec3(max_.x, min_.y, max_.z),
-		glm::vec3(max_.x, max_.y, max_.z),
-	};
-	for (auto& v : corners)
-	{
-		v = glm::vec3(t * glm::vec4(v, 1.0f));
-	}
-
-	*this = BoundingBox(corners);
+	const glm::vec3 center = glm::vec3(t * glm::vec4(GetCenter(), 1.0f));
+	const glm::mat3 absMatrix(glm::abs(glm::vec3(t[0])), glm::abs(glm::vec3(t[1])), glm::abs(glm::vec3(t[2])));
+	const glm::vec3 extent = absMatrix * (0.5f * GetSize());
+	min_ = glm::vec4(center - extent, 1.0f);
+	max_ = glm::vec4(center + extent, 1.0f);
 }
 
 BoundingBox BoundingBox::GetTransformed(const glm::mat4& t) const
@@ -59,7 +49,7 @@ BoundingBox BoundingBox::GetTransformed(const glm::mat4& t) const
 }
 
 // gamedev.stackexchange.com/questions/18436/most-efficient-aabb-vs-ray-collision-algorithms
-bool BoundingBox::Hit(const Ray& r, float& t)
+bool BoundingBox::Hit(const Ray& r, float& t) const
 {
 	float t1 = (min_.x - r.origin_.x) * r.dirFrac_.x;
 	float t2 = (max_.x - r.origin_.x) * r.dirFrac_.x;
@@ -0,0 +1,126 @@
+#include "BoundingBoxBatch.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define BOUNDING_BOX_BATCH_SSE
+#include <xmmintrin.h>
+#endif
+
+void BoundingBoxBatch::Resize(size_t count)
+{
+	centerX_.resize(count);
+	centerY_.resize(count);
+	centerZ_.resize(count);
+	extentX_.resize(count);
+	extentY_.resize(count);
+	extentZ_.resize(count);
+}
+
+void BoundingBoxBatch::Set(size_t index, const BoundingBox& box)
+{
+	const glm::vec3 center = box.GetCenter();
+	const glm::vec3 extent = 0.5f * box.GetSize();
+	centerX_[index] = center.x;
+	centerY_[index] = center.y;
+	centerZ_[index] = center.z;
+	extentX_[index] = extent.x;
+	extentY_[index] = extent.y;
+	extentZ_[index] = extent.z;
+}
+
+void BoundingBoxBatch::Transform(
+	std::span<const uint32_t> boxIndices,
+	const glm::mat4& matrix,
+	BoundingBox* output,
+	BoundingBox* mappedOutput) const
+{
+	const size_t count = boxIndices.size();
+	size_t i = 0;
+
+#ifdef BOUNDING_BOX_BATCH_SSE
+	// Matrix elements are broadcast, each lane is a box
+	__m128 m[4][3];
+	__m128 absM[3][3];
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	for (int column = 0; column < 4; ++column)
+	{
+		for (int row = 0; row < 3; ++row)
+		{
+			m[column][row] = _mm_set1_ps(matrix[column][row]);
+			if (column < 3)
+			{
+				absM[column][row] = _mm_andnot_ps(signMask, m[column][row]);
+			}
+		}
+	}
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const uint32_t b0 = boxIndices[i];
+		const uint32_t b1 = boxIndices[i + 1];
+		const uint32_t b2 = boxIndices[i + 2];
+		const uint32_t b3 = boxIndices[i + 3];
+		const __m128 cx = _mm_setr_ps(centerX_[b0], centerX_[b1], centerX_[b2], centerX_[b3]);
+		const __m128 cy = _mm_setr_ps(centerY_[b0], centerY_[b1], centerY_[b2], centerY_[b3]);
+		const __m128 cz = _mm_setr_ps(centerZ_[b0], centerZ_[b1], centerZ_[b2], centerZ_[b3]);
+		const __m128 ex = _mm_setr_ps(extentX_[b0], extentX_[b1], extentX_[b2], extentX_[b3]);
+		const __m128 ey = _mm_setr_ps(extentY_[b0], extentY_[b1], extentY_[b2], extentY_[b3]);
+		const __m128 ez = _mm_setr_ps(extentZ_[b0], extentZ_[b1], extentZ_[b2], extentZ_[b3]);
+
+		__m128 center[3];
+		__m128 extent[3];
+		for (int row = 0; row < 3; ++row)
+		{
+			center[row] = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(m[0][row], cx), _mm_mul_ps(m[1][row], cy)),
+				_mm_add_ps(_mm_mul_ps(m[2][row], cz), m[3][row]));
+			extent[row] = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(absM[0][row], ex), _mm_mul_ps(absM[1][row], ey)),
+				_mm_mul_ps(absM[2][row], ez));
+		}
+
+		// Back to one vec4 per box
+		__m128 min0 = _mm_sub_ps(center[0], extent[0]);
+		__m128 min1 = _mm_sub_ps(center[1], extent[1]);
+		__m128 min2 = _mm_sub_ps(center[2], extent[2]);
+		__m128 min3 = one;
+		__m128 max0 = _mm_add_ps(center[0], extent[0]);
+		__m128 max1 = _mm_add_ps(center[1], extent[1]);
+		__m128 max2 = _mm_add_ps(center[2], extent[2]);
+		__m128 max3 = one;
+		_MM_TRANSPOSE4_PS(min0, min1, min2, min3);
+		_MM_TRANSPOSE4_PS(max0, max1, max2, max3);
+
+		const uint32_t boxes[4] = { b0, b1, b2, b3 };
+		const __m128 mins[4] = { min0, min1, min2, min3 };
+		const __m128 maxs[4] = { max0, max1, max2, max3 };
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			_mm_storeu_ps(&output[boxes[lane]].min_.x, mins[lane]);
+			_mm_storeu_ps(&output[boxes[lane]].max_.x, maxs[lane]);
+			if (mappedOutput)
+			{
+				_mm_storeu_ps(&mappedOutput[boxes[lane]].min_.x, mins[lane]);
+				_mm_storeu_ps(&mappedOutput[boxes[lane]].max_.x, maxs[lane]);
+			}
+		}
+	}
+#endif
+
+	// Remaining boxes, or all of them without SSE
+	const glm::mat3 absMatrix(glm::abs(glm::vec3(matrix[0])), glm::abs(glm::vec3(matrix[1])), glm::abs(glm::vec3(matrix[2])));
+	for (; i < count; ++i)
+	{
+		const uint32_t b = boxIndices[i];
+		const glm::vec3 center = glm::vec3(matrix * glm::vec4(centerX_[b], centerY_[b], centerZ_[b], 1.0f));
+		const glm::vec3 extent = absMatrix * glm::vec3(extentX_[b], extentY_[b], extentZ_[b]);
+		BoundingBox box;
+		box.min_ = glm::vec4(center - extent, 1.0f);
+		box.max_ = glm::vec4(center + extent, 1.0f);
+		output[b] = box;
+		if (mappedOutput)
+		{
+			mappedOutput[b] = box;
+		}
+	}
+}
@@ -0,0 +1,387 @@
+#include "HDRLoader.h"
+#include "Configs.h"
+#include "Utility.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/packing.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <thread>
+
+constexpr uint32_t HDRCacheVersion = 1u;
+constexpr uint32_t HDRCacheMagicNumber = 0x48524448u; // "HDRH"
+constexpr float HalfFloatMax = 65504.0f;
+
+struct HDRCacheHeader
+{
+	uint32_t magic_;
+	uint32_t version_;
+	uint32_t width_;
+	uint32_t height_;
+};
+
+// Multiplier for each RGBE exponent, same conversion as stb_image
+static const std::array<float, 256> ExponentTable = []()
+{
+	std::array<float, 256> table{};
+	for (int e = 1; e < 256; ++e)
+	{
+		table[e] = std::ldexp(1.0f, e - (128 + 8));
+	}
+	return table;
+}();
+
+// The cache is keyed by the path and the modification time so the HDR file is not read on a cache hit
+static std::string GetCacheFilePath(const std::string& filename)
+{
+	std::error_code ec;
+	const uintmax_t fileSize = std::filesystem::file_size(filename, ec);
+	if (ec)
+	{
+		return {};
+	}
+	const auto writeTime = std::filesystem::last_write_time(filename, ec);
+	if (ec)
+	{
+		return {};
+	}
+
+	const uint64_t key[] =
+	{
+		HDRCacheVersion,
+		static_cast<uint64_t>(fileSize),
+		static_cast<uint64_t>(writeTime.time_since_epoch().count())
+	};
+	uint64_t hash = Utility::Hash(filename.data(), filename.size());
+	hash = Utility::Hash(key, sizeof(key), hash);
+
+	return Utility::GetCacheFilePath(AppConfig::HDRCacheFolder, hash, ".hdrh");
+}
+
+bool HDRLoader::Open(const std::string& filename)
+{
+	filename_ = filename;
+	cached_ = false;
+	fileData_.clear();
+	scanlineOffsets_.clear();
+
+	if (AppConfig::UseHDRCache)
+	{
+		cacheFile_ = GetCacheFilePath(filename);
+		if (!cacheFile_.empty() && OpenCache())
+		{
+			cached_ = true;
+			return true;
+		}
+	}
+	return OpenFile();
+}
+
+bool HDRLoader::OpenFile()
+{
+	std::ifstream file(filename_, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	fileData_.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char*>(fileData_.data()), static_cast<std::streamsize>(fileData_.size())))
+	{
+		return false;
+	}
+
+	size_t offset = 0;
+	if (!ReadHeader(offset) || !FindScanlines(offset))
+	{
+		fileData_.clear();
+		return false;
+	}
+	return true;
+}
+
+bool HDRLoader::Load(void* output)
+{
+	if (cached_)
+	{
+		if (LoadCache(output))
+		{
+			return true;
+		}
+
+		// The cache file cannot be read, decode the HDR file instead
+		cached_ = false;
+		const uint32_t width = width_;
+		const uint32_t height = height_;
+		if (!OpenFile() || width_ != width || height_ != height)
+		{
+			return false;
+		}
+	}
+
+	if (fileData_.empty())
+	{
+		return false;
+	}
+
+	// The cache is written from host memory, reading back a mapped staging buffer can be very slow
+	std::vector<uint64_t> decoded;
+	uint64_t* pixels = static_cast<uint64_t*>(output);
+	if (!cacheFile_.empty())
+	{
+		decoded.resize(static_cast<size_t>(width_) * height_);
+		pixels = decoded.data();
+	}
+
+	// Each thread decodes a contiguous range of scanlines
+	const uint32_t threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, height_);
+	const uint32_t scanlinesPerThread = (height_ + threadCount - 1) / threadCount;
+	{
+		std::vector<std::jthread> threads;
+		threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; ++i)
+		{
+			threads.emplace_back([this, i, scanlinesPerThread, pixels]()
+			{
+				std::vector<uint8_t> rgbe(4 * static_cast<size_t>(width_));
+				const uint32_t start = i * scanlinesPerThread;
+				const uint32_t end = std::min(start + scanlinesPerThread, height_);
+				for (uint32_t y = start; y < end; ++y)
+				{
+					// Flip vertically, the first scanline is the top of the image
+					uint64_t* row = pixels + static_cast<size_t>(height_ - 1 - y) * width_;
+					DecodeScanline(y, rgbe.data(), row);
+				}
+			});
+		}
+	}
+
+	fileData_.clear();
+	fileData_.shrink_to_fit();
+
+	if (!decoded.empty())
+	{
+		SaveCache(decoded.data());
+		std::memcpy(output, decoded.data(), GetDataSize());
+	}
+	return true;
+}
+
+bool HDRLoader::OpenCache()
+{
+	std::ifstream file(cacheFile_, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	HDRCacheHeader header{};
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(HDRCacheHeader)) ||
+		header.magic_ != HDRCacheMagicNumber ||
+		header.version_ != HDRCacheVersion ||
+		header.width_ == 0 ||
+		header.height_ == 0)
+	{
+		return false;
+	}
+	width_ = header.width_;
+	height_ = header.height_;
+
+	// A truncated file is not a valid cache
+	std::error_code ec;
+	const uintmax_t fileSize = std::filesystem::file_size(cacheFile_, ec);
+	return !ec && fileSize == sizeof(HDRCacheHeader) + GetDataSize();
+}
+
+bool HDRLoader::LoadCache(void* output)
+{
+	std::ifstream file(cacheFile_, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	file.seekg(sizeof(HDRCacheHeader));
+	return static_cast<bool>(file.read(static_cast<char*>(output), static_cast<std::streamsize>(GetDataSize())));
+}
+
+void HDRLoader::SaveCache(const void* data) const
+{
+	const HDRCacheHeader header =
+	{
+		.magic_ = HDRCacheMagicNumber,
+		.version_ = HDRCacheVersion,
+		.width_ = width_,
+		.height_ = height_
+	};
+	const std::array<std::span<const char>, 2> parts =
+	{
+		std::span<const char>(reinterpret_cast<const char*>(&header), sizeof(HDRCacheHeader)),
+		std::span<const char>(static_cast<const char*>(data), GetDataSize())
+	};
+	if (!Utility::WriteFileAtomically(cacheFile_, parts))
+	{
+		std::cerr << "Cannot write HDR cache file " << cacheFile_ << '\n';
+	}
+}
+
+bool HDRLoader::ReadHeader(size_t& offset)
+{
+	// Returns false at the end of the file
+	auto readLine = [this, &offset](std::string_view& line)
+	{
+		const auto begin = fileData_.begin() + static_cast<std::ptrdiff_t>(offset);
+		const auto end = std::find(begin, fileData_.end(), static_cast<uint8_t>('\n'));
+		if (end == fileData_.end())
+		{
+			return false;
+		}
+		line = std::string_view(reinterpret_cast<const char*>(&(*begin)), static_cast<size_t>(end - begin));
+		if (line.ends_with('\r'))
+		{
+			line.remove_suffix(1);
+		}
+		offset += static_cast<size_t>(end - begin) + 1;
+		return true;
+	};
+
+	std::string_view line;
+	if (!readLine(line) || !(line.starts_with("#?RADIANCE") || line.starts_with("#?RGBE")))
+	{
+		return false;
+	}
+
+	// Variables end with an empty line, only the pixel format matters
+	while (true)
+	{
+		if (!readLine(line))
+		{
+			return false;
+		}
+		if (line.empty())
+		{
+			break;
+		}
+		if (line.starts_with("FORMAT=") && line != "FORMAT=32-bit_rle_rgbe")
+		{
+			return false;
+		}
+	}
+
+	// Resolution string, rows from top to bottom and columns from left to right
+	if (!readLine(line))
+	{
+		return false;
+	}
+	const std::string resolution(line);
+	int height = 0;
+	int width = 0;
+	if (sscanf(resolution.c_str(), "-Y %d +X %d", &height, &width) != 2)
+	{
+		return false;
+	}
+
+	// New style RLE is only used for these widths
+	if (width < 8 || width > 0x7fff || height <= 0)
+	{
+		return false;
+	}
+	width_ = static_cast<uint32_t>(width);
+	height_ = static_cast<uint32_t>(height);
+	return true;
+}
+
+bool HDRLoader::FindScanlines(size_t offset)
+{
+	// Scanlines have different lengths so they are skipped one by one,
+	// the run lengths are validated here so DecodeScanline() does not need to
+	const size_t fileSize = fileData_.size();
+	scanlineOffsets_.resize(height_);
+	for (uint32_t y = 0; y < height_; ++y)
+	{
+		if (offset + 4 > fileSize)
+		{
+			return false;
+		}
+		const uint8_t* start = &fileData_[offset];
+		if (start[0] != 2 || start[1] != 2 || ((start[2] << 8) | start[3]) != width_)
+		{
+			return false;
+		}
+		scanlineOffsets_[y] = offset;
+		offset += 4;
+
+		// Four channels one after another, each is a list of runs and literals
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			uint32_t x = 0;
+			while (x < width_)
+			{
+				if (offset >= fileSize)
+				{
+					return false;
+				}
+				uint32_t count = fileData_[offset++];
+				size_t byteCount = count;
+				if (count > 128)
+				{
+					count -= 128;
+					byteCount = 1;
+				}
+				if (count == 0 || count > width_ - x || offset + byteCount > fileSize)
+				{
+					return false;
+				}
+				offset += byteCount;
+				x += count;
+			}
+		}
+	}
+	return true;
+}
+
+void HDRLoader::DecodeScanline(uint32_t scanline, uint8_t* rgbe, uint64_t* output) const
+{
+	size_t offset = scanlineOffsets_[scanline] + 4;
+	for (uint32_t channel = 0; channel < 4; ++channel)
+	{
+		uint8_t* channelData = rgbe + static_cast<size_t>(channel) * width_;
+		uint32_t x = 0;
+		while (x < width_)
+		{
+			uint32_t count = fileData_[offset++];
+			if (count > 128)
+			{
+				count -= 128;
+				memset(channelData + x, fileData_[offset++], count);
+			}
+			else
+			{
+				memcpy(channelData + x, &fileData_[offset], count);
+				offset += count;
+			}
+			x += count;
+		}
+	}
+
+	const uint8_t* r = rgbe;
+	const uint8_t* g = rgbe + width_;
+	const uint8_t* b = rgbe + 2 * static_cast<size_t>(width_);
+	const uint8_t* e = rgbe + 3 * static_cast<size_t>(width_);
+	for (uint32_t x = 0; x < width_; ++x)
+	{
+		const float scale = ExponentTable[e[x]];
+		// Clamp so very bright texels do not become infinity
+		const glm::vec4 color = glm::min(
+			glm::vec4(r[x] * scale, g[x] * scale, b[x] * scale, 1.0f),
+			glm::vec4(HalfFloatMax));
+		output[x] = glm::packHalf4x16(color);
+	}
+}
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "VulkanBarrier.h"
 #include "Configs.h"
 
+constexpr uint32_t LUTWorkgroupSize = 8u; // local_size_x and local_size_y in BRDFLUT.comp
+
 PipelineBRDFLUT::PipelineBRDFLUT(
 	VulkanContext& ctx) :
 	PipelineBase(ctx, 
@@ -10,19 +12,13 @@ PipelineBRDFLUT::PipelineBRDFLUT(
 		.type_ = PipelineType::Compute
 	})
 {
-	outBuffer_.CreateBuffer(ctx, 
-		IBLConfig::LUTBufferSize,
-		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-		VMA_MEMORY_USAGE_AUTO,
-		VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
-	CreateDescriptor(ctx);
+	CreateDescriptorLayout(ctx);
 	CreatePipelineLayout(ctx, descriptorManager_.layout_, &pipelineLayout_, sizeof(PushConstBRDFLUT), VK_SHADER_STAGE_COMPUTE_BIT);
 	CreateComputePipeline(ctx, AppConfig::ShaderFolder + "IBL/BRDFLUT.comp");
 }
 
 PipelineBRDFLUT::~PipelineBRDFLUT()
 {
-	outBuffer_.Destroy();
 }
 
 void PipelineBRDFLUT::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer)
@@ -31,34 +27,62 @@ void PipelineBRDFLUT::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer comm
 
 void PipelineBRDFLUT::CreateLUT(VulkanContext& ctx, VulkanImage* outputLUT)
 {
-	// Need to use std::vector because std::array will cause stack overflow, 
-	// probably because the length is too long.
-	std::vector<float> lutData(IBLConfig::LUTBufferSize, 0);
-
-	Execute(ctx);
-
-	// Copy the buffer content to an image
-	// TODO Use storage image
-	outBuffer_.DownloadBufferData(ctx, lutData.data(), IBLConfig::LUTBufferSize);
-	outputLUT->CreateImageFromData(
+	// The LUT stays on the GPU, only two channels are needed
+	outputLUT->CreateImage(
 		ctx,
-		lutData.data(),
 		IBLConfig::LUTWidth,
 		IBLConfig::LUTHeight,
-		1, // Mipmap count
-		1, // Layer count
-		VK_FORMAT_R32G32_SFLOAT);
+		1u, // Mipmap count
+		1u, // Layer count
+		IBLConfig::LUTFormat,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY);
 	outputLUT->CreateImageView(
 		ctx,
-		VK_FORMAT_R32G32_SFLOAT,
+		IBLConfig::LUTFormat,
 		VK_IMAGE_ASPECT_COLOR_BIT);
 
+	VulkanDescriptorSetInfo dsInfo;
+	dsInfo.AddImage(
+		{
+			.imageView = outputLUT->imageView_,
+			.imageLayout = VK_IMAGE_LAYOUT_GENERAL
+		},
+		VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		VK_SHADER_STAGE_COMPUTE_BIT);
+	descriptorManager_.CreateSet(ctx, dsInfo, &descriptorSet_);
+
+	Execute(ctx, outputLUT);
+
 	outputLUT->CreateDefaultSampler(ctx);
 }
 
-void PipelineBRDFLUT::Execute(VulkanContext& ctx)
+void PipelineBRDFLUT::Execute(VulkanContext& ctx, VulkanImage* outputLUT)
 {
-	VkCommandBuffer commandBuffer = ctx.BeginOneTimeComputeCommand();
+	// Graphics queue so the LUT does not need a queue family ownership transfer before it is sampled
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
+
+	const VkImageSubresourceRange subresourceRange =
+	{
+		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		.baseMipLevel = 0u,
+		.levelCount = 1u,
+		.baseArrayLayer = 0u,
+		.layerCount = 1u
+	};
+	VulkanBarrier::CreateImageBarrier({
+			.commandBuffer = commandBuffer,
+			.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.sourceStage = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+			.sourceAccess = VK_ACCESS_2_NONE,
+			.newLayout = VK_IMAGE_LAYOUT_GENERAL,
+			.destinationStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.destinationAccess = VK_ACCESS_2_SHADER_WRITE_BIT
+		},
+		subresourceRange,
+		outputLUT->image_);
 
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
 
@@ -89,28 +113,29 @@ void PipelineBRDFLUT::Execute(VulkanContext& ctx)
 
 	// Tell the GPU to do some compute
 	vkCmdDispatch(commandBuffer, 
-		static_cast<uint32_t>(IBLConfig::LUTWidth), // groupCountX
-		static_cast<uint32_t>(IBLConfig::LUTHeight), // groupCountY
+		(IBLConfig::LUTWidth + LUTWorkgroupSize - 1) / LUTWorkgroupSize, // groupCountX
+		(IBLConfig::LUTHeight + LUTWorkgroupSize - 1) / LUTWorkgroupSize, // groupCountY
 		1u); // groupCountZ
 	
-	// Set barrier
-	constexpr VkMemoryBarrier2 barrier = {
-		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
-		.pNext = nullptr,
-		.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-		.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
-		.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
-		.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT
-	};
-	VulkanBarrier::CreateMemoryBarrier(commandBuffer, &barrier, 1u);
+	// Convention is to change the layout to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	VulkanBarrier::CreateImageBarrier({
+			.commandBuffer = commandBuffer,
+			.oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+			.sourceStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.sourceAccess = VK_ACCESS_2_SHADER_WRITE_BIT,
+			.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			.destinationStage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+			.destinationAccess = VK_ACCESS_2_SHADER_READ_BIT
+		},
+		subresourceRange,
+		outputLUT->image_);
 
-	ctx.EndOneTimeComputeCommand(commandBuffer);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
 }
 
-void PipelineBRDFLUT::CreateDescriptor(VulkanContext& ctx)
+void PipelineBRDFLUT::CreateDescriptorLayout(VulkanContext& ctx)
 {
 	VulkanDescriptorSetInfo dsInfo;
-	dsInfo.AddBuffer(&outBuffer_, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+	dsInfo.AddImage(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
 	descriptorManager_.CreatePoolAndLayout(ctx, dsInfo, 1u, 1u);
-	descriptorManager_.CreateSet(ctx, dsInfo, &descriptorSet_);
 }
\ No newline at end of file
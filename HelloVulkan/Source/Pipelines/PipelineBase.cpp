@@ -8,6 +8,8 @@
 #include "VulkanPipelineCreateInfo.h"
 
 #include <array>
+#include <algorithm>
+#include <iostream>
 
 // Constructor
 PipelineBase::PipelineBase(
@@ -119,6 +121,66 @@ void PipelineBase::CreateGraphicsPipeline(
 	VkPipelineLayout pipelineLayout,
 	const std::vector<std::string>& shaderFiles,
 	VkPipeline* pipeline)
+{
+	VK_CHECK(BuildGraphicsPipeline(ctx, renderPass, pipelineLayout, shaderFiles, pipeline));
+	shaderReloadInfos_.push_back(
+	{
+		.shaderFiles_ = shaderFiles,
+		.renderPass_ = renderPass,
+		.pipelineLayout_ = pipelineLayout,
+		.pipeline_ = pipeline
+	});
+}
+
+void PipelineBase::CreateComputePipeline(
+	VulkanContext& ctx,
+	const std::string& shaderFile)
+{
+	VK_CHECK(BuildComputePipeline(ctx, pipelineLayout_, shaderFile, &pipeline_));
+	shaderReloadInfos_.push_back(
+	{
+		.shaderFiles_ = { shaderFile },
+		.renderPass_ = VK_NULL_HANDLE,
+		.pipelineLayout_ = pipelineLayout_,
+		.pipeline_ = &pipeline_
+	});
+}
+
+std::vector<PipelineBase::ReloadedPipeline> PipelineBase::RecreatePipelines(
+	VulkanContext& ctx,
+	const std::unordered_set<std::string>& changedShaders)
+{
+	std::vector<ReloadedPipeline> reloadedPipelines;
+	for (const ShaderReloadInfo& info : shaderReloadInfos_)
+	{
+		const bool changed = std::any_of(info.shaderFiles_.begin(), info.shaderFiles_.end(),
+			[&changedShaders](const std::string& file) { return changedShaders.contains(file); });
+		if (!changed)
+		{
+			continue;
+		}
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		const VkResult result = info.renderPass_ ?
+			BuildGraphicsPipeline(ctx, info.renderPass_, info.pipelineLayout_, info.shaderFiles_, &pipeline) :
+			BuildComputePipeline(ctx, info.pipelineLayout_, info.shaderFiles_[0], &pipeline);
+		if (result != VK_SUCCESS)
+		{
+			// Keep the old pipeline until the shader is fixed
+			std::cerr << "Cannot reload pipeline with shader " << info.shaderFiles_.back() << '\n';
+			continue;
+		}
+		reloadedPipelines.push_back({ .target_ = info.pipeline_, .pipeline_ = pipeline });
+	}
+	return reloadedPipelines;
+}
+
+VkResult PipelineBase::BuildGraphicsPipeline(
+	VulkanContext& ctx,
+	VkRenderPass renderPass,
+	VkPipelineLayout pipelineLayout,
+	const std::vector<std::string>& shaderFiles,
+	VkPipeline* pipeline)
 {
 	std::vector<VulkanShader> shaderModules(shaderFiles.size(), {});
 	std::vector<VkPipelineShaderStageCreateInfo> shaderStages(shaderFiles.size(), {});
@@ -126,7 +188,15 @@ void PipelineBase::CreateGraphicsPipeline(
 	for (size_t i = 0; i < shaderFiles.size(); i++)
 	{
 		const char* file = shaderFiles[i].c_str();
-		VK_CHECK(shaderModules[i].Create(ctx.GetDevice(), file));
+		const VkResult result = shaderModules[i].Create(ctx.GetDevice(), file);
+		if (result != VK_SUCCESS)
+		{
+			for (VulkanShader& s : shaderModules)
+			{
+				s.Destroy();
+			}
+			return result;
+		}
 		const VkShaderStageFlagBits stage = GetShaderStageFlagBits(file);
 		shaderStages[i] = shaderModules[i].GetShaderStageInfo(stage, "main");
 	}
@@ -202,26 +272,35 @@ void PipelineBase::CreateGraphicsPipeline(
 		.basePipelineIndex = -1
 	};
 
-	VK_CHECK(vkCreateGraphicsPipelines(
+	const VkResult result = vkCreateGraphicsPipelines(
 		ctx.GetDevice(),
-		VK_NULL_HANDLE,
+		ctx.GetPipelineCache(),
 		1,
 		&pipelineInfo,
 		nullptr,
-		pipeline));
+		pipeline);
 
 	for (VulkanShader& s : shaderModules)
 	{
 		s.Destroy();
 	}
+
+	return result;
 }
 
-void PipelineBase::CreateComputePipeline(
+VkResult PipelineBase::BuildComputePipeline(
 	VulkanContext& ctx,
-	const std::string& shaderFile)
+	VkPipelineLayout pipelineLayout,
+	const std::string& shaderFile,
+	VkPipeline* pipeline)
 {
 	VulkanShader shader;
-	shader.Create(ctx.GetDevice(), shaderFile.c_str());
+	const VkResult shaderResult = shader.Create(ctx.GetDevice(), shaderFile.c_str());
+	if (shaderResult != VK_SUCCESS)
+	{
+		shader.Destroy();
+		return shaderResult;
+	}
 
 	const VkComputePipelineCreateInfo computePipelineCreateInfo = {
 		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
@@ -236,14 +315,16 @@ void PipelineBase::CreateComputePipeline(
 			.pName = "main",
 			.pSpecializationInfo = nullptr
 		},
-		.layout = pipelineLayout_,
+		.layout = pipelineLayout,
 		.basePipelineHandle = 0,
 		.basePipelineIndex = 0
 	};
 
-	VK_CHECK(vkCreateComputePipelines(ctx.GetDevice(), 0, 1, &computePipelineCreateInfo, nullptr, &pipeline_));
+	const VkResult result = vkCreateComputePipelines(ctx.GetDevice(), ctx.GetPipelineCache(), 1, &computePipelineCreateInfo, nullptr, pipeline);
 
 	shader.Destroy();
+
+	return result;
 }
 
 void PipelineBase::AddOverridingColorBlendAttachment(
@@ -14,10 +14,11 @@ PipelineCubeFilter::PipelineCubeFilter(
 		{
 			.type_ = PipelineType::GraphicsOffScreen
 		}
-	) 
+	),
+	cubeFormat_(inputCubemap->imageFormat_)
 {
 	// Create cube render pass
-	renderPass_.CreateOffScreenCubemap(ctx, IBLConfig::CubeFormat);
+	renderPass_.CreateOffScreenCubemap(ctx, cubeFormat_);
 
 	// Input cubemap
 	const uint32_t inputNumMipmap = Utility::MipMapCount(IBLConfig::InputCubeSideLength);
@@ -97,7 +98,7 @@ void PipelineCubeFilter::InitializeOutputCubemap(
 		inputCubeSideLength,
 		numMipmap,
 		IBLConfig::LayerCount,
-		IBLConfig::CubeFormat,
+		cubeFormat_,
 		VK_IMAGE_TILING_OPTIMAL,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 		VMA_MEMORY_USAGE_GPU_ONLY,
@@ -106,7 +107,7 @@ void PipelineCubeFilter::InitializeOutputCubemap(
 
 	outputDiffuseCubemap->CreateImageView(
 		ctx,
-		VK_FORMAT_R32G32B32A32_SFLOAT,
+		cubeFormat_,
 		VK_IMAGE_ASPECT_COLOR_BIT,
 		VK_IMAGE_VIEW_TYPE_CUBE,
 		0u,
@@ -231,7 +232,7 @@ void PipelineCubeFilter::CreateOffscreenGraphicsPipeline(
 
 	VK_CHECK(vkCreateGraphicsPipelines(
 		ctx.GetDevice(),
-		VK_NULL_HANDLE,
+		ctx.GetPipelineCache(),
 		1,
 		&pipelineInfo,
 		nullptr,
@@ -270,7 +271,8 @@ void PipelineCubeFilter::OffscreenRender(VulkanContext& ctx,
 	}
 
 	// Get command buffers
-	VkCommandBuffer commandBuffer = ctx.BeginOneTimeGraphicsCommand();
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
 
 	vkCmdBindDescriptorSets(
 		commandBuffer,
@@ -334,7 +336,7 @@ void PipelineCubeFilter::OffscreenRender(VulkanContext& ctx,
 		0u,
 		outputCubemap->layerCount_);
 
-	ctx.EndOneTimeGraphicsCommand(commandBuffer);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
 
 	// Destroy frame buffers
 	for (auto& f : mipFramebuffers)
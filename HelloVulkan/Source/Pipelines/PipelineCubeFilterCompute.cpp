@@ -0,0 +1,253 @@
+#include "PipelineCubeFilterCompute.h"
+#include "VulkanImage.h"
+#include "VulkanBarrier.h"
+#include "VulkanCheck.h"
+#include "PushConstants.h"
+#include "Configs.h"
+#include "Utility.h"
+
+#include <algorithm>
+
+constexpr uint32_t CubeFilterWorkgroupSize = 8u; // local_size_x and local_size_y in CubeFilter.comp
+
+PipelineCubeFilterCompute::PipelineCubeFilterCompute(
+	VulkanContext& ctx, VulkanImage* inputCubemap) :
+	PipelineBase(ctx,
+		{
+			.type_ = PipelineType::Compute
+		}
+	),
+	cubeFormat_(inputCubemap->imageFormat_)
+{
+	// Importance sampling reads from the input mip levels
+	const uint32_t inputNumMipmap = Utility::MipMapCount(IBLConfig::InputCubeSideLength);
+	inputCubemap->GenerateMipmap(
+		ctx,
+		inputNumMipmap,
+		IBLConfig::InputCubeSideLength,
+		IBLConfig::InputCubeSideLength,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	);
+	inputCubemap->CreateSampler(
+		ctx,
+		inputCubemapSampler_,
+		0.f,
+		static_cast<float>(inputNumMipmap)
+	);
+	inputImageInfo_ =
+	{
+		.sampler = inputCubemapSampler_,
+		.imageView = inputCubemap->imageView_,
+		.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	};
+
+	CreateDescriptorLayout(ctx);
+	CreatePipelineLayout(ctx, descriptorManager_.layout_, &pipelineLayout_, sizeof(PushConstCubeFilterCompute), VK_SHADER_STAGE_COMPUTE_BIT);
+	CreateComputePipeline(ctx, AppConfig::ShaderFolder + "IBL/CubeFilter.comp");
+}
+
+PipelineCubeFilterCompute::~PipelineCubeFilterCompute()
+{
+	vkDestroySampler(device_, inputCubemapSampler_, nullptr);
+}
+
+void PipelineCubeFilterCompute::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer)
+{
+}
+
+void PipelineCubeFilterCompute::CreateDescriptorLayout(VulkanContext& ctx)
+{
+	VulkanDescriptorSetInfo dsInfo;
+	dsInfo.AddImage(inputImageInfo_, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+	dsInfo.AddImage(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+
+	// One set per output mip level, the sets are freed after each Execute()
+	const uint32_t maxSetCount = std::max(
+		Utility::MipMapCount(IBLConfig::OutputSpecularSideLength),
+		Utility::MipMapCount(IBLConfig::OutputDiffuseSideLength));
+	descriptorManager_.CreatePoolAndLayout(ctx, dsInfo, 1u, maxSetCount, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+}
+
+void PipelineCubeFilterCompute::InitializeOutputCubemap(
+	VulkanContext& ctx,
+	VulkanImage* outputCubemap,
+	uint32_t numMipmap,
+	uint32_t outputSideLength)
+{
+	outputCubemap->CreateImage(
+		ctx,
+		outputSideLength,
+		outputSideLength,
+		numMipmap,
+		IBLConfig::LayerCount,
+		cubeFormat_,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY,
+		VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT
+	);
+
+	outputCubemap->CreateImageView(
+		ctx,
+		cubeFormat_,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_IMAGE_VIEW_TYPE_CUBE,
+		0u,
+		numMipmap,
+		0u,
+		IBLConfig::LayerCount);
+}
+
+void PipelineCubeFilterCompute::CreateOutputMipViews(VulkanContext& ctx,
+	VulkanImage* outputCubemap,
+	std::vector<VkImageView>& outputMipViews)
+{
+	outputMipViews = std::vector<VkImageView>(outputCubemap->mipCount_, VK_NULL_HANDLE);
+	for (uint32_t i = 0; i < outputCubemap->mipCount_; ++i)
+	{
+		VulkanImage::CreateImageView(
+			ctx,
+			outputCubemap->image_,
+			outputMipViews[i],
+			outputCubemap->imageFormat_,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+			i,
+			1u,
+			0u,
+			IBLConfig::LayerCount);
+	}
+}
+
+void PipelineCubeFilterCompute::Execute(VulkanContext& ctx,
+	VulkanImage* outputCubemap,
+	CubeFilterType filterType)
+{
+	const uint32_t outputMipMapCount = filterType == CubeFilterType::Diffuse ?
+		1u :
+		Utility::MipMapCount(IBLConfig::OutputSpecularSideLength);
+
+	const uint32_t outputSideLength = filterType == CubeFilterType::Diffuse ?
+		IBLConfig::OutputDiffuseSideLength :
+		IBLConfig::OutputSpecularSideLength;
+
+	InitializeOutputCubemap(ctx, outputCubemap, outputMipMapCount, outputSideLength);
+
+	std::vector<VkImageView> outputMipViews;
+	CreateOutputMipViews(ctx, outputCubemap, outputMipViews);
+
+	// Descriptor sets
+	std::vector<VkDescriptorSet> descriptorSets(outputMipMapCount, VK_NULL_HANDLE);
+	for (uint32_t i = 0; i < outputMipMapCount; ++i)
+	{
+		VulkanDescriptorSetInfo dsInfo;
+		dsInfo.AddImage(inputImageInfo_, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+		dsInfo.AddImage(
+			{
+				.imageView = outputMipViews[i],
+				.imageLayout = VK_IMAGE_LAYOUT_GENERAL
+			},
+			VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+			VK_SHADER_STAGE_COMPUTE_BIT);
+		descriptorManager_.CreateSet(ctx, dsInfo, &descriptorSets[i]);
+	}
+
+	// Graphics queue so the input cubemap does not need a queue family ownership transfer
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
+
+	const VkImageSubresourceRange subresourceRange =
+	{
+		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		.baseMipLevel = 0u,
+		.levelCount = outputCubemap->mipCount_,
+		.baseArrayLayer = 0u,
+		.layerCount = outputCubemap->layerCount_
+	};
+	VulkanBarrier::CreateImageBarrier({
+			.commandBuffer = commandBuffer,
+			.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.sourceStage = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+			.sourceAccess = VK_ACCESS_2_NONE,
+			.newLayout = VK_IMAGE_LAYOUT_GENERAL,
+			.destinationStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.destinationAccess = VK_ACCESS_2_SHADER_WRITE_BIT
+		},
+		subresourceRange,
+		outputCubemap->image_);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+
+	ctx.InsertDebugLabel(commandBuffer, "PipelineCubeFilterCompute", 0xff9999ff);
+
+	// Mip levels only read the input cubemap so the dispatches do not need barriers in between
+	for (uint32_t i = 0; i < outputMipMapCount; ++i)
+	{
+		const uint32_t targetSize = std::max(outputSideLength >> i, 1u);
+
+		const PushConstCubeFilterCompute pc =
+		{
+			.roughness = filterType == CubeFilterType::Diffuse || outputMipMapCount == 1 ?
+				0.f :
+				static_cast<float>(i) / static_cast<float>(outputMipMapCount - 1),
+			.sampleCount = filterType == CubeFilterType::Diffuse ?
+				IBLConfig::ComputeDiffuseSampleCount :
+				IBLConfig::ComputeSpecularSampleCount,
+			.filterType = static_cast<uint32_t>(filterType)
+		};
+		vkCmdPushConstants(
+			commandBuffer,
+			pipelineLayout_,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(PushConstCubeFilterCompute), &pc);
+
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			pipelineLayout_,
+			0, // firstSet
+			1, // descriptorSetCount
+			&descriptorSets[i],
+			0, // dynamicOffsetCount
+			0); // pDynamicOffsets
+
+		const uint32_t groupCount = (targetSize + CubeFilterWorkgroupSize - 1) / CubeFilterWorkgroupSize;
+		vkCmdDispatch(commandBuffer,
+			groupCount, // groupCountX
+			groupCount, // groupCountY
+			IBLConfig::LayerCount); // groupCountZ, one per face
+	}
+
+	// Convention is to change the layout to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	VulkanBarrier::CreateImageBarrier({
+			.commandBuffer = commandBuffer,
+			.oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+			.sourceStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.sourceAccess = VK_ACCESS_2_SHADER_WRITE_BIT,
+			.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			.destinationStage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.destinationAccess = VK_ACCESS_2_SHADER_READ_BIT
+		},
+		subresourceRange,
+		outputCubemap->image_);
+
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
+
+	// The command buffer has finished so the sets and views can be released
+	VK_CHECK(vkFreeDescriptorSets(
+		ctx.GetDevice(),
+		descriptorManager_.pool_,
+		static_cast<uint32_t>(descriptorSets.size()),
+		descriptorSets.data()));
+	for (VkImageView& view : outputMipViews)
+	{
+		vkDestroyImageView(ctx.GetDevice(), view, nullptr);
+	}
+
+	// Create a sampler for the output cubemap
+	outputCubemap->CreateDefaultSampler(
+		ctx,
+		0.0f,
+		static_cast<float>(outputMipMapCount));
+}
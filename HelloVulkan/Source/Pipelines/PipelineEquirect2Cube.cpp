@@ -9,16 +9,18 @@
 
 PipelineEquirect2Cube::PipelineEquirect2Cube(
 	VulkanContext& ctx, 
-	const std::string& hdrFile) :
+	const std::string& hdrFile,
+	VkFormat cubeFormat) :
 	PipelineBase(
 		ctx, 
 		{
 			.type_ = PipelineType::GraphicsOffScreen
 		}
-	)
+	),
+	cubeFormat_(cubeFormat)
 {
 	InitializeHDRImage(ctx, hdrFile);
-	renderPass_.CreateOffScreenCubemap(ctx, IBLConfig::CubeFormat);
+	renderPass_.CreateOffScreenCubemap(ctx, cubeFormat_);
 	CreateDescriptor(ctx);
 	CreatePipelineLayout(ctx, descriptorManager_.layout_, &pipelineLayout_);
 	CreateOffscreenGraphicsPipeline(
@@ -47,22 +49,31 @@ void PipelineEquirect2Cube::InitializeCubemap(VulkanContext& ctx, VulkanImage* c
 {
 	const uint32_t mipmapCount = Utility::MipMapCount(IBLConfig::InputCubeSideLength);
 
+	// Storage usage lets the mipmaps be generated with a compute shader
+	VkImageUsageFlags usage =
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	if (AppConfig::UseComputeMipmap &&
+		ctx.IsFormatSupported(cubeFormat_, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT))
+	{
+		usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+	}
+
 	cubemap->CreateImage(
 		ctx,
 		IBLConfig::InputCubeSideLength,
 		IBLConfig::InputCubeSideLength,
 		mipmapCount,
 		IBLConfig::LayerCount,
-		IBLConfig::CubeFormat,
+		cubeFormat_,
 		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		usage,
 		VMA_MEMORY_USAGE_GPU_ONLY,
 		VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT
 	);
 
 	cubemap->CreateImageView(
 		ctx,
-		VK_FORMAT_R32G32B32A32_SFLOAT,
+		cubeFormat_,
 		VK_IMAGE_ASPECT_COLOR_BIT,
 		VK_IMAGE_VIEW_TYPE_CUBE,
 		0u,
@@ -76,7 +87,7 @@ void PipelineEquirect2Cube::InitializeHDRImage(VulkanContext& ctx, const std::st
 	inputHDRImage_.CreateFromHDR(ctx, hdrFile.c_str());
 	inputHDRImage_.CreateImageView(
 		ctx,
-		VK_FORMAT_R32G32B32A32_SFLOAT,
+		inputHDRImage_.imageFormat_,
 		VK_IMAGE_ASPECT_COLOR_BIT);
 	inputHDRImage_.CreateDefaultSampler(
 		ctx,
@@ -158,7 +169,7 @@ void PipelineEquirect2Cube::CreateOffscreenGraphicsPipeline(
 
 	VK_CHECK(vkCreateGraphicsPipelines(
 		ctx.GetDevice(),
-		VK_NULL_HANDLE,
+		ctx.GetPipelineCache(),
 		1,
 		&pipelineInfo,
 		nullptr,
@@ -240,7 +251,8 @@ void PipelineEquirect2Cube::OffscreenRender(VulkanContext& ctx, VulkanImage* out
 
 	CreateFramebuffer(ctx, outputViews);
 
-	VkCommandBuffer commandBuffer = ctx.BeginOneTimeGraphicsCommand();
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
 
 	// Transition
 	outputEnvMap->TransitionLayout(ctx,
@@ -267,7 +279,7 @@ void PipelineEquirect2Cube::OffscreenRender(VulkanContext& ctx, VulkanImage* out
 
 	vkCmdEndRenderPass(commandBuffer);
 
-	ctx.EndOneTimeGraphicsCommand(commandBuffer);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
 
 	// Transition
 	outputEnvMap->TransitionLayout(ctx,
@@ -12,7 +12,8 @@ PipelineFrustumCulling::PipelineFrustumCulling(VulkanContext& ctx, Scene* scene)
 	VulkanBuffer::CreateMultipleUniformBuffers(ctx, frustumBuffers_, sizeof(FrustumUBO), AppConfig::FrameCount);
 	CreateDescriptor(ctx);
 	CreatePipelineLayout(ctx, descriptorManager_.layout_, &pipelineLayout_);
-	CreateComputePipeline(ctx, AppConfig::ShaderFolder + "FrustumCulling.comp");
+	CreateComputePipeline(ctx, AppConfig::ShaderFolder +
+		(scene_->UseInstancedDraws() ? "FrustumCullingInstanced.comp" : "FrustumCulling.comp"));
 }
 
 PipelineFrustumCulling::~PipelineFrustumCulling()
@@ -29,10 +30,53 @@ void PipelineFrustumCulling::FillCommandBuffer(VulkanContext& ctx, VkCommandBuff
 	Execute(ctx, commandBuffer, frameIndex);
 }
 
+// The scene recreated its buffers
+void PipelineFrustumCulling::OnSceneUpdated(VulkanContext& ctx)
+{
+	UpdateDescriptorSets(ctx);
+}
+
 void PipelineFrustumCulling::Execute(VulkanContext& ctx, VkCommandBuffer commandBuffer, uint32_t frameIndex)
 {
 	TracyVkZoneC(ctx.GetTracyContext(), commandBuffer, "Frustum_Culling", tracy::Color::ForestGreen);
 
+	const bool instancedDraws = scene_->UseInstancedDraws();
+	const VulkanBuffer& indirectBuffer = instancedDraws ? scene_->instancedIndirectBuffer_ : scene_->indirectBuffer_;
+	if (instancedDraws)
+	{
+		// The shader counts the visible instances of each mesh from zero.
+		// The previous frame has to finish drawing with the commands and the slots first
+		const VkMemoryBarrier2 resetBarrier =
+		{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+			.srcAccessMask = VK_ACCESS_2_NONE,
+			.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.dstAccessMask = VK_ACCESS_2_NONE
+		};
+		VulkanBarrier::CreateMemoryBarrier(commandBuffer, &resetBarrier, 1u);
+
+		const VkBufferCopy region = { .srcOffset = 0, .dstOffset = 0, .size = indirectBuffer.size_ };
+		vkCmdCopyBuffer(commandBuffer, scene_->instancedIndirectResetBuffer_.buffer_, indirectBuffer.buffer_, 1u, &region);
+
+		const VkBufferMemoryBarrier2 copyBarrier =
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+			.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = indirectBuffer.buffer_,
+			.offset = 0,
+			.size = indirectBuffer.size_,
+		};
+		VulkanBarrier::CreateBufferBarrier(commandBuffer, &copyBarrier, 1u);
+	}
+
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
 
 	vkCmdBindDescriptorSets(
@@ -59,11 +103,31 @@ void PipelineFrustumCulling::Execute(VulkanContext& ctx, VkCommandBuffer command
 		.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT_KHR ,
 		.srcQueueFamilyIndex = ctx.GetComputeFamily(),
 		.dstQueueFamilyIndex = ctx.GetGraphicsFamily(),
-		.buffer = scene_->indirectBuffer_.buffer_,
+		.buffer = indirectBuffer.buffer_,
 		.offset = 0,
-		.size = scene_->indirectBuffer_.size_,
+		.size = indirectBuffer.size_,
 	};
 	VulkanBarrier::CreateBufferBarrier(commandBuffer, &bufferBarrier, 1u);
+
+	if (instancedDraws)
+	{
+		// The vertex shader reads the compacted slots through the buffer device address
+		const VkBufferMemoryBarrier2 slotBarrier =
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+			.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = scene_->instanceIndexBuffer_.buffer_,
+			.offset = 0,
+			.size = scene_->instanceIndexBuffer_.size_,
+		};
+		VulkanBarrier::CreateBufferBarrier(commandBuffer, &slotBarrier, 1u);
+	}
 }
 
 void PipelineFrustumCulling::CreateDescriptor(VulkanContext& ctx)
@@ -71,14 +135,35 @@ void PipelineFrustumCulling::CreateDescriptor(VulkanContext& ctx)
 	constexpr uint32_t frameCount = AppConfig::FrameCount;
 	constexpr VkShaderStageFlags stageFlag = VK_SHADER_STAGE_COMPUTE_BIT;
 
-	VulkanDescriptorSetInfo dsInfo;
-	dsInfo.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, stageFlag); // 0
-	dsInfo.AddBuffer(&(scene_->transformedBoundingBoxBuffer_), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stageFlag); // 1
-	dsInfo.AddBuffer(&(scene_->indirectBuffer_), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stageFlag); // 2
-	descriptorManager_.CreatePoolAndLayout(ctx, dsInfo, frameCount, 1u);
+	descriptorSetInfo_.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, stageFlag); // 0
+	descriptorSetInfo_.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stageFlag); // 1
+	descriptorSetInfo_.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stageFlag); // 2
+	if (scene_->UseInstancedDraws())
+	{
+		descriptorSetInfo_.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stageFlag); // 3
+		descriptorSetInfo_.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stageFlag); // 4
+	}
+	descriptorManager_.CreatePoolAndLayout(ctx, descriptorSetInfo_, frameCount, 1u);
 	for (size_t i = 0; i < frameCount; ++i)
 	{
-		dsInfo.UpdateBuffer(&(frustumBuffers_[i]), 0);
-		descriptorManager_.CreateSet(ctx, dsInfo, &(descriptorSets_[i]));
+		descriptorManager_.AllocateSet(ctx, &(descriptorSets_[i]));
+	}
+	UpdateDescriptorSets(ctx);
+}
+
+void PipelineFrustumCulling::UpdateDescriptorSets(VulkanContext& ctx)
+{
+	const bool instancedDraws = scene_->UseInstancedDraws();
+	descriptorSetInfo_.UpdateBuffer(&(scene_->transformedBoundingBoxBuffer_), 1);
+	descriptorSetInfo_.UpdateBuffer(instancedDraws ? &(scene_->instancedIndirectBuffer_) : &(scene_->indirectBuffer_), 2);
+	if (instancedDraws)
+	{
+		descriptorSetInfo_.UpdateBuffer(&(scene_->drawGroupIndexBuffer_), 3);
+		descriptorSetInfo_.UpdateBuffer(&(scene_->instanceIndexBuffer_), 4);
 	}
-}
\ No newline at end of file
+	for (size_t i = 0; i < AppConfig::FrameCount; ++i)
+	{
+		descriptorSetInfo_.UpdateBuffer(&(frustumBuffers_[i]), 0);
+		descriptorManager_.UpdateSet(ctx, descriptorSetInfo_, &(descriptorSets_[i]));
+	}
+}
@@ -1,4 +1,8 @@
 #include "PipelineGBuffer.h"
+#include "VulkanBarrier.h"
+#include "UIData.h"
+
+#include <algorithm>
 
 PipelineGBuffer::PipelineGBuffer(VulkanContext& ctx,
 	Scene* scene,
@@ -15,25 +19,46 @@ PipelineGBuffer::PipelineGBuffer(VulkanContext& ctx,
 	VulkanBuffer::CreateMultipleUniformBuffers(ctx, cameraUBOBuffers_, sizeof(CameraUBO), AppConfig::FrameCount);
 	CreateBDABuffer(ctx); // Buffer device address
 	CreateDescriptor(ctx);
+
+	std::vector<VkFormat> formats =
+	{
+		resourcesGBuffer_->position_.imageFormat_,
+		resourcesGBuffer_->normal_.imageFormat_
+	};
+	std::vector<VulkanImage*> attachments =
+	{
+		&(resourcesGBuffer_->position_),
+		&(resourcesGBuffer_->normal_)
+	};
+	if (resourcesGBuffer_->UseInstanceID())
+	{
+		formats.push_back(resourcesGBuffer_->instanceID_.imageFormat_);
+		attachments.push_back(&(resourcesGBuffer_->instanceID_));
+		CreatePickBuffers(ctx);
+	}
+	attachments.push_back(&(resourcesGBuffer_->depth_));
+
 	renderPass_.CreateOffScreenGBuffer(
 		ctx,
-		{
-			resourcesGBuffer_->position_.imageFormat_,
-			resourcesGBuffer_->normal_.imageFormat_
-		},
+		formats,
 		renderBit | RenderPassBit::ColorClear | RenderPassBit::DepthClear);
+	if (resourcesGBuffer_->UseInstanceID())
+	{
+		// Zero is no instance, the float clear value would be stored as its bits
+		renderPass_.SetClearColor(static_cast<uint32_t>(formats.size() - 1), { .uint32 = { 0u, 0u, 0u, 0u } });
+	}
 	framebuffer_.CreateResizeable(
 		ctx,
 		renderPass_.GetHandle(),
-		{
-			&(resourcesGBuffer_->position_),
-			&(resourcesGBuffer_->normal_),
-			&(resourcesGBuffer_->depth_)
-		},
+		attachments,
 		IsOffscreen());
 	CreatePipelineLayout(ctx, descriptorManager_.layout_, &pipelineLayout_);
 	AddOverridingColorBlendAttachment(0xf, VK_FALSE); // resourcesGBuffer_->position_
 	AddOverridingColorBlendAttachment(0xf, VK_FALSE); // resourcesGBuffer_->normal_
+	if (resourcesGBuffer_->UseInstanceID())
+	{
+		AddOverridingColorBlendAttachment(VK_COLOR_COMPONENT_R_BIT, VK_FALSE); // resourcesGBuffer_->instanceID_
+	}
 	CreateGraphicsPipeline(
 		ctx,
 		renderPass_.GetHandle(),
@@ -49,6 +74,10 @@ PipelineGBuffer::PipelineGBuffer(VulkanContext& ctx,
 PipelineGBuffer::~PipelineGBuffer()
 {
 	bdaBuffer_.Destroy();
+	for (VulkanBuffer& buffer : pickBuffers_)
+	{
+		buffer.Destroy();
+	}
 }
 
 void PipelineGBuffer::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer)
@@ -94,6 +123,118 @@ void PipelineGBuffer::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer comm
 		resourcesGBuffer_->normal_.imageFormat_,
 		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
 		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	if (pickRequested_)
+	{
+		CopyPickedTexel(ctx, commandBuffer);
+	}
+}
+
+void PipelineGBuffer::UpdateFromUIData(VulkanContext& ctx, UIData& uiData)
+{
+	if (!resourcesGBuffer_->UseInstanceID())
+	{
+		return;
+	}
+
+	// The fence of this frame index is signaled so the copy recorded FrameCount frames ago is done
+	ReadPickedInstance(ctx, uiData);
+
+	if (uiData.gpuPicking_ && uiData.GizmoCanSelect())
+	{
+		pickRequested_ = true;
+		pickX_ = static_cast<uint32_t>(std::max(uiData.mousePositionX_, 0.0f));
+		pickY_ = static_cast<uint32_t>(std::max(uiData.mousePositionY_, 0.0f));
+	}
+}
+
+void PipelineGBuffer::CopyPickedTexel(VulkanContext& ctx, VkCommandBuffer commandBuffer)
+{
+	const uint32_t frameIndex = ctx.GetFrameIndex();
+	VulkanImage& image = resourcesGBuffer_->instanceID_;
+
+	VulkanImage::TransitionLayoutCommand(
+		commandBuffer,
+		image.image_,
+		image.imageFormat_,
+		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+	const VkBufferImageCopy region =
+	{
+		.bufferOffset = 0,
+		.bufferRowLength = 0,
+		.bufferImageHeight = 0,
+		.imageSubresource =
+		{
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.mipLevel = 0u,
+			.baseArrayLayer = 0u,
+			.layerCount = 1u
+		},
+		.imageOffset =
+		{
+			static_cast<int32_t>(std::min(pickX_, image.width_ - 1)),
+			static_cast<int32_t>(std::min(pickY_, image.height_ - 1)),
+			0
+		},
+		.imageExtent = { 1u, 1u, 1u }
+	};
+	vkCmdCopyImageToBuffer(
+		commandBuffer,
+		image.image_,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		pickBuffers_[frameIndex].buffer_,
+		1u,
+		&region);
+
+	// The render pass of the next frame must not clear the image before the copy has read it
+	VulkanImage::TransitionLayoutCommand(
+		commandBuffer,
+		image.image_,
+		image.imageFormat_,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+	constexpr VkMemoryBarrier2 barrier = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+		.pNext = nullptr,
+		.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+		.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT
+	};
+	VulkanBarrier::CreateMemoryBarrier(commandBuffer, &barrier, 1u);
+
+	pickSubmitted_[frameIndex] = true;
+	pickRequested_ = false;
+}
+
+void PipelineGBuffer::ReadPickedInstance(VulkanContext& ctx, UIData& uiData)
+{
+	const uint32_t frameIndex = ctx.GetFrameIndex();
+	if (!pickSubmitted_[frameIndex])
+	{
+		return;
+	}
+	pickSubmitted_[frameIndex] = false;
+
+	VulkanBuffer& buffer = pickBuffers_[frameIndex];
+	vmaInvalidateAllocation(buffer.vmaAllocator_, buffer.vmaAllocation_, 0, VK_WHOLE_SIZE);
+	const uint32_t id = *static_cast<const uint32_t*>(buffer.vmaInfo_.pMappedData);
+
+	// Zero is the clear value, ids above the instance count can be stale after instances were removed
+	if (id == 0 || id > scene_->GetInstanceCount())
+	{
+		return;
+	}
+	const uint32_t instanceIndex = id - 1;
+	if (!scene_->IsInstanceClickable(instanceIndex))
+	{
+		return;
+	}
+	uiData.gizmoModelIndex = scene_->instanceDataArray_[instanceIndex].meshData_.modelMatrixIndex_;
+	uiData.gizmoInstanceIndex = static_cast<int>(instanceIndex);
 }
 
 void PipelineGBuffer::CreateBDABuffer(VulkanContext& ctx)
@@ -109,6 +250,19 @@ void PipelineGBuffer::CreateBDABuffer(VulkanContext& ctx)
 	bdaBuffer_.UploadBufferData(ctx, &bda, bdaSize);
 }
 
+void PipelineGBuffer::CreatePickBuffers(VulkanContext& ctx)
+{
+	for (VulkanBuffer& buffer : pickBuffers_)
+	{
+		buffer.CreateBuffer(
+			ctx,
+			sizeof(uint32_t),
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+	}
+}
+
 void PipelineGBuffer::CreateDescriptor(VulkanContext& ctx)
 {
 	constexpr uint32_t frameCount = AppConfig::FrameCount;
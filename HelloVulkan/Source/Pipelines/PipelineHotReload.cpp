@@ -0,0 +1,137 @@
+#include "PipelineHotReload.h"
+#include "VulkanShader.h"
+#include "Configs.h"
+
+#include <unordered_set>
+#include <iostream>
+
+PipelineHotReload::~PipelineHotReload()
+{
+	Stop();
+}
+
+void PipelineHotReload::Start(VulkanContext& ctx, const std::vector<std::unique_ptr<PipelineBase>>& pipelines)
+{
+	Stop();
+
+	ctx_ = &ctx;
+	pipelines_.clear();
+	for (const std::unique_ptr<PipelineBase>& pipeline : pipelines)
+	{
+		pipelines_.push_back(pipeline.get());
+	}
+
+	thread_ = std::jthread([this](const std::stop_token& stopToken) { Watch(stopToken); });
+}
+
+void PipelineHotReload::Stop()
+{
+	if (thread_.joinable())
+	{
+		thread_.request_stop();
+		thread_.join();
+	}
+
+	// Discard pipelines that were never swapped in
+	std::scoped_lock lock(mutex_);
+	for (const PipelineBase::ReloadedPipeline& reloaded : reloadedPipelines_)
+	{
+		vkDestroyPipeline(ctx_->GetDevice(), reloaded.pipeline_, nullptr);
+	}
+	reloadedPipelines_.clear();
+}
+
+void PipelineHotReload::ApplyChanges(VulkanContext& ctx)
+{
+	std::vector<PipelineBase::ReloadedPipeline> reloadedPipelines;
+	{
+		std::scoped_lock lock(mutex_);
+		reloadedPipelines.swap(reloadedPipelines_);
+	}
+	if (reloadedPipelines.empty())
+	{
+		return;
+	}
+
+	// Old pipelines can still be used by frames in flight
+	{
+		const auto queueLock = ctx.LockQueues();
+		vkDeviceWaitIdle(ctx.GetDevice());
+	}
+	for (const PipelineBase::ReloadedPipeline& reloaded : reloadedPipelines)
+	{
+		vkDestroyPipeline(ctx.GetDevice(), *reloaded.target_, nullptr);
+		*reloaded.target_ = reloaded.pipeline_;
+	}
+	std::cout << "Reloaded " << reloadedPipelines.size() << " pipeline(s)\n";
+}
+
+void PipelineHotReload::Watch(const std::stop_token& stopToken)
+{
+	std::unordered_map<std::string, std::filesystem::file_time_type> fileTimes = GetFileTimes();
+
+	while (!stopToken.stop_requested())
+	{
+		{
+			std::unique_lock lock(mutex_);
+			condition_.wait_for(lock, stopToken, POLL_INTERVAL, [] { return false; });
+		}
+		if (stopToken.stop_requested())
+		{
+			break;
+		}
+
+		std::unordered_map<std::string, std::filesystem::file_time_type> newFileTimes = GetFileTimes();
+		std::unordered_set<std::string> changedShaders;
+		for (const auto& [file, time] : newFileTimes)
+		{
+			const auto it = fileTimes.find(file);
+			if (it != fileTimes.end() && it->second == time)
+			{
+				continue;
+			}
+
+			// The file itself if it is a shader, and every shader that includes it
+			VulkanShader::InvalidateIncludeCache(file);
+			changedShaders.insert(file);
+			for (const std::string& shader : VulkanShader::GetDependentShaders(file))
+			{
+				changedShaders.insert(shader);
+			}
+		}
+		fileTimes = std::move(newFileTimes);
+
+		if (changedShaders.empty())
+		{
+			continue;
+		}
+
+		for (PipelineBase* pipeline : pipelines_)
+		{
+			std::vector<PipelineBase::ReloadedPipeline> reloadedPipelines = pipeline->RecreatePipelines(*ctx_, changedShaders);
+			std::scoped_lock lock(mutex_);
+			reloadedPipelines_.insert(reloadedPipelines_.end(), reloadedPipelines.begin(), reloadedPipelines.end());
+		}
+	}
+}
+
+std::unordered_map<std::string, std::filesystem::file_time_type> PipelineHotReload::GetFileTimes() const
+{
+	std::unordered_map<std::string, std::filesystem::file_time_type> fileTimes;
+
+	std::error_code ec;
+	const std::filesystem::path folder(AppConfig::ShaderFolder);
+	for (auto it = std::filesystem::recursive_directory_iterator(folder, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+	{
+		if (!it->is_regular_file(ec))
+		{
+			continue;
+		}
+
+		// Same format as the paths passed to VulkanShader, folder + "Dir/File.ext"
+		const std::string file = AppConfig::ShaderFolder + it->path().lexically_relative(folder).generic_string();
+		fileTimes[file] = it->last_write_time(ec);
+	}
+
+	return fileTimes;
+}
@@ -175,7 +175,21 @@ void PipelineImGui::ImGuizmoManipulateScene(VulkanContext& ctx, UIData* uiData)
 		return;
 	}
 
-	if (uiData->GizmoCanSelect())
+	// Triangle picking is cheap enough to follow the mouse
+	uiData->hoveredInstanceIndex_ = -1;
+	if (uiData->gizmoMode_ != GizmoMode::None && !ImGui::GetIO().WantCaptureMouse && !ImGuizmo::IsUsing())
+	{
+		Ray r = camera_->GetRayFromScreenToWorld(uiData->mousePositionX_, uiData->mousePositionY_);
+		ScenePickResult pick;
+		if (scene_->PickTriangle(r, pick))
+		{
+			uiData->hoveredInstanceIndex_ = pick.instanceIndex_;
+			ImGuizmoShowHovered(scene_->transformedBoundingBoxes_[pick.instanceIndex_]);
+		}
+	}
+
+	// With GPU picking the G-buffer pipeline selects the instance a few frames later
+	if (uiData->GizmoCanSelect() && !uiData->gpuPicking_)
 	{
 		Ray r = camera_->GetRayFromScreenToWorld(uiData->mousePositionX_, uiData->mousePositionY_);
 		int i = scene_->GetClickedInstanceIndex(r);
@@ -195,8 +209,46 @@ void PipelineImGui::ImGuizmoManipulateScene(VulkanContext& ctx, UIData* uiData)
 			uiData->gizmoMode_);
 
 		// TODO Code smell because UI directly manipulates the scene
-		const InstanceData& iData = scene_->instanceDataArray_[uiData->gizmoInstanceIndex];
-		scene_->UpdateModelMatrixBuffer(ctx, iData.modelIndex_, iData.perModelInstanceIndex_);
+		// The gizmo moves the node of the clicked mesh, which is the whole instance unless the model keeps its hierarchy
+		scene_->UpdateNodeWorldMatrix(uiData->gizmoModelIndex);
+	}
+}
+
+void PipelineImGui::ImGuizmoShowHovered(const BoundingBox& box)
+{
+	const glm::mat4 viewProjection = camera_->GetProjectionMatrix() * camera_->GetViewMatrix();
+	const ImVec2 displaySize = ImGui::GetIO().DisplaySize;
+
+	// Corner i has the max coordinate on axis a if bit a of i is set
+	std::array<ImVec2, 8> corners{};
+	for (int i = 0; i < 8; ++i)
+	{
+		const glm::vec4 p(
+			(i & 1) ? box.max_.x : box.min_.x,
+			(i & 2) ? box.max_.y : box.min_.y,
+			(i & 4) ? box.max_.z : box.min_.z,
+			1.0f);
+		const glm::vec4 clip = viewProjection * p;
+		if (clip.w <= 0.0f)
+		{
+			// Skip boxes that cross the camera plane
+			return;
+		}
+		const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		corners[i] = ImVec2((ndc.x * 0.5f + 0.5f) * displaySize.x, (ndc.y * 0.5f + 0.5f) * displaySize.y);
+	}
+
+	ImDrawList* drawList = ImGui::GetForegroundDrawList();
+	constexpr ImU32 color = IM_COL32(255, 200, 0, 255);
+	for (int i = 0; i < 8; ++i)
+	{
+		for (int axis = 1; axis < 8; axis <<= 1)
+		{
+			if (!(i & axis))
+			{
+				drawList->AddLine(corners[i], corners[i | axis], color, 2.0f);
+			}
+		}
 	}
 }
 
@@ -1,11 +1,13 @@
 #include "PipelinePBRBindless.h"
 #include "VulkanDescriptorSetInfo.h"
+#include "VulkanBarrier.h"
 #include "ResourcesShared.h"
 #include "ResourcesLight.h"
 #include "ResourcesIBL.h"
 #include "Scene.h"
 #include "Configs.h"
 
+#include <cstddef>
 #include <vector>
 
 // Constants
@@ -46,6 +48,7 @@ PipelinePBRBindless::PipelinePBRBindless(
 		}, 
 		IsOffscreen());
 	CreatePipelineLayout(ctx, descriptorManager_.layout_, &pipelineLayout_, sizeof(PushConstPBR), VK_SHADER_STAGE_FRAGMENT_BIT);
+	CreateSpecializationConstants();
 	CreateGraphicsPipeline(
 		ctx,
 		renderPass_.GetHandle(),
@@ -61,6 +64,7 @@ PipelinePBRBindless::PipelinePBRBindless(
 PipelinePBRBindless::~PipelinePBRBindless()
 {
 	bdaBuffer_.Destroy();
+	feedbackPlaceholderBuffer_.Destroy();
 }
 
 void PipelinePBRBindless::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer)
@@ -72,6 +76,21 @@ void PipelinePBRBindless::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer
 
 	BindPipeline(ctx, commandBuffer);
 
+	// Textures replaced by the streamer since this descriptor set was last used
+	if (scene_->UseTextureStreaming())
+	{
+		TextureStreamer* textureStreamer = scene_->GetTextureStreamer();
+		for (uint32_t textureIndex : textureStreamer->TakeChangedTextures(frameIndex))
+		{
+			descriptorManager_.UpdateImageArrayElement(
+				ctx,
+				descriptorSets_[frameIndex],
+				7u, // Binding index
+				textureIndex,
+				textureStreamer->GetDescriptorImageInfo(textureIndex));
+		}
+	}
+
 	vkCmdPushConstants(
 		commandBuffer,
 		pipelineLayout_,
@@ -91,14 +110,76 @@ void PipelinePBRBindless::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer
 
 	ctx.InsertDebugLabel(commandBuffer, "PipelinePBRBindless", 0xff9999ff);
 
-	vkCmdDrawIndirect(
-		commandBuffer, 
-		scene_->indirectBuffer_.buffer_, 
-		0, // offset
-		scene_->GetInstanceCount(),
-		sizeof(VkDrawIndirectCommand));
+	if (scene_->UseInstancedDraws())
+	{
+		vkCmdDrawIndirect(
+			commandBuffer,
+			scene_->instancedIndirectBuffer_.buffer_,
+			0, // offset
+			scene_->GetDrawGroupCount(),
+			sizeof(VkDrawIndirectCommand));
+	}
+	else
+	{
+		vkCmdDrawIndirect(
+			commandBuffer, 
+			scene_->indirectBuffer_.buffer_, 
+			0, // offset
+			scene_->GetInstanceCount(),
+			sizeof(VkDrawIndirectCommand));
+	}
 	
 	vkCmdEndRenderPass(commandBuffer);
+
+	if (scene_->UseTextureStreaming())
+	{
+		// The feedback is read on the CPU after the fence of this frame
+		constexpr VkMemoryBarrier2 barrier = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+			.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+			.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT
+		};
+		VulkanBarrier::CreateMemoryBarrier(commandBuffer, &barrier, 1u);
+	}
+}
+
+void PipelinePBRBindless::CreateSpecializationConstants()
+{
+	specializationData_ =
+	{
+		.textureFeedback_ = scene_->UseTextureStreaming() ? 1u : 0u,
+		.instancedDraws_ = scene_->UseInstancedDraws() ? 1u : 0u
+	};
+
+	std::vector<VkSpecializationMapEntry> specializationEntries = {
+		{
+			.constantID = 0,
+			.offset = offsetof(SpecializationData, textureFeedback_),
+			.size = sizeof(uint32_t)
+		},
+		{
+			.constantID = 1,
+			.offset = offsetof(SpecializationData, instancedDraws_),
+			.size = sizeof(uint32_t)
+		}
+	};
+
+	specializationConstants_.ConsumeEntries(
+		std::move(specializationEntries),
+		&specializationData_,
+		sizeof(SpecializationData),
+		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+}
+
+// The scene recreated its buffers and textures
+void PipelinePBRBindless::OnSceneUpdated(VulkanContext& ctx)
+{
+	const BDA bda = scene_->GetBDA();
+	bdaBuffer_.UploadBufferData(ctx, &bda, sizeof(BDA));
+	UpdateDescriptorSets(ctx);
 }
 
 void PipelinePBRBindless::CreateBDABuffer(VulkanContext& ctx)
@@ -116,27 +197,52 @@ void PipelinePBRBindless::CreateBDABuffer(VulkanContext& ctx)
 
 void PipelinePBRBindless::CreateDescriptor(VulkanContext& ctx)
 {
-	constexpr uint32_t frameCount = AppConfig::FrameCount;
-
-	VulkanDescriptorSetInfo dsInfo;
-	dsInfo.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER); // 0
-	dsInfo.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER); // 1
-	dsInfo.AddBuffer(&bdaBuffer_, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER); // 2
-	dsInfo.AddBuffer(resourcesLight_->GetVulkanBufferPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT); // 3
-	dsInfo.AddImage(&(resourcesIBL_->specularCubemap_)); // 4
-	dsInfo.AddImage(&(resourcesIBL_->diffuseCubemap_)); // 5
-	dsInfo.AddImage(&(resourcesIBL_->brdfLut_)); // 6
-	dsInfo.AddImageArray(scene_->GetImageInfos()); // 7
+	descriptorSetInfo_.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER); // 0
+	descriptorSetInfo_.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER); // 1
+	descriptorSetInfo_.AddBuffer(&bdaBuffer_, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER); // 2
+	descriptorSetInfo_.AddBuffer(resourcesLight_->GetVulkanBufferPtr(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT); // 3
+	descriptorSetInfo_.AddImage(&(resourcesIBL_->specularCubemap_)); // 4
+	descriptorSetInfo_.AddImage(&(resourcesIBL_->diffuseCubemap_)); // 5
+	descriptorSetInfo_.AddImage(&(resourcesIBL_->brdfLut_)); // 6
+	// Streamed textures are written to the descriptor set of the frame that is being recorded
+	const VkDescriptorBindingFlags textureBindingFlags = scene_->UseTextureStreaming() ?
+		VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT : 0u;
+	descriptorSetInfo_.AddImageArray(
+		scene_->GetImageInfos(),
+		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		VK_SHADER_STAGE_FRAGMENT_BIT,
+		textureBindingFlags); // 7
+	descriptorSetInfo_.AddBuffer(&(resourcesIBL_->shIrradianceBuffer_), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT); // 8
+	descriptorSetInfo_.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT); // 9
+
+	// The shader does not write the feedback but the binding still needs a buffer
+	if (!scene_->UseTextureStreaming())
+	{
+		feedbackPlaceholderBuffer_.CreateBuffer(ctx, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, 0);
+	}
 
 	// Pool and layout
-	descriptorManager_.CreatePoolAndLayout(ctx, dsInfo, frameCount, 1u);
+	descriptorManager_.CreatePoolAndLayout(ctx, descriptorSetInfo_, AppConfig::FrameCount, 1u);
 
 	// Sets
-	descriptorSets_.resize(frameCount);
-	for (uint32_t i = 0; i < frameCount; ++i)
+	for (uint32_t i = 0; i < AppConfig::FrameCount; ++i)
+	{
+		descriptorManager_.AllocateSet(ctx, &(descriptorSets_[i]));
+	}
+	UpdateDescriptorSets(ctx);
+}
+
+void PipelinePBRBindless::UpdateDescriptorSets(VulkanContext& ctx)
+{
+	// The texture array has the same size, see Scene::GetImageInfos()
+	descriptorSetInfo_.UpdateImageArray(scene_->GetImageInfos(), 7);
+	for (uint32_t i = 0; i < AppConfig::FrameCount; ++i)
 	{
-		dsInfo.UpdateBuffer(&(cameraUBOBuffers_[i]), 0);
-		dsInfo.UpdateBuffer(&(scene_->modelSSBOBuffers_[i]), 1);
-		descriptorManager_.CreateSet(ctx, dsInfo, &(descriptorSets_[i]));
+		descriptorSetInfo_.UpdateBuffer(&(cameraUBOBuffers_[i]), 0);
+		descriptorSetInfo_.UpdateBuffer(&(scene_->modelSSBOBuffers_[i]), 1);
+		descriptorSetInfo_.UpdateBuffer(scene_->UseTextureStreaming() ?
+			scene_->GetTextureStreamer()->GetFeedbackBuffer(i) :
+			&feedbackPlaceholderBuffer_, 9);
+		descriptorManager_.UpdateSet(ctx, descriptorSetInfo_, &(descriptorSets_[i]));
 	}
 }
\ No newline at end of file
@@ -38,8 +38,6 @@ PipelinePBRClusterForward::PipelinePBRClusterForward(
 	VulkanBuffer::CreateMultipleUniformBuffers(ctx, cameraUBOBuffers_, sizeof(CameraUBO), AppConfig::FrameCount);
 	VulkanBuffer::CreateMultipleUniformBuffers(ctx, cfUBOBuffers_, sizeof(ClusterForwardUBO), AppConfig::FrameCount);
 
-	scene_->GetOffsetAndDrawCount(materialType_, materialOffset_, materialDrawCount_);
-
 	renderPass_.CreateOffScreen(ctx, renderBit, config_.msaaSamples_);
 	framebuffer_.CreateResizeable(
 		ctx,
@@ -76,6 +74,9 @@ PipelinePBRClusterForward::~PipelinePBRClusterForward()
 
 void PipelinePBRClusterForward::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer)
 {
+	// Constant time, the ranges change when instances are added or removed
+	scene_->GetOffsetAndDrawCount(materialType_, materialOffset_, materialDrawCount_);
+
 	TracyVkZoneC(ctx.GetTracyContext(), commandBuffer, "PBR_Cluster_Forward", tracy::Color::MediumPurple);
 
 	const uint32_t frameIndex = ctx.GetFrameIndex();
@@ -158,6 +159,7 @@ void PipelinePBRClusterForward::CreateDescriptor(VulkanContext& ctx)
 	dsInfo.AddImage(&(resourcesIBL_->diffuseCubemap_)); // 8
 	dsInfo.AddImage(&(resourcesIBL_->brdfLut_)); // 9
 	dsInfo.AddImageArray(scene_->GetImageInfos()); // 10
+	dsInfo.AddBuffer(&(resourcesIBL_->shIrradianceBuffer_), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT); // 11
 
 	// Pool and layout
 	descriptorManager_.CreatePoolAndLayout(ctx, dsInfo, frameCount, 1u);
@@ -42,8 +42,6 @@ PipelinePBRShadow::PipelinePBRShadow(
 	VulkanBuffer::CreateMultipleUniformBuffers(ctx, cameraUBOBuffers_, sizeof(CameraUBO), AppConfig::FrameCount);
 	VulkanBuffer::CreateMultipleUniformBuffers(ctx, shadowMapConfigUBOBuffers_, sizeof(ShadowMapUBO), AppConfig::FrameCount);
 
-	scene_->GetOffsetAndDrawCount(materialType_, materialOffset_, materialDrawCount_);
-
 	renderPass_.CreateOffScreen(ctx, renderBit, config_.msaaSamples_);
 	framebuffer_.CreateResizeable(
 		ctx, 
@@ -80,6 +78,8 @@ PipelinePBRShadow::~PipelinePBRShadow()
 
 void PipelinePBRShadow::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer)
 {
+	// Constant time, the ranges change when instances are added or removed
+	scene_->GetOffsetAndDrawCount(materialType_, materialOffset_, materialDrawCount_);
 	if (materialDrawCount_ == 0)
 	{
 		return;
@@ -170,6 +170,7 @@ void PipelinePBRShadow::CreateDescriptor(VulkanContext& ctx)
 	descriptorSetInfo_.AddImage(&(resourcesShadow_->shadowMap_)); // 8
 	descriptorSetInfo_.AddImage(nullptr); // 9
 	descriptorSetInfo_.AddImageArray(scene_->GetImageInfos()); // 10
+	descriptorSetInfo_.AddBuffer(&(resourcesIBL_->shIrradianceBuffer_), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT); // 11
 
 	// Pool and layout
 	descriptorManager_.CreatePoolAndLayout(ctx, descriptorSetInfo_, AppConfig::FrameCount, 1u);
@@ -127,6 +127,7 @@ void PipelinePBRSlotBased::CreateDescriptor(VulkanContext& ctx)
 	dsInfo.AddImage(&(resourcesIBL_->specularCubemap_));
 	dsInfo.AddImage(&(resourcesIBL_->diffuseCubemap_));
 	dsInfo.AddImage(&(resourcesIBL_->brdfLut_));
+	dsInfo.AddBuffer(&(resourcesIBL_->shIrradianceBuffer_), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
 
 	// Pool and layout
 	descriptorManager_.CreatePoolAndLayout(ctx, dsInfo, AppConfig::FrameCount, meshCount);
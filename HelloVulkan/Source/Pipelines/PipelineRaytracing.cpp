@@ -216,8 +216,8 @@ void PipelineRaytracing::CreateRayTracingPipeline(VulkanContext& ctx)
 	};
 	VK_CHECK(vkCreateRayTracingPipelinesKHR(
 		ctx.GetDevice(), 
-		VK_NULL_HANDLE, 
-		VK_NULL_HANDLE, 
+		VK_NULL_HANDLE, // Deferred operation
+		ctx.GetPipelineCache(), 
 		1, 
 		&rayTracingPipelineCI, 
 		nullptr, 
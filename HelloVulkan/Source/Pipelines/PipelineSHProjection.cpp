@@ -0,0 +1,254 @@
+#include "PipelineSHProjection.h"
+#include "VulkanImage.h"
+#include "VulkanBarrier.h"
+#include "VulkanCheck.h"
+#include "Configs.h"
+#include "Utility.h"
+
+#include <algorithm>
+
+constexpr uint32_t SHWorkgroupSize = 8u; // local_size_x and local_size_y in SHProjection.comp
+constexpr uint32_t SHCoefficientCount = 9u;
+
+PipelineSHProjection::PipelineSHProjection(
+	VulkanContext& ctx, VulkanImage* inputCubemap, VulkanBuffer* outputBuffer) :
+	PipelineBase(ctx,
+		{
+			.type_ = PipelineType::Compute
+		}
+	),
+	cubeFormat_(inputCubemap->imageFormat_),
+	outputBuffer_(outputBuffer)
+{
+	// Project a small mip level, the result is very low frequency anyway
+	const uint32_t mipLevel = std::min(
+		Utility::MipMapCount(IBLConfig::InputCubeSideLength / std::min(IBLConfig::SHSampleSideLength, IBLConfig::InputCubeSideLength)) - 1u,
+		inputCubemap->mipCount_ - 1u);
+	sampleSideLength_ = std::max(IBLConfig::InputCubeSideLength >> mipLevel, 1u);
+	sampleMipLevel_ = static_cast<float>(mipLevel);
+	groupCountPerSide_ = (sampleSideLength_ + SHWorkgroupSize - 1) / SHWorkgroupSize;
+
+	const uint32_t partialCount = groupCountPerSide_ * groupCountPerSide_ * IBLConfig::LayerCount;
+	partialBuffer_.CreateBuffer(
+		ctx,
+		static_cast<VkDeviceSize>(partialCount) * SHCoefficientCount * 4 * sizeof(float),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY,
+		0);
+
+	inputCubemap->CreateSampler(
+		ctx,
+		inputCubemapSampler_,
+		0.f,
+		static_cast<float>(inputCubemap->mipCount_)
+	);
+	inputImageInfo_ =
+	{
+		.sampler = inputCubemapSampler_,
+		.imageView = inputCubemap->imageView_,
+		.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	};
+
+	CreateDescriptorLayout(ctx);
+	CreatePipelineLayout(ctx, descriptorManager_.layout_, &pipelineLayout_, sizeof(PushConstSHProjection), VK_SHADER_STAGE_COMPUTE_BIT);
+	CreateComputePipeline(ctx, AppConfig::ShaderFolder + "IBL/SHProjection.comp");
+}
+
+PipelineSHProjection::~PipelineSHProjection()
+{
+	vkDestroySampler(device_, inputCubemapSampler_, nullptr);
+	partialBuffer_.Destroy();
+}
+
+void PipelineSHProjection::FillCommandBuffer(VulkanContext& ctx, VkCommandBuffer commandBuffer)
+{
+}
+
+void PipelineSHProjection::CreateDescriptorLayout(VulkanContext& ctx)
+{
+	VulkanDescriptorSetInfo dsInfo;
+	dsInfo.AddImage(inputImageInfo_, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT); // 0
+	dsInfo.AddBuffer(&partialBuffer_, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT); // 1
+	dsInfo.AddBuffer(outputBuffer_, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT); // 2
+	dsInfo.AddImage(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT); // 3
+	descriptorManager_.CreatePoolAndLayout(ctx, dsInfo, 1u, 1u);
+}
+
+void PipelineSHProjection::InitializeOutputCubemap(VulkanContext& ctx, VulkanImage* outputCubemap)
+{
+	outputCubemap->CreateImage(
+		ctx,
+		IBLConfig::OutputDiffuseSideLength,
+		IBLConfig::OutputDiffuseSideLength,
+		1u,
+		IBLConfig::LayerCount,
+		cubeFormat_,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY,
+		VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT
+	);
+
+	outputCubemap->CreateImageView(
+		ctx,
+		cubeFormat_,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_IMAGE_VIEW_TYPE_CUBE,
+		0u,
+		1u,
+		0u,
+		IBLConfig::LayerCount);
+}
+
+void PipelineSHProjection::Execute(VulkanContext& ctx, VulkanImage* outputDiffuseCubemap)
+{
+	InitializeOutputCubemap(ctx, outputDiffuseCubemap);
+
+	VkImageView outputView{ VK_NULL_HANDLE };
+	VulkanImage::CreateImageView(
+		ctx,
+		outputDiffuseCubemap->image_,
+		outputView,
+		outputDiffuseCubemap->imageFormat_,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+		0u,
+		1u,
+		0u,
+		IBLConfig::LayerCount);
+
+	VulkanDescriptorSetInfo dsInfo;
+	dsInfo.AddImage(inputImageInfo_, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT); // 0
+	dsInfo.AddBuffer(&partialBuffer_, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT); // 1
+	dsInfo.AddBuffer(outputBuffer_, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT); // 2
+	dsInfo.AddImage(
+		{
+			.imageView = outputView,
+			.imageLayout = VK_IMAGE_LAYOUT_GENERAL
+		},
+		VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		VK_SHADER_STAGE_COMPUTE_BIT); // 3
+	VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+	descriptorManager_.CreateSet(ctx, dsInfo, &descriptorSet);
+
+	// Graphics queue so the input cubemap does not need a queue family ownership transfer
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
+
+	const VkImageSubresourceRange subresourceRange =
+	{
+		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		.baseMipLevel = 0u,
+		.levelCount = 1u,
+		.baseArrayLayer = 0u,
+		.layerCount = IBLConfig::LayerCount
+	};
+	VulkanBarrier::CreateImageBarrier({
+			.commandBuffer = commandBuffer,
+			.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.sourceStage = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+			.sourceAccess = VK_ACCESS_2_NONE,
+			.newLayout = VK_IMAGE_LAYOUT_GENERAL,
+			.destinationStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.destinationAccess = VK_ACCESS_2_SHADER_WRITE_BIT
+		},
+		subresourceRange,
+		outputDiffuseCubemap->image_);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+	vkCmdBindDescriptorSets(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		pipelineLayout_,
+		0, // firstSet
+		1, // descriptorSetCount
+		&descriptorSet,
+		0, // dynamicOffsetCount
+		0); // pDynamicOffsets
+
+	ctx.InsertDebugLabel(commandBuffer, "PipelineSHProjection", 0xff9999ff);
+
+	PushConstSHProjection pc =
+	{
+		.pass = 0u,
+		.sampleSideLength = sampleSideLength_,
+		.sampleMipLevel = sampleMipLevel_,
+		.partialCount = groupCountPerSide_ * groupCountPerSide_ * IBLConfig::LayerCount
+	};
+
+	// Project tiles of every face into partial sums
+	Dispatch(commandBuffer, pc, groupCountPerSide_, groupCountPerSide_, IBLConfig::LayerCount);
+	ComputeToComputeBarrier(commandBuffer);
+
+	// Add the partial sums
+	pc.pass = 1u;
+	Dispatch(commandBuffer, pc, 1u, 1u, 1u);
+	ComputeToComputeBarrier(commandBuffer);
+
+	// Evaluate into the diffuse cubemap
+	pc.pass = 2u;
+	const uint32_t outputGroupCount = (IBLConfig::OutputDiffuseSideLength + SHWorkgroupSize - 1) / SHWorkgroupSize;
+	Dispatch(commandBuffer, pc, outputGroupCount, outputGroupCount, IBLConfig::LayerCount);
+
+	// Convention is to change the layout to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	VulkanBarrier::CreateImageBarrier({
+			.commandBuffer = commandBuffer,
+			.oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+			.sourceStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.sourceAccess = VK_ACCESS_2_SHADER_WRITE_BIT,
+			.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			.destinationStage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.destinationAccess = VK_ACCESS_2_SHADER_READ_BIT
+		},
+		subresourceRange,
+		outputDiffuseCubemap->image_);
+
+	// The coefficients are read by the host when they are cached
+	constexpr VkMemoryBarrier2 hostBarrier = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+		.pNext = nullptr,
+		.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+		.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+		.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT
+	};
+	VulkanBarrier::CreateMemoryBarrier(commandBuffer, &hostBarrier, 1u);
+
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
+
+	vkDestroyImageView(ctx.GetDevice(), outputView, nullptr);
+
+	outputDiffuseCubemap->CreateDefaultSampler(
+		ctx,
+		0.0f,
+		1.0f);
+}
+
+void PipelineSHProjection::Dispatch(
+	VkCommandBuffer commandBuffer,
+	const PushConstSHProjection& pc,
+	uint32_t groupCountX,
+	uint32_t groupCountY,
+	uint32_t groupCountZ)
+{
+	vkCmdPushConstants(
+		commandBuffer,
+		pipelineLayout_,
+		VK_SHADER_STAGE_COMPUTE_BIT,
+		0,
+		sizeof(PushConstSHProjection), &pc);
+	vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+void PipelineSHProjection::ComputeToComputeBarrier(VkCommandBuffer commandBuffer)
+{
+	constexpr VkMemoryBarrier2 barrier = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+		.pNext = nullptr,
+		.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+		.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+		.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT
+	};
+	VulkanBarrier::CreateMemoryBarrier(commandBuffer, &barrier, 1u);
+}
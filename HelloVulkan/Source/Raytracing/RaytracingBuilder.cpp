@@ -165,13 +165,14 @@ void RaytracingBuilder::CreateBLASMultipleMeshes(
 
 	// Build the acceleration structure on the device via a one-time command buffer submission
 		// Some implementations may support acceleration structure building on the host (VkPhysicalDeviceAccelerationStructureFeaturesKHR->accelerationStructureHostCommands), but we prefer device builds
-	VkCommandBuffer commandBuffer = ctx.BeginOneTimeGraphicsCommand();
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
 	vkCmdBuildAccelerationStructuresKHR(
 		commandBuffer,
 		1,
 		&accelerationStructureBuildGeometryInfo,
 		pBuildRangeInfos.data());
-	ctx.EndOneTimeGraphicsCommand(commandBuffer);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
 
 	VkAccelerationStructureDeviceAddressInfoKHR accelerationDeviceAddressInfo =
 	{
@@ -281,13 +282,14 @@ void RaytracingBuilder::CreateBLAS(VulkanContext& ctx,
 	// Build the acceleration structure on the device via a one-time command buffer submission
 	// Some implementations may support acceleration structure building on the host (VkPhysicalDeviceAccelerationStructureFeaturesKHR->accelerationStructureHostCommands), 
 	// but we prefer device builds
-	VkCommandBuffer commandBuffer = ctx.BeginOneTimeGraphicsCommand();
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
 	vkCmdBuildAccelerationStructuresKHR(
 		commandBuffer,
 		1,
 		&accelBuildGeometryInfo,
 		accelBuildStructureRangeInfos.data());
-	ctx.EndOneTimeGraphicsCommand(commandBuffer);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
 
 	VkAccelerationStructureDeviceAddressInfoKHR accelerationDeviceAddressInfo =
 	{
@@ -410,13 +412,14 @@ void RaytracingBuilder::CreateTLAS(VulkanContext& ctx,
 	// Build the acceleration structure on the device via a one-time command buffer submission
 	// Some implementations may support acceleration structure building on the host (VkPhysicalDeviceAccelerationStructureFeaturesKHR->accelerationStructureHostCommands), 
 	// but we prefer device builds
-	VkCommandBuffer commandBuffer = ctx.BeginOneTimeGraphicsCommand();
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
 	vkCmdBuildAccelerationStructuresKHR(
 		commandBuffer,
 		1,
 		&accelBuildGeometryInfo,
 		accelerationBuildStructureRangeInfos.data());
-	ctx.EndOneTimeGraphicsCommand(commandBuffer);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
 
 	VkAccelerationStructureDeviceAddressInfoKHR accelerationDeviceAddressInfo =
 	{
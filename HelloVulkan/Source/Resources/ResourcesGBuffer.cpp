@@ -6,7 +6,8 @@ constexpr uint32_t SSAO_NOISE_DIM = 16;
 constexpr uint32_t SSAO_NOISE_LENGTH = SSAO_NOISE_DIM * SSAO_NOISE_DIM;
 constexpr uint32_t SSAO_KERNEL_SIZE = 64;
 
-ResourcesGBuffer::ResourcesGBuffer()
+ResourcesGBuffer::ResourcesGBuffer(bool useInstanceID) :
+	useInstanceID_(useInstanceID)
 {
 }
 
@@ -22,6 +23,7 @@ void ResourcesGBuffer::Destroy()
 	noise_.Destroy();
 	ssao_.Destroy();
 	depth_.Destroy();
+	instanceID_.Destroy();
 	kernel_.Destroy();
 }
 
@@ -44,6 +46,7 @@ void ResourcesGBuffer::Create(VulkanContext& ctx)
 	normal_.Destroy();
 	depth_.Destroy();
 	ssao_.Destroy();
+	instanceID_.Destroy();
 
 	// Position buffer
 	position_.CreateImage(
@@ -129,6 +132,33 @@ void ResourcesGBuffer::Create(VulkanContext& ctx)
 		VK_SAMPLE_COUNT_1_BIT);
 	depth_.SetDebugName(ctx, "Depth_Image");
 
+	// Instance ID buffer, a single texel is copied for picking
+	if (useInstanceID_)
+	{
+		instanceID_.CreateImage(
+			ctx,
+			width,
+			height,
+			1u, // mip
+			1u, // layer
+			VK_FORMAT_R32_UINT,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+			VMA_MEMORY_USAGE_GPU_ONLY,
+			0u,
+			VK_SAMPLE_COUNT_1_BIT);
+		instanceID_.CreateImageView(
+			ctx,
+			VK_FORMAT_R32_UINT,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_VIEW_TYPE_2D,
+			0u,
+			1u,
+			0u,
+			1u);
+		instanceID_.SetDebugName(ctx, "G_Buffer_Instance_ID");
+	}
+
 	// Noise texture
 	if (noise_.image_ == nullptr)
 	{
@@ -189,7 +219,7 @@ void ResourcesGBuffer::Create(VulkanContext& ctx)
 
 void ResourcesGBuffer::CreateSampler(VulkanContext& ctx, VkSampler* sampler)
 {
-	VkSamplerCreateInfo samplerInfo =
+	const VkSamplerCreateInfo samplerInfo =
 	{
 		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
 		.pNext = nullptr,
@@ -206,5 +236,5 @@ void ResourcesGBuffer::CreateSampler(VulkanContext& ctx, VkSampler* sampler)
 		.maxLod = 1.0f,
 		.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
 	};
-	VK_CHECK(vkCreateSampler(ctx.GetDevice(), &samplerInfo, nullptr, sampler));
+	*sampler = ctx.GetSampler(samplerInfo);
 }
\ No newline at end of file
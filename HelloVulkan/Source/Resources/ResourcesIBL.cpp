@@ -1,8 +1,110 @@
 #include "ResourcesIBL.h"
 #include "PipelineEquirect2Cube.h"
 #include "PipelineCubeFilter.h"
+#include "PipelineCubeFilterCompute.h"
 #include "PipelineBRDFLUT.h"
+#include "PipelineSHProjection.h"
 #include "Utility.h"
+#include "Configs.h"
+#include "UBOs.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/packing.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <array>
+#include <algorithm>
+#include <bit>
+
+// Increment this if the IBL shaders change, they are not part of the cache key
+constexpr uint32_t IBLCacheVersion = 3u;
+constexpr uint32_t IBLCacheMagicNumber = 0x4c424948u; // "HIBL"
+
+struct IBLCacheHeader
+{
+	uint32_t magic_;
+	uint32_t version_;
+	uint32_t imageCount_;
+	uint32_t reserved_;
+};
+
+struct IBLCacheImageHeader
+{
+	uint32_t width_;
+	uint32_t height_;
+	uint32_t mipCount_;
+	uint32_t layerCount_;
+	uint32_t format_;
+	uint32_t reserved_;
+	uint64_t dataSize_;
+};
+
+// dataSize_ is allocated and uploaded, so it has to match the image described by the header
+static bool IsValidCacheImageHeader(const IBLCacheImageHeader& header)
+{
+	constexpr uint32_t maxSideLength = std::max({ IBLConfig::InputCubeSideLength, IBLConfig::LUTWidth, IBLConfig::LUTHeight });
+	if (header.width_ == 0 || header.width_ > maxSideLength ||
+		header.height_ == 0 || header.height_ > maxSideLength ||
+		(header.layerCount_ != 1 && header.layerCount_ != IBLConfig::LayerCount) ||
+		header.mipCount_ == 0 || header.mipCount_ > static_cast<uint32_t>(std::bit_width(std::max(header.width_, header.height_))))
+	{
+		return false;
+	}
+
+	const VkDeviceSize dataSize = VulkanImage::GetMipDataSize(
+		header.width_,
+		header.height_,
+		header.mipCount_,
+		header.layerCount_,
+		static_cast<VkFormat>(header.format_));
+	return dataSize > 0 && header.dataSize_ == dataSize;
+}
+
+// Cubemap formats that can be repacked into VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 on the CPU
+static bool CanPackSharedExponent(VkFormat format)
+{
+	return format == VK_FORMAT_R32G32B32A32_SFLOAT ||
+		format == VK_FORMAT_R16G16B16A16_SFLOAT ||
+		format == VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+}
+
+// The mip levels are tightly packed so the texels are converted one by one regardless of the mip layout
+static std::vector<char> PackSharedExponent(const std::vector<char>& data, VkFormat format)
+{
+	const size_t bytesPerPixel =
+		format == VK_FORMAT_R32G32B32A32_SFLOAT ? 4 * sizeof(float) :
+		format == VK_FORMAT_R16G16B16A16_SFLOAT ? 4 * sizeof(uint16_t) :
+		sizeof(uint32_t);
+	const size_t texelCount = data.size() / bytesPerPixel;
+
+	std::vector<char> packedData(texelCount * sizeof(uint32_t));
+	for (size_t i = 0; i < texelCount; ++i)
+	{
+		const char* texel = data.data() + i * bytesPerPixel;
+		glm::vec3 color;
+		if (format == VK_FORMAT_R32G32B32A32_SFLOAT)
+		{
+			std::memcpy(&color, texel, sizeof(glm::vec3));
+		}
+		else if (format == VK_FORMAT_R16G16B16A16_SFLOAT)
+		{
+			uint64_t halfColor;
+			std::memcpy(&halfColor, texel, sizeof(uint64_t));
+			color = glm::vec3(glm::unpackHalf4x16(halfColor));
+		}
+		else
+		{
+			uint32_t packedColor;
+			std::memcpy(&packedColor, texel, sizeof(uint32_t));
+			color = glm::unpackF2x11_1x10(packedColor);
+		}
+		const uint32_t sharedExponent = glm::packF3x9_E1x5(glm::max(color, glm::vec3(0.0f)));
+		std::memcpy(packedData.data() + i * sizeof(uint32_t), &sharedExponent, sizeof(uint32_t));
+	}
+	return packedData;
+}
 
 ResourcesIBL::ResourcesIBL(VulkanContext& ctx, const std::string& hdrFile)
 {
@@ -17,26 +119,59 @@ ResourcesIBL::~ResourcesIBL()
 
 void ResourcesIBL::Create(VulkanContext& ctx, const std::string& hdrFile)
 {
+	cubemapMipmapCount_ = static_cast<float>(Utility::MipMapCount(IBLConfig::InputCubeSideLength));
+	ChooseCubeFormats(ctx);
+	CreateSHIrradianceBuffer(ctx);
+
+	const std::string cacheFile = IBLConfig::UseCache ? GetCacheFilePath(hdrFile) : std::string();
+	if (!cacheFile.empty() && LoadFromCache(ctx, cacheFile))
+	{
+		return;
+	}
+
 	// Create a cubemap from the input HDR
 	{
-		PipelineEquirect2Cube e2c(ctx, hdrFile);
+		PipelineEquirect2Cube e2c(ctx, hdrFile, cubeFormat_);
 		e2c.OffscreenRender(ctx, &environmentCubemap_);
 	}
 
-	// Cube filtering
+	// Cube filtering, the diffuse map is created from spherical harmonics if they are enabled
+	if (IBLConfig::UseComputeFilter)
+	{
+		PipelineCubeFilterCompute cubeFilter(ctx, &(environmentCubemap_));
+		if (!IBLConfig::UseSHIrradiance)
+		{
+			cubeFilter.Execute(ctx, &diffuseCubemap_, CubeFilterType::Diffuse);
+		}
+		cubeFilter.Execute(ctx, &specularCubemap_, CubeFilterType::Specular);
+	}
+	else
 	{
 		PipelineCubeFilter cubeFilter(ctx, &(environmentCubemap_));
-		cubeFilter.OffscreenRender(ctx, &diffuseCubemap_, CubeFilterType::Diffuse);
+		if (!IBLConfig::UseSHIrradiance)
+		{
+			cubeFilter.OffscreenRender(ctx, &diffuseCubemap_, CubeFilterType::Diffuse);
+		}
 		cubeFilter.OffscreenRender(ctx, &specularCubemap_, CubeFilterType::Specular);
 	}
 
+	// Spherical harmonics, the environment cubemap is mipmapped by the cube filter above
+	if (IBLConfig::UseSHIrradiance)
+	{
+		PipelineSHProjection shProjection(ctx, &(environmentCubemap_), &shIrradianceBuffer_);
+		shProjection.Execute(ctx, &diffuseCubemap_);
+	}
+
 	// BRDF look up table
 	{
 		PipelineBRDFLUT brdfLUTCompute(ctx);
 		brdfLUTCompute.CreateLUT(ctx, &brdfLut_);
 	}
 
-	cubemapMipmapCount_ = static_cast<float>(Utility::MipMapCount(IBLConfig::InputCubeSideLength));
+	if (!cacheFile.empty())
+	{
+		SaveToCache(ctx, cacheFile);
+	}
 }
 
 void ResourcesIBL::Destroy()
@@ -45,6 +180,57 @@ void ResourcesIBL::Destroy()
 	diffuseCubemap_.Destroy();
 	specularCubemap_.Destroy();
 	brdfLut_.Destroy();
+	shIrradianceBuffer_.Destroy();
+}
+
+void ResourcesIBL::CreateSHIrradianceBuffer(VulkanContext& ctx)
+{
+	// Host visible so it can be cached, zero coefficients and enabled = 0 select the diffuse cubemap
+	shIrradianceBuffer_.CreateBuffer(
+		ctx,
+		sizeof(SHIrradianceUBO),
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VMA_MEMORY_USAGE_AUTO,
+		VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+	const SHIrradianceUBO ubo{};
+	shIrradianceBuffer_.UploadBufferData(ctx, &ubo, sizeof(SHIrradianceUBO));
+}
+
+void ResourcesIBL::ChooseCubeFormats(VulkanContext& ctx)
+{
+	// Equirect2Cube renders to the cubemap and the mipmaps are generated with blits
+	VkFormatFeatureFlags features =
+		VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+		VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+		VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT |
+		VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+		VK_FORMAT_FEATURE_BLIT_DST_BIT |
+		VK_FORMAT_FEATURE_TRANSFER_SRC_BIT;
+	if (IBLConfig::UseComputeFilter || IBLConfig::UseSHIrradiance)
+	{
+		features |= VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+	}
+
+	cubeFormat_ = IBLConfig::CubeFormat;
+	if (!ctx.IsFormatSupported(cubeFormat_, VK_IMAGE_TILING_OPTIMAL, features))
+	{
+		std::cerr << "IBL cubemap format " << cubeFormat_ << " is not supported, using " << IBLConfig::FallbackCubeFormat << '\n';
+		cubeFormat_ = IBLConfig::FallbackCubeFormat;
+	}
+
+	// Cached cubemaps are uploaded and then sampled
+	constexpr VkFormatFeatureFlags cachedFeatures =
+		VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+		VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+		VK_FORMAT_FEATURE_TRANSFER_SRC_BIT |
+		VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+	cachedCubeFormat_ = VK_FORMAT_UNDEFINED;
+	if (IBLConfig::CachedCubeFormat == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 &&
+		CanPackSharedExponent(cubeFormat_) &&
+		ctx.IsFormatSupported(IBLConfig::CachedCubeFormat, VK_IMAGE_TILING_OPTIMAL, cachedFeatures))
+	{
+		cachedCubeFormat_ = IBLConfig::CachedCubeFormat;
+	}
 }
 
 void ResourcesIBL::SetDebugNames(VulkanContext& ctx)
@@ -53,4 +239,188 @@ void ResourcesIBL::SetDebugNames(VulkanContext& ctx)
 	diffuseCubemap_.SetDebugName(ctx, "Diffuse_Cubemap");
 	specularCubemap_.SetDebugName(ctx, "Specular_Cubemap");
 	brdfLut_.SetDebugName(ctx, "BRDF_LUT");
-}
\ No newline at end of file
+}
+
+std::string ResourcesIBL::GetCacheFilePath(const std::string& hdrFile) const
+{
+	std::ifstream file(hdrFile, std::ios::binary);
+	if (!file.is_open())
+	{
+		return {};
+	}
+	const std::vector<char> hdrData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	const uint32_t settings[] =
+	{
+		IBLCacheVersion,
+		IBLConfig::OutputDiffuseSampleCount,
+		IBLConfig::InputCubeSideLength,
+		IBLConfig::OutputDiffuseSideLength,
+		IBLConfig::OutputSpecularSideLength,
+		IBLConfig::LayerCount,
+		static_cast<uint32_t>(cubeFormat_),
+		static_cast<uint32_t>(cachedCubeFormat_),
+		static_cast<uint32_t>(IBLConfig::UseComputeFilter),
+		IBLConfig::ComputeDiffuseSampleCount,
+		IBLConfig::ComputeSpecularSampleCount,
+		static_cast<uint32_t>(IBLConfig::UseSHIrradiance),
+		IBLConfig::SHSampleSideLength,
+		IBLConfig::LUTSampleCount,
+		IBLConfig::LUTWidth,
+		IBLConfig::LUTHeight,
+		static_cast<uint32_t>(IBLConfig::LUTFormat)
+	};
+	uint64_t hash = Utility::Hash(hdrData.data(), hdrData.size());
+	hash = Utility::Hash(settings, sizeof(settings), hash);
+
+	return Utility::GetCacheFilePath(IBLConfig::CacheFolder, hash, ".ibl");
+}
+
+bool ResourcesIBL::LoadFromCache(VulkanContext& ctx, const std::string& cacheFile)
+{
+	std::ifstream file(cacheFile, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	const std::array<VulkanImage*, 4> images = { &environmentCubemap_, &diffuseCubemap_, &specularCubemap_, &brdfLut_ };
+
+	IBLCacheHeader header{};
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		header.magic_ != IBLCacheMagicNumber ||
+		header.version_ != IBLCacheVersion ||
+		header.imageCount_ != images.size())
+	{
+		std::cerr << "Ignoring invalid IBL cache file " << cacheFile << '\n';
+		return false;
+	}
+
+	// Read everything first so a truncated file does not leave half of the images created
+	std::array<IBLCacheImageHeader, 4> imageHeaders{};
+	std::array<std::vector<char>, 4> imageData{};
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		if (!file.read(reinterpret_cast<char*>(&imageHeaders[i]), sizeof(IBLCacheImageHeader)) ||
+			!IsValidCacheImageHeader(imageHeaders[i]))
+		{
+			std::cerr << "Ignoring corrupted IBL cache file " << cacheFile << '\n';
+			return false;
+		}
+		imageData[i].resize(static_cast<size_t>(imageHeaders[i].dataSize_));
+		if (!file.read(imageData[i].data(), static_cast<std::streamsize>(imageData[i].size())))
+		{
+			std::cerr << "Ignoring corrupted IBL cache file " << cacheFile << '\n';
+			return false;
+		}
+	}
+
+	// The file may have been written on another device
+	for (const IBLCacheImageHeader& imageHeader : imageHeaders)
+	{
+		const VkFormat format = static_cast<VkFormat>(imageHeader.format_);
+		if (!ctx.IsFormatSupported(format, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT))
+		{
+			std::cerr << "Ignoring IBL cache file " << cacheFile << " with unsupported format " << format << '\n';
+			return false;
+		}
+	}
+
+	SHIrradianceUBO shIrradiance{};
+	if (!file.read(reinterpret_cast<char*>(&shIrradiance), sizeof(SHIrradianceUBO)))
+	{
+		std::cerr << "Ignoring corrupted IBL cache file " << cacheFile << '\n';
+		return false;
+	}
+	shIrradianceBuffer_.UploadBufferData(ctx, &shIrradiance, sizeof(SHIrradianceUBO));
+
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		const IBLCacheImageHeader& imageHeader = imageHeaders[i];
+		const VkFormat format = static_cast<VkFormat>(imageHeader.format_);
+		const bool isCubemap = imageHeader.layerCount_ == IBLConfig::LayerCount;
+
+		images[i]->CreateImageFromMipData(
+			ctx,
+			imageData[i].data(),
+			imageHeader.width_,
+			imageHeader.height_,
+			imageHeader.mipCount_,
+			imageHeader.layerCount_,
+			format,
+			isCubemap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0);
+		images[i]->CreateImageView(
+			ctx,
+			format,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			isCubemap ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D,
+			0u,
+			imageHeader.mipCount_,
+			0u,
+			imageHeader.layerCount_);
+	}
+
+	// Same samplers as the pipelines that generate these images
+	environmentCubemap_.CreateDefaultSampler(ctx);
+	diffuseCubemap_.CreateDefaultSampler(ctx, 0.0f, static_cast<float>(diffuseCubemap_.mipCount_));
+	specularCubemap_.CreateDefaultSampler(ctx, 0.0f, static_cast<float>(specularCubemap_.mipCount_));
+	brdfLut_.CreateDefaultSampler(ctx);
+
+	return true;
+}
+
+void ResourcesIBL::SaveToCache(VulkanContext& ctx, const std::string& cacheFile)
+{
+	const auto append = [](std::vector<char>& bytes, const void* data, size_t size)
+	{
+		const char* begin = static_cast<const char*>(data);
+		bytes.insert(bytes.end(), begin, begin + size);
+	};
+
+	const std::array<VulkanImage*, 4> images = { &environmentCubemap_, &diffuseCubemap_, &specularCubemap_, &brdfLut_ };
+
+	std::vector<char> bytes;
+	const IBLCacheHeader header =
+	{
+		.magic_ = IBLCacheMagicNumber,
+		.version_ = IBLCacheVersion,
+		.imageCount_ = static_cast<uint32_t>(images.size()),
+		.reserved_ = 0u
+	};
+	append(bytes, &header, sizeof(header));
+
+	for (VulkanImage* image : images)
+	{
+		std::vector<char> imageData = image->DownloadImageData(ctx);
+
+		// Only the cubemaps are repacked, the BRDF LUT keeps its format
+		VkFormat format = image->imageFormat_;
+		if (cachedCubeFormat_ != VK_FORMAT_UNDEFINED && image->layerCount_ == IBLConfig::LayerCount)
+		{
+			imageData = PackSharedExponent(imageData, format);
+			format = cachedCubeFormat_;
+		}
+
+		const IBLCacheImageHeader imageHeader =
+		{
+			.width_ = image->width_,
+			.height_ = image->height_,
+			.mipCount_ = image->mipCount_,
+			.layerCount_ = image->layerCount_,
+			.format_ = static_cast<uint32_t>(format),
+			.reserved_ = 0u,
+			.dataSize_ = static_cast<uint64_t>(imageData.size())
+		};
+		append(bytes, &imageHeader, sizeof(imageHeader));
+		append(bytes, imageData.data(), imageData.size());
+	}
+
+	SHIrradianceUBO shIrradiance{};
+	shIrradianceBuffer_.DownloadBufferData(ctx, &shIrradiance, sizeof(SHIrradianceUBO));
+	append(bytes, &shIrradiance, sizeof(SHIrradianceUBO));
+
+	if (!Utility::WriteFileAtomically(cacheFile, bytes))
+	{
+		std::cerr << "Cannot write IBL cache file " << cacheFile << '\n';
+	}
+}
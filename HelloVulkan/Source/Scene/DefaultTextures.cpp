@@ -0,0 +1,31 @@
+#include "DefaultTextures.h"
+
+void DefaultTextures::Create(VulkanContext& ctx)
+{
+	uint32_t black = 0xff000000;
+	images_[static_cast<uint32_t>(DefaultTexture::Black)].CreateImageResources(ctx, &black, 1, 1);
+	images_[static_cast<uint32_t>(DefaultTexture::Black)].SetDebugName(ctx, "Default_Black_Texture");
+
+	// TODO Investigate a correct value for normal vector
+	uint32_t normal = 0xffff8888;
+	images_[static_cast<uint32_t>(DefaultTexture::Normal)].CreateImageResources(ctx, &normal, 1, 1);
+	images_[static_cast<uint32_t>(DefaultTexture::Normal)].SetDebugName(ctx, "Default_Normal_Texture");
+}
+
+void DefaultTextures::Destroy()
+{
+	for (VulkanImage& image : images_)
+	{
+		image.Destroy();
+	}
+}
+
+std::vector<VkDescriptorImageInfo> DefaultTextures::GetImageInfos() const
+{
+	std::vector<VkDescriptorImageInfo> imageInfos;
+	for (const VulkanImage& image : images_)
+	{
+		imageInfos.emplace_back(image.GetDescriptorImageInfo());
+	}
+	return imageInfos;
+}
\ No newline at end of file
@@ -8,20 +8,20 @@
 
 #include <iostream>
 #include <ranges>
+#include <utility>
 
-static const std::string DEFAULT_BLACK_TEXTURE = "DefaultBlackTexture";
-static const std::string DEFAULT_NORMAL_TEXTURE = "DefaultNormalTexture";
+static constexpr uint32_t DEFAULT_BLACK_TEXTURE = static_cast<uint32_t>(DefaultTexture::Black);
+static constexpr uint32_t DEFAULT_NORMAL_TEXTURE = static_cast<uint32_t>(DefaultTexture::Normal);
 
 inline glm::mat4 CastToGLMMat4(const aiMatrix4x4& m)
 {
 	return glm::transpose(glm::make_mat4(&m.a1));
 }
 
-void Model::LoadSlotBased(VulkanContext& ctx, const std::string& path)
+void Model::LoadSlotBased(VulkanContext& ctx, DefaultTextures* defaultTextures, const std::string& path)
 {
 	bindlessTexture_ = false;
-
-	CreateDefaultTextures(ctx);
+	defaultTextures_ = defaultTextures;
 
 	// Load model here
 	SceneData dummySceneData{};
@@ -36,13 +36,15 @@ void Model::LoadSlotBased(VulkanContext& ctx, const std::string& path)
 
 void Model::LoadBindless(
 	VulkanContext& ctx,
+	DefaultTextures* defaultTextures,
 	const ModelCreateInfo& modelInfo,
-	SceneData& sceneData)
+	SceneData& sceneData,
+	bool deferTextures)
 {
 	bindlessTexture_ = true;
+	deferTextures_ = deferTextures;
 	modelInfo_ = modelInfo;
-
-	CreateDefaultTextures(ctx);
+	defaultTextures_ = defaultTextures;
 
 	// Load model here
 	LoadModel(
@@ -90,16 +92,6 @@ void Model::SetModelUBO(VulkanContext& ctx, ModelUBO ubo)
 	}
 }
 
-void Model::CreateDefaultTextures(VulkanContext& ctx)
-{
-	uint32_t black = 0xff000000;
-	AddTexture(ctx, DEFAULT_BLACK_TEXTURE, (void*)&black, 1, 1);
-
-	// TODO Investigate a correct value for normal vector
-	uint32_t normal = 0xffff8888;
-	AddTexture(ctx, DEFAULT_NORMAL_TEXTURE, (void*)&normal, 1, 1);
-}
-
 // Loads a model with supported ASSIMP extensions from file and 
 // stores the resulting meshes in the meshes vector.
 void Model::LoadModel(VulkanContext& ctx,
@@ -123,12 +115,22 @@ void Model::LoadModel(VulkanContext& ctx,
 	processAnimation_ = modelInfo_.playAnimation && scene_->mAnimations;
 	if (processAnimation_) { boneCounter_ = static_cast<int>(sceneData.boneMatrixCount_); }
 
-	// Process assimp's root node recursively
-	ProcessNode(
-		ctx,
-		sceneData,
-		scene_->mRootNode,
-		glm::mat4(1.0));
+	// Skinned meshes are moved by the bones so they are always baked
+	if (modelInfo_.nodeHierarchy && !processAnimation_)
+	{
+		ProcessNodeHierarchy(ctx, sceneData);
+	}
+	else
+	{
+		nodes_ = { ModelNode{} };
+
+		// Process assimp's root node recursively
+		ProcessNode(
+			ctx,
+			sceneData,
+			scene_->mRootNode,
+			glm::mat4(1.0));
+	}
 
 	if (processAnimation_) { sceneData.boneMatrixCount_ += AppConfig::MaxSkinningMatrices; }
 }
@@ -164,6 +166,43 @@ void Model::ProcessNode(
 	}
 }
 
+void Model::ProcessNodeHierarchy(
+	VulkanContext& ctx,
+	SceneData& sceneData)
+{
+	// The first node belongs to the instance, the assimp root is its only child
+	nodes_ = { ModelNode{} };
+
+	// The queue only grows so it is visited in breadth-first order, each entry has the parent index
+	std::vector<std::pair<const aiNode*, uint32_t>> queue = { { scene_->mRootNode, 0u } };
+	for (size_t q = 0; q < queue.size(); ++q)
+	{
+		const auto [node, parentIndex] = queue[q];
+		const uint32_t nodeIndex = static_cast<uint32_t>(nodes_.size());
+		nodes_.push_back(
+		{
+			.name_ = node->mName.C_Str(),
+			.localTransform_ = CastToGLMMat4(node->mTransformation),
+			.parentIndex_ = parentIndex
+		});
+
+		for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+		{
+			const aiMesh* mesh = scene_->mMeshes[node->mMeshes[i]];
+			ProcessMesh(
+				ctx,
+				sceneData,
+				mesh,
+				glm::mat4(1.0));
+			meshes_.back().SetNodeIndex(nodeIndex);
+		}
+		for (unsigned int i = 0; i < node->mNumChildren; ++i)
+		{
+			queue.emplace_back(node->mChildren[i], nodeIndex);
+		}
+	}
+}
+
 void Model::ProcessMesh(
 	VulkanContext& ctx,
 	SceneData& sceneData,
@@ -392,29 +431,47 @@ std::vector<uint32_t> Model::GetMeshIndices(const aiMesh* mesh)
 
 void Model::AddTexture(VulkanContext& ctx, const std::string& textureFilename)
 {
-	const std::string fullFilePath = this->directory_ + '/' + textureFilename;
-	textureList_.emplace_back().CreateImageResources(ctx, fullFilePath.c_str());
-	textureMap_[textureFilename] = static_cast<uint32_t>(textureList_.size() - 1);
+	textureMap_[textureFilename] = DefaultTextureCount + static_cast<uint32_t>(textureFilenames_.size());
+	textureFilenames_.push_back(textureFilename);
+	if (!deferTextures_)
+	{
+		const std::string fullFilePath = this->directory_ + '/' + textureFilename;
+		textureList_.emplace_back().CreateImageResources(ctx, fullFilePath.c_str());
+	}
+}
+
+std::vector<std::string> Model::GetTextureFilePaths() const
+{
+	std::vector<std::string> filePaths;
+	filePaths.reserve(textureFilenames_.size());
+	for (const std::string& filename : textureFilenames_)
+	{
+		filePaths.push_back(this->directory_ + '/' + filename);
+	}
+	return filePaths;
 }
 
-void Model::AddTexture(VulkanContext& ctx, const std::string& textureName, void* data, int width, int height)
+void Model::SetTextures(std::vector<VulkanImage>&& textures)
 {
-	textureList_.emplace_back().CreateImageResources(
-		ctx,
-		data,
-		1,
-		1);
-	textureMap_[textureName] = static_cast<uint32_t>(textureList_.size() - 1);
+	if (textures.size() != textureFilenames_.size())
+	{
+		std::cerr << "Texture count of " << filepath_ << " does not match its materials\n";
+	}
+	textureList_ = std::move(textures);
 }
 
 VulkanImage* Model::GetTexture(uint32_t textureIndex)
 {
-	if (textureIndex < 0 || textureIndex >= textureList_.size())
+	if (textureIndex < DefaultTextureCount)
+	{
+		return defaultTextures_->Get(textureIndex);
+	}
+	if (textureIndex - DefaultTextureCount >= textureList_.size())
 	{
 		std::cerr << "Failed to retrieve a texture because the textureIndex is out of bound\n";
 		return nullptr;
 	}
-	return &(textureList_[textureIndex]);
+	return &(textureList_[textureIndex - DefaultTextureCount]);
 }
 
 std::unordered_map<TextureType, uint32_t> Model::GetTextureIndices(
@@ -451,17 +508,17 @@ std::unordered_map<TextureType, uint32_t> Model::GetTextureIndices(
 
 	// Replace missing PBR textures with a black 1x1 texture
 	if (!textures.contains(TextureType::Albedo))
-		{ textures[TextureType::Albedo] = textureMap_[DEFAULT_BLACK_TEXTURE]; }
+		{ textures[TextureType::Albedo] = DEFAULT_BLACK_TEXTURE; }
 	if (!textures.contains(TextureType::Normal))
-		{ textures[TextureType::Normal] = textureMap_[DEFAULT_NORMAL_TEXTURE]; }
+		{ textures[TextureType::Normal] = DEFAULT_NORMAL_TEXTURE; }
 	if (!textures.contains(TextureType::Metalness))
-		{ textures[TextureType::Metalness] = textureMap_[DEFAULT_BLACK_TEXTURE]; }
+		{ textures[TextureType::Metalness] = DEFAULT_BLACK_TEXTURE; }
 	if (!textures.contains(TextureType::Roughness))
-		{ textures[TextureType::Roughness] = textureMap_[DEFAULT_BLACK_TEXTURE]; }
+		{ textures[TextureType::Roughness] = DEFAULT_BLACK_TEXTURE; }
 	if (!textures.contains(TextureType::AmbientOcclusion))
-		{ textures[TextureType::AmbientOcclusion] = textureMap_[DEFAULT_BLACK_TEXTURE]; }
+		{ textures[TextureType::AmbientOcclusion] = DEFAULT_BLACK_TEXTURE; }
 	if (!textures.contains(TextureType::Emissive))
-		{ textures[TextureType::Emissive] = textureMap_[DEFAULT_BLACK_TEXTURE]; }
+		{ textures[TextureType::Emissive] = DEFAULT_BLACK_TEXTURE; }
 
 	return textures;
 }
\ No newline at end of file
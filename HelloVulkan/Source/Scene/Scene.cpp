@@ -2,19 +2,240 @@
 
 #include "glm/glm.hpp"
 
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+// Draw slot ranges are compacted when they have at least this many holes and holes are half of the used slots
+constexpr uint32_t DrawSlotCompactionMinHoles = 64;
+
+// Depth buckets are logarithmic so near draws are ordered finer, 16 bits cover any distance
+constexpr float DrawSortDepthBucketScale = 2048.0f;
+
+// Draw slot without an instanced command, same as DRAW_GROUP_NONE in FrustumCullingInstanced.comp
+constexpr uint32_t DrawGroupNone = std::numeric_limits<uint32_t>::max();
+
+// Vulkan does not allow empty buffers, a scene that is still loading has no data yet
+template<typename T>
+static void CreateGPUOnlyArrayBuffer(
+	VulkanContext& ctx,
+	VulkanBuffer& buffer,
+	const std::vector<T>& data,
+	VkBufferUsageFlags bufferUsage)
+{
+	const T placeholder{};
+	buffer.CreateGPUOnlyBuffer(
+		ctx,
+		sizeof(T) * std::max<size_t>(data.size(), 1),
+		data.empty() ? &placeholder : data.data(),
+		bufferUsage);
+}
+
+// Rewrites a buffer of CreateGPUOnlyArrayBuffer() if data has the same length, the buffer must not be in use.
+// Returns false if the length changed
+template<typename T>
+static bool RewriteGPUOnlyArrayBuffer(
+	VulkanContext& ctx,
+	VulkanBuffer& buffer,
+	const std::vector<T>& data)
+{
+	if (buffer.buffer_ == nullptr || data.empty() || buffer.size_ != sizeof(T) * data.size())
+	{
+		return false;
+	}
+
+	VulkanBuffer stagingBuffer;
+	stagingBuffer.CreateBuffer(
+		ctx,
+		buffer.size_,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VMA_MEMORY_USAGE_CPU_ONLY);
+	memcpy(stagingBuffer.vmaInfo_.pMappedData, data.data(), buffer.size_);
+	buffer.CopyFrom(ctx, stagingBuffer.buffer_, buffer.size_);
+	stagingBuffer.Destroy();
+	return true;
+}
+
+// Writes getElement(slot) to each slot of a GPU only buffer with one copy command, the buffer must not be in use
+template<typename T, typename GetElementFunction>
+static void UploadSlots(
+	VulkanContext& ctx,
+	VulkanBuffer& buffer,
+	std::span<const uint32_t> slots,
+	GetElementFunction&& getElement)
+{
+	if (slots.empty())
+	{
+		return;
+	}
+
+	VulkanBuffer stagingBuffer;
+	stagingBuffer.CreateBuffer(
+		ctx,
+		sizeof(T) * slots.size(),
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VMA_MEMORY_USAGE_CPU_ONLY);
+	T* stagedElements = static_cast<T*>(stagingBuffer.vmaInfo_.pMappedData);
+	std::vector<VkBufferCopy> regions(slots.size());
+	for (size_t i = 0; i < slots.size(); ++i)
+	{
+		stagedElements[i] = getElement(slots[i]);
+		regions[i] =
+		{
+			.srcOffset = sizeof(T) * i,
+			.dstOffset = sizeof(T) * slots[i],
+			.size = sizeof(T)
+		};
+	}
+
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
+	vkCmdCopyBuffer(commandBuffer, stagingBuffer.buffer_, buffer.buffer_, static_cast<uint32_t>(regions.size()), regions.data());
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
+	stagingBuffer.Destroy();
+}
+
+/*Material, then model, then mesh, then depth bucket.
+The pipeline of a draw only depends on its material, so the model is the next state that changes,
+the meshes of a model share the textures and are next to each other in the vertex buffer*/
+static uint64_t GetDrawSortKey(const InstanceData& iData, float viewDistance)
+{
+	uint64_t depthBucket = std::min(
+		static_cast<uint64_t>(std::log2(1.0f + viewDistance) * DrawSortDepthBucketScale),
+		0xFFFFull);
+	if (iData.material_ == MaterialType::Transparent)
+	{
+		depthBucket = 0xFFFFull - depthBucket;
+	}
+	return (static_cast<uint64_t>(iData.material_) << 56) |
+		(static_cast<uint64_t>(iData.modelIndex_ & 0xFFFFu) << 40) |
+		(static_cast<uint64_t>(iData.perModelMeshIndex_ & 0xFFFFFFu) << 16) |
+		depthBucket;
+}
+
+static InstanceData CreateFreeDrawSlot(MaterialType material)
+{
+	return
+	{
+		.material_ = material,
+		.removed_ = true
+	};
+}
+
+// Calls rangeFunction(first, count) for each run of set bits and clears the bits
+template<typename RangeFunction>
+static void ConsumeBitRanges(std::vector<uint64_t>& bits, RangeFunction&& rangeFunction)
+{
+	bool inRange = false;
+	uint32_t first = 0;
+	for (size_t w = 0; w < bits.size(); ++w)
+	{
+		const uint64_t word = std::exchange(bits[w], 0ull);
+		const uint32_t wordStart = static_cast<uint32_t>(w * 64);
+		uint32_t bit = 0;
+		while (bit < 64)
+		{
+			// Find the next set bit outside a range, or the next clear bit inside one
+			const uint64_t rest = (inRange ? ~word : word) >> bit;
+			if (rest == 0)
+			{
+				break;
+			}
+			bit += static_cast<uint32_t>(std::countr_zero(rest));
+			if (inRange)
+			{
+				rangeFunction(first, wordStart + bit - first);
+			}
+			else
+			{
+				first = wordStart + bit;
+			}
+			inRange = !inRange;
+		}
+	}
+	if (inRange)
+	{
+		rangeFunction(first, static_cast<uint32_t>(bits.size() * 64) - first);
+	}
+}
+
+// Moller-Trumbore, both sides of the triangle can be hit
+static bool IntersectTriangle(
+	const Ray& ray,
+	const glm::vec3& p0,
+	const glm::vec3& p1,
+	const glm::vec3& p2,
+	float& t,
+	glm::vec2& barycentric)
+{
+	constexpr float epsilon = 1e-8f;
+	const glm::vec3 edge1 = p1 - p0;
+	const glm::vec3 edge2 = p2 - p0;
+	const glm::vec3 p = glm::cross(ray.direction_, edge2);
+	const float det = glm::dot(edge1, p);
+	if (std::abs(det) < epsilon)
+	{
+		return false;
+	}
+	const float invDet = 1.0f / det;
+	const glm::vec3 s = ray.origin_ - p0;
+	const float u = glm::dot(s, p) * invDet;
+	if (u < 0.0f || u > 1.0f)
+	{
+		return false;
+	}
+	const glm::vec3 q = glm::cross(s, edge1);
+	const float v = glm::dot(ray.direction_, q) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+	{
+		return false;
+	}
+	t = glm::dot(edge2, q) * invDet;
+	barycentric = glm::vec2(u, v);
+	return t > 0.0f;
+}
 
 Scene::Scene(VulkanContext& ctx,
-	const std::span<ModelCreateInfo> modelInfoArray)
+	const std::span<ModelCreateInfo> modelInfoArray,
+	bool loadAsync) :
+	modelCount_(static_cast<uint32_t>(modelInfoArray.size()))
 {
-	uint32_t vertexOffset = 0u;
-	uint32_t indexOffset = 0u;
+	defaultTextures_.Create(ctx);
+
+	const bool playAnimation = std::ranges::any_of(modelInfoArray,
+		[](const ModelCreateInfo& mInfo) { return mInfo.playAnimation; });
+	if (loadAsync && !playAnimation)
+	{
+		// The descriptor layout of the texture array is created once so it has a fixed size
+		textureCapacity_ = AppConfig::SceneTextureCapacity;
+		CreateBindlessResources(ctx);
+		loadThread_ = std::jthread(
+			[this, &ctx, modelInfos = std::vector<ModelCreateInfo>(modelInfoArray.begin(), modelInfoArray.end())]
+			(std::stop_token stopToken)
+			{
+				LoadModelsAsync(ctx, modelInfos, stopToken);
+			});
+		return;
+	}
+	if (loadAsync)
+	{
+		std::cerr << "Scene with animation is loaded synchronously\n";
+	}
+
 	for (const ModelCreateInfo& mInfo : modelInfoArray)
 	{
 		std::cout << "Load " << mInfo.filename << '\n';
 		Model m;
 		m.LoadBindless(
 			ctx,
+			&defaultTextures_,
 			mInfo,
 			sceneData_);
 		models_.push_back(m);
@@ -27,77 +248,264 @@ Scene::Scene(VulkanContext& ctx,
 
 Scene::~Scene()
 {
+	StopLoading();
+	DestroyBindlessResources();
+	textureStreamer_.Destroy();
 	boneIDBuffer_.Destroy();
 	boneWeightBuffer_.Destroy();
 	skinningIndicesBuffer_.Destroy();
 	preSkinningVertexBuffer_.Destroy();
+	for (auto& buffer : boneMatricesBuffers_)
+	{
+		buffer.Destroy();
+	}
+	for (auto& model : models_)
+	{
+		model.Destroy();
+	}
+	defaultTextures_.Destroy();
+}
+
+void Scene::DestroyBindlessResources()
+{
 	vertexBuffer_.Destroy();
 	indexBuffer_.Destroy();
 	indirectBuffer_.Destroy();
 	meshDataBuffer_.Destroy();
+	materialDataBuffer_.Destroy();
 	transformedBoundingBoxBuffer_.Destroy();
 	for (auto& buffer : modelSSBOBuffers_)
 	{
 		buffer.Destroy();
 	}
-	for (auto& buffer : boneMatricesBuffers_)
+	DestroyInstancedDrawBuffers();
+}
+
+void Scene::DestroyInstancedDrawBuffers()
+{
+	instancedIndirectBuffer_.Destroy();
+	instancedIndirectResetBuffer_.Destroy();
+	instanceIndexBuffer_.Destroy();
+	drawGroupIndexBuffer_.Destroy();
+}
+
+// Runs on loadThread_, the models are published in order so model indices match modelInfoArray
+void Scene::LoadModelsAsync(VulkanContext& ctx, std::vector<ModelCreateInfo> modelInfoArray, std::stop_token stopToken)
+{
+	try
 	{
-		buffer.Destroy();
+		// Geometry of all models first so the scene is visible early
+		uint32_t vertexOffset = 0u;
+		uint32_t indexOffset = 0u;
+		std::vector<std::vector<std::string>> texturePaths;
+		for (const ModelCreateInfo& mInfo : modelInfoArray)
+		{
+			if (stopToken.stop_requested()) { return; }
+
+			std::cout << "Load " << mInfo.filename << '\n';
+			LoadedModel loaded{};
+
+			// The offsets continue from the previous models so the meshes index the final buffers
+			loaded.sceneData_.vertexOffsets_.push_back(vertexOffset);
+			loaded.sceneData_.indexOffsets_.push_back(indexOffset);
+			loaded.model_.LoadBindless(ctx, &defaultTextures_, mInfo, loaded.sceneData_, true);
+			loaded.sceneData_.vertexOffsets_.erase(loaded.sceneData_.vertexOffsets_.begin());
+			loaded.sceneData_.indexOffsets_.erase(loaded.sceneData_.indexOffsets_.begin());
+			vertexOffset += static_cast<uint32_t>(loaded.sceneData_.vertices_.size());
+			indexOffset += static_cast<uint32_t>(loaded.sceneData_.indices_.size());
+			texturePaths.push_back(loaded.model_.GetTextureFilePaths());
+
+			std::lock_guard<std::mutex> lock(loadMutex_);
+			loadedModels_.push_back(std::move(loaded));
+		}
+
+		// Then the textures, one model at a time
+		for (uint32_t m = 0; m < texturePaths.size(); ++m)
+		{
+			std::vector<VulkanImage> textures(texturePaths[m].size());
+			for (size_t i = 0; i < textures.size(); ++i)
+			{
+				if (stopToken.stop_requested())
+				{
+					for (size_t j = 0; j < i; ++j)
+					{
+						textures[j].Destroy();
+					}
+					return;
+				}
+				textures[i].CreateImageResources(ctx, texturePaths[m][i].c_str());
+			}
+
+			std::lock_guard<std::mutex> lock(loadMutex_);
+			loadedTextures_.push_back({ .modelIndex_ = m, .textures_ = std::move(textures) });
+		}
+		std::cout << "Scene loaded\n";
 	}
-	for (auto& model : models_)
+	catch (...)
 	{
-		model.Destroy();
+		std::lock_guard<std::mutex> lock(loadMutex_);
+		loadException_ = std::current_exception();
 	}
+	loadFinished_ = true;
 }
 
-BDA Scene::GetBDA() const
+void Scene::StopLoading()
 {
-	return
+	if (!loadThread_.joinable())
 	{
-		.vertexBufferAddress = vertexBuffer_.deviceAddress_,
-		.indexBufferAddress = indexBuffer_.deviceAddress_,
-		.meshDataBufferAddress = meshDataBuffer_.deviceAddress_
-	};
-}
-
-void Scene::GetOffsetAndDrawCount(MaterialType matType, VkDeviceSize& offset, uint32_t& drawCount) const
-{
-	offset = 0;
-	drawCount = 0;
+		return;
+	}
+	loadThread_.request_stop();
+	loadThread_.join();
 
-	const int meshDataSize = static_cast<int>(meshDataArray_.size());
-	
-	// Calculate left
-	int left = 0;
-	for (; left < meshDataSize; ++left)
+	// Never published
+	for (auto& loaded : loadedModels_)
 	{
-		if (meshDataArray_[left].material_ == matType)
+		loaded.model_.Destroy();
+	}
+	for (auto& loaded : loadedTextures_)
+	{
+		for (auto& texture : loaded.textures_)
 		{
-			break;
+			texture.Destroy();
 		}
 	}
+	loadedModels_.clear();
+	loadedTextures_.clear();
+}
 
-	// Calculate right
-	int right = meshDataSize - 1;
-	for (; right >= 0 && right > left; --right)
+bool Scene::Update(VulkanContext& ctx)
+{
+	std::vector<LoadedModel> loadedModels;
+	std::vector<LoadedTextures> loadedTextures;
 	{
-		if (meshDataArray_[right].material_ == matType)
+		std::lock_guard<std::mutex> lock(loadMutex_);
+		if (loadException_)
 		{
-			break;
+			std::rethrow_exception(std::exchange(loadException_, nullptr));
 		}
+		loadedModels.swap(loadedModels_);
+		loadedTextures.swap(loadedTextures_);
+	}
+	const bool instancesChanged = !addedInstances_.empty() || !removedInstances_.empty() || drawSortRequested_;
+	if (loadedModels.empty() && loadedTextures.empty() && !instancesChanged)
+	{
+		return false;
+	}
+
+	ZoneScopedNC("Scene::Update", tracy::Color::GreenYellow);
+
+	// The current buffers may still be used by frames in flight
+	{
+		const auto queueLock = ctx.LockQueues();
+		vkDeviceWaitIdle(ctx.GetDevice());
+	}
+
+	// Instances cannot change while loading, see CanEditInstances()
+	if (loadedModels.empty() && loadedTextures.empty())
+	{
+		return ApplyInstanceChanges(ctx);
+	}
+
+	for (LoadedModel& loaded : loadedModels)
+	{
+		const SceneData& data = loaded.sceneData_;
+		sceneData_.vertices_.insert(std::end(sceneData_.vertices_), std::begin(data.vertices_), std::end(data.vertices_));
+		sceneData_.indices_.insert(std::end(sceneData_.indices_), std::begin(data.indices_), std::end(data.indices_));
+		sceneData_.vertexOffsets_.insert(std::end(sceneData_.vertexOffsets_), std::begin(data.vertexOffsets_), std::end(data.vertexOffsets_));
+		sceneData_.indexOffsets_.insert(std::end(sceneData_.indexOffsets_), std::begin(data.indexOffsets_), std::end(data.indexOffsets_));
+		models_.push_back(std::move(loaded.model_));
+	}
+	for (LoadedTextures& loaded : loadedTextures)
+	{
+		models_[loaded.modelIndex_].SetTextures(std::move(loaded.textures_));
+	}
+
+	uint32_t textureCount = 0u;
+	for (const Model& model : models_)
+	{
+		textureCount += model.GetTextureCount();
+	}
+	if (textureCount > textureCapacity_)
+	{
+		throw std::runtime_error("Scene has " + std::to_string(textureCount) +
+			" textures, increase AppConfig::SceneTextureCapacity");
+	}
+
+	if (textureStreaming_)
+	{
+		AddStreamedTextures(ctx);
+	}
+
+	DestroyBindlessResources();
+	CreateBindlessResources(ctx);
+	return true;
+}
+
+void Scene::EnableTextureStreaming(VulkanContext& ctx)
+{
+	textureStreaming_ = true;
+	textureStreamer_.Create(ctx, static_cast<uint32_t>(GetImageInfos().size()));
+	AddStreamedTextures(ctx);
+}
+
+void Scene::EnableInstancedDraws(VulkanContext& ctx)
+{
+	instancedDraws_ = true;
+	CreateInstancedDrawBuffers(ctx);
+}
+
+void Scene::UpdateTextureStreaming(VulkanContext& ctx)
+{
+	if (!textureStreaming_)
+	{
+		return;
 	}
 
-	// Edge case
-	if (left > right)
+	ZoneScopedNC("UpdateTextureStreaming", tracy::Color::Orange);
+	textureStreamer_.Update(ctx);
+}
+
+// Same texture indices as GetImageInfos()
+void Scene::AddStreamedTextures(VulkanContext& ctx)
+{
+	uint32_t textureIndex = DefaultTextureCount;
+	for (Model& model : models_)
 	{
-		offset = 0;
-		drawCount = 0;
+		if (!model.TexturesLoaded())
+		{
+			textureIndex += model.GetTextureCount();
+			continue;
+		}
+		for (VulkanImage& texture : model.textureList_)
+		{
+			if (!textureStreamer_.IsStreamed(textureIndex))
+			{
+				textureStreamer_.AddTexture(ctx, textureIndex, texture);
+			}
+			++textureIndex;
+		}
 	}
+}
 
-	// if left == right, then drawCount == 1
+BDA Scene::GetBDA() const
+{
+	return
+	{
+		.vertexBufferAddress = vertexBuffer_.deviceAddress_,
+		.indexBufferAddress = indexBuffer_.deviceAddress_,
+		.meshDataBufferAddress = meshDataBuffer_.deviceAddress_,
+		.materialDataBufferAddress = materialDataBuffer_.deviceAddress_,
+		.instanceIndexBufferAddress = instancedDraws_ ? instanceIndexBuffer_.deviceAddress_ : 0u
+	};
+}
 
-	drawCount = right - left + 1;
-	offset = left * sizeof(VkDrawIndirectCommand);
+void Scene::GetOffsetAndDrawCount(MaterialType matType, VkDeviceSize& offset, uint32_t& drawCount) const
+{
+	// The free capacity after used_ is skipped
+	const DrawSlotRange& range = drawSlotRanges_[static_cast<uint32_t>(matType)];
+	offset = range.first_ * sizeof(VkDrawIndirectCommand);
+	drawCount = range.used_;
 }
 
 void Scene::GetVertexOffsetAndCount(
@@ -153,51 +561,136 @@ void Scene::CreateBindlessResources(VulkanContext& ctx)
 	
 	// Vertices
 	// NOTE This may contain post-skinning vertices
-	const VkDeviceSize vertexBufferSize = sizeof(VertexData) * sceneData_.vertices_.size();
-	vertexBuffer_.CreateGPUOnlyBuffer(
-		ctx,
-		vertexBufferSize,
-		sceneData_.vertices_.data(),
-		bufferUsage);
+	CreateGPUOnlyArrayBuffer(ctx, vertexBuffer_, sceneData_.vertices_, bufferUsage);
 
 	// Indices
-	const VkDeviceSize indexBufferSize = sizeof(uint32_t) * sceneData_.indices_.size();
-	indexBuffer_.CreateGPUOnlyBuffer(
-		ctx,
-		indexBufferSize,
-		sceneData_.indices_.data(),
-		bufferUsage);
+	CreateGPUOnlyArrayBuffer(ctx, indexBuffer_, sceneData_.indices_, bufferUsage);
 	triangleCount_ = static_cast<uint32_t>(sceneData_.indices_.size()) / 3u; // TODO This somehow can be wrong
 
-	// Mesh Data
-	const VkDeviceSize meshDataBufferSize = sizeof(MeshData) * meshDataArray_.size();
-	meshDataBuffer_.CreateGPUOnlyBuffer(
-		ctx, 
-		meshDataBufferSize,
-		meshDataArray_.data(), 
-		bufferUsage);
+	// Materials, instances added later reuse the materials of their model
+	CreateGPUOnlyArrayBuffer(ctx, materialDataBuffer_, materialDataArray_, bufferUsage);
 
 	// Transform matrices
-	const VkDeviceSize modelSSBOBufferSize = sizeof(ModelUBO) * modelSSBOs_.size();
-	constexpr uint32_t frameCount = AppConfig::FrameCount;
-	for (uint32_t i = 0; i < frameCount; ++i)
-	{
-		modelSSBOBuffers_[i].CreateBuffer(ctx, modelSSBOBufferSize,
-			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-			VMA_MEMORY_USAGE_CPU_TO_GPU);
-		modelSSBOBuffers_[i].UploadBufferData(ctx, modelSSBOs_.data(), modelSSBOBufferSize);
-	}
+	CreateModelMatrixBuffers(ctx, static_cast<uint32_t>(modelSSBOs_.size()));
+	ClearDirtyModelMatrices();
+
+	// Mesh data, bounding boxes, and indirect commands
+	CreateDrawSlotBuffers(ctx);
+}
+
+// Buffers with one element per draw slot
+void Scene::CreateDrawSlotBuffers(VulkanContext& ctx)
+{
+	VkBufferUsageFlags bufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	if (ctx.SupportBufferDeviceAddress()) { bufferUsage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT; }
+
+	// Mesh Data
+	CreateGPUOnlyArrayBuffer(ctx, meshDataBuffer_, meshDataArray_, bufferUsage);
 
 	// Bounding boxes
 	const VkDeviceSize bbBufferSize = transformedBoundingBoxes_.size() * sizeof(BoundingBox);
 	transformedBoundingBoxBuffer_.CreateBuffer(ctx,
-		bbBufferSize,
+		std::max<VkDeviceSize>(bbBufferSize, sizeof(BoundingBox)),
 		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-		VMA_MEMORY_USAGE_CPU_TO_GPU);
+		VMA_MEMORY_USAGE_CPU_TO_GPU,
+		VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT); // See UploadModelMatrices()
 	transformedBoundingBoxBuffer_.UploadBufferData(ctx, transformedBoundingBoxes_.data(), bbBufferSize);
 
 	// Indirect buffers
 	CreateIndirectBuffer(ctx, indirectBuffer_);
+	if (instancedDraws_)
+	{
+		CreateInstancedDrawBuffers(ctx);
+	}
+}
+
+/*Groups the live draw slots by mesh, each group is one command with an instance per slot.
+The commands are ordered like the draw slots so the meshes of a model are still next to each other.
+Without culling the commands draw every instance, PipelineFrustumCulling resets instanceCount
+and writes the visible slots of each group from its firstInstance.
+Buffers that keep their length are rewritten in place, returns true if they were recreated*/
+bool Scene::CreateInstancedDrawBuffers(VulkanContext& ctx)
+{
+	ZoneScopedNC("CreateInstancedDrawBuffers", tracy::Color::Orange);
+
+	// Without the view distance the key is the same for every instance of a mesh
+	const uint32_t slotCount = GetInstanceCount();
+	std::vector<std::pair<uint64_t, uint32_t>> sortedSlots; // Key and slot
+	sortedSlots.reserve(slotCount);
+	for (uint32_t slot = 0; slot < slotCount; ++slot)
+	{
+		if (!instanceDataArray_[slot].removed_)
+		{
+			sortedSlots.emplace_back(GetDrawSortKey(instanceDataArray_[slot], 0.0f), slot);
+		}
+	}
+	std::ranges::sort(sortedSlots);
+
+	std::vector<VkDrawIndirectCommand> iCommands;
+	std::vector<uint32_t> instanceIndices(sortedSlots.size());
+	std::vector<uint32_t> drawGroupIndices(slotCount, DrawGroupNone);
+	for (uint32_t i = 0; i < sortedSlots.size(); ++i)
+	{
+		const auto [key, slot] = sortedSlots[i];
+		if (i == 0 || key != sortedSlots[i - 1].first)
+		{
+			const InstanceData& iData = instanceDataArray_[slot];
+			iCommands.push_back(
+			{
+				.vertexCount = models_[iData.modelIndex_].meshes_[iData.perModelMeshIndex_].GetIndexCount(),
+				.instanceCount = 0u,
+				.firstVertex = 0,
+				.firstInstance = i
+			});
+		}
+		++iCommands.back().instanceCount;
+		instanceIndices[i] = slot;
+		drawGroupIndices[slot] = static_cast<uint32_t>(iCommands.size() - 1);
+	}
+	drawGroupCount_ = static_cast<uint32_t>(iCommands.size());
+
+	std::vector<VkDrawIndirectCommand> resetCommands = iCommands;
+	for (VkDrawIndirectCommand& command : resetCommands)
+	{
+		command.instanceCount = 0u;
+	}
+
+	// A re-sort only permutes the slots so the groups keep their sizes
+	if (RewriteGPUOnlyArrayBuffer(ctx, instancedIndirectBuffer_, iCommands) &&
+		RewriteGPUOnlyArrayBuffer(ctx, instancedIndirectResetBuffer_, resetCommands) &&
+		RewriteGPUOnlyArrayBuffer(ctx, instanceIndexBuffer_, instanceIndices) &&
+		RewriteGPUOnlyArrayBuffer(ctx, drawGroupIndexBuffer_, drawGroupIndices))
+	{
+		return false;
+	}
+
+	VkBufferUsageFlags bufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	if (ctx.SupportBufferDeviceAddress()) { bufferUsage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT; }
+
+	DestroyInstancedDrawBuffers();
+	CreateGPUOnlyArrayBuffer(ctx, instancedIndirectBuffer_, iCommands,
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	CreateGPUOnlyArrayBuffer(ctx, instancedIndirectResetBuffer_, resetCommands,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	CreateGPUOnlyArrayBuffer(ctx, instanceIndexBuffer_, instanceIndices, bufferUsage);
+	CreateGPUOnlyArrayBuffer(ctx, drawGroupIndexBuffer_, drawGroupIndices,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	return true;
+}
+
+// The buffers can hold more matrices than modelSSBOs_ so instances can be added without reallocating
+void Scene::CreateModelMatrixBuffers(VulkanContext& ctx, uint32_t matrixCapacity)
+{
+	matrixCapacity_ = std::max(matrixCapacity, 1u);
+	const VkDeviceSize modelSSBOBufferSize = sizeof(ModelUBO) * modelSSBOs_.size();
+	constexpr uint32_t frameCount = AppConfig::FrameCount;
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		modelSSBOBuffers_[i].CreateBuffer(ctx, sizeof(ModelUBO) * matrixCapacity_,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_CPU_TO_GPU);
+		modelSSBOBuffers_[i].UploadBufferData(ctx, modelSSBOs_.data(), modelSSBOBufferSize);
+	}
 }
 
 void Scene::UpdateAnimation(VulkanContext& ctx, float deltaTime)
@@ -298,8 +791,17 @@ void Scene::CreateAnimationResources(VulkanContext& ctx)
 	}
 }
 
+// Called again by Update() when more models are loaded, existing model matrices are kept
 void Scene::CreateDataStructures()
 {
+	instanceDataArray_.clear();
+	instanceMapArray_.clear();
+	meshBoundingBoxes_.resize(models_.size());
+
+	// Texture indices change when the textures of a model finish loading so the table is rebuilt
+	materialDataArray_.clear();
+	meshMaterialIndices_.resize(models_.size());
+
 	uint32_t matrixCounter = 0u; // This will also be the length of modelSSBO_
 	uint32_t textureCounter = 0u;
 	uint32_t globalInstanceCounter = 0u;
@@ -307,9 +809,11 @@ void Scene::CreateDataStructures()
 	{
 		const uint32_t meshCount = models_[m].GetMeshCount();
 		const uint32_t instanceCount = models_[m].modelInfo_.instanceCount;
+		const uint32_t nodeCount = models_[m].GetNodeCount();
 
-		// Create temporary bounding box array
-		std::vector<BoundingBox> tempOriArray(meshCount);
+		// Bounding boxes are kept for instances that are added later
+		std::vector<BoundingBox>& tempOriArray = meshBoundingBoxes_[m];
+		tempOriArray.resize(meshCount);
 		for (uint32_t i = 0; i < meshCount; ++i) // Per mesh
 		{
 			const uint32_t vertexStart = models_[m].meshes_[i].GetVertexOffset();
@@ -317,6 +821,14 @@ void Scene::CreateDataStructures()
 			tempOriArray[i] = BoundingBox(Utility::SubSpan(std::span{ sceneData_.vertices_ }, vertexStart, vertexCount));
 		}
 
+		// One material per mesh, shared by its copies and by other meshes with the same textures
+		meshMaterialIndices_[m].resize(meshCount);
+		for (uint32_t i = 0; i < meshCount; ++i)
+		{
+			meshMaterialIndices_[m][i] = AddMaterial(
+				models_[m].meshes_[i].GetMaterialData(textureCounter, !models_[m].TexturesLoaded()));
+		}
+
 		// Create the actual InstanceData
 		for (uint32_t i = 0; i < instanceCount; ++i)
 		{
@@ -327,28 +839,32 @@ void Scene::CreateDataStructures()
 					.modelIndex_ = m,
 					.perModelInstanceIndex_ = i,
 					.perModelMeshIndex_ = j,
-					.meshData_ = models_[m].meshes_[j].GetMeshData(textureCounter, matrixCounter),
+					.meshData_ = models_[m].meshes_[j].GetMeshData(
+						matrixCounter + models_[m].meshes_[j].GetNodeIndex(),
+						meshMaterialIndices_[m][j]),
+					.material_ = models_[m].meshes_[j].GetMaterialType(),
 					.originalBoundingBox_ = tempOriArray[j] // Copy bounding box from temporary
 				}
 				);
 				++globalInstanceCounter;
 			}
-			++matrixCounter;
+			matrixCounter += nodeCount;
 		}
 		textureCounter += models_[m].GetTextureCount();
 	}
 
-	// Sort based on material
+	// Sort based on material, model, and mesh. The world bounding boxes are not known yet,
+	// SortDraws() adds the depth
 	std::ranges::sort(
 		std::begin(instanceDataArray_),
 		std::end(instanceDataArray_),
-		[](InstanceData a, InstanceData b)
+		[](const InstanceData& a, const InstanceData& b)
 		{
-			return a.meshData_.material_ < b.meshData_.material_;
+			return GetDrawSortKey(a, 0.0f) < GetDrawSortKey(b, 0.0f);
 		});
 
-	// Matrices
-	modelSSBOs_ = std::vector<ModelUBO>(matrixCounter, { .model = glm::mat4(1.0f) }); // Identity matrices
+	// Matrices, new ones are computed from the scene graph below
+	modelSSBOs_.resize(matrixCounter, { .model = glm::mat4(1.0f) });
 	
 	// Flat array for SSBO
 	meshDataArray_.resize(globalInstanceCounter);
@@ -357,32 +873,109 @@ void Scene::CreateDataStructures()
 		meshDataArray_[i] = instanceDataArray_[i].meshData_;
 	}
 
-	// Prepare bounding boxes for frustum culling
-	transformedBoundingBoxes_.resize(globalInstanceCounter);
+	// One full range per material, added instances reallocate it
+	drawSlotRanges_.fill({});
 	for (uint32_t i = 0; i < globalInstanceCounter; ++i)
 	{
-		// Equal the original bb because at this point modelSSBOs_ only has identity matrix
-		transformedBoundingBoxes_[i] = instanceDataArray_[i].originalBoundingBox_;
+		DrawSlotRange& range = drawSlotRanges_[static_cast<uint32_t>(instanceDataArray_[i].material_)];
+		if (range.used_ == 0)
+		{
+			range.first_ = i;
+		}
+		++range.used_;
+		++range.capacity_;
+	}
+	uint32_t rangeEnd = 0;
+	for (DrawSlotRange& range : drawSlotRanges_)
+	{
+		// Empty ranges still need a position between the others
+		if (range.used_ == 0)
+		{
+			range.first_ = rangeEnd;
+		}
+		rangeEnd = range.first_ + range.capacity_;
 	}
+	freeMatrixBlocks_.assign(models_.size(), {});
 
-	// Create a map
+	// Create a map, and the scene graph nodes of the new models.
+	// Models are only appended so the nodes of the previous models keep their transforms
 	matrixCounter = 0u;
 	instanceMapArray_.resize(models_.size());
-	for (size_t i = 0; i < models_.size(); ++i)
+	for (uint32_t i = 0; i < models_.size(); ++i)
 	{
+		const std::vector<ModelNode>& nodes = models_[i].nodes_;
 		const uint32_t instanceCount = models_[i].modelInfo_.instanceCount;
 		instanceMapArray_[i].resize(instanceCount);
 		for (uint32_t j = 0; j < instanceCount; ++j)
 		{
-			instanceMapArray_[i][j].modelMatrixIndex_ = matrixCounter++;
-		}
-	}
+			instanceMapArray_[i][j].modelMatrixIndex_ = matrixCounter;
+			if (matrixCounter >= sceneGraph_.GetNodeCount())
+			{
+				for (uint32_t k = 0; k < nodes.size(); ++k)
+				{
+					sceneGraph_.AddNode(
+						k == 0 ? SceneGraphNoParent : matrixCounter + nodes[k].parentIndex_,
+						nodes[k].localTransform_);
+				}
+			}
+			matrixCounter += static_cast<uint32_t>(nodes.size());
+		}
+	}
+	matrixInstanceIndices_.assign(matrixCounter, {});
 	for (uint32_t i = 0; i < globalInstanceCounter; ++i)
 	{
-		const uint32_t modelIndex = instanceDataArray_[i].modelIndex_;
-		const uint32_t perModelInstanceIndex = instanceDataArray_[i].perModelInstanceIndex_;
-		instanceMapArray_[modelIndex][perModelInstanceIndex].instanceDataIndices_.push_back(i);
+		matrixInstanceIndices_[instanceDataArray_[i].meshData_.modelMatrixIndex_].push_back(i);
 	}
+
+	// Matrices that were set before their model finished loading
+	for (auto it = pendingModelMatrices_.begin(); it != pendingModelMatrices_.end();)
+	{
+		const auto [modelIndex, perModelInstanceIndex] = it->first;
+		if (modelIndex < models_.size())
+		{
+			if (perModelInstanceIndex < instanceMapArray_[modelIndex].size())
+			{
+				sceneGraph_.SetLocalTransform(instanceMapArray_[modelIndex][perModelInstanceIndex].modelMatrixIndex_, it->second.model);
+			}
+			it = pendingModelMatrices_.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// New nodes and changed nodes, CreateBindlessResources() uploads every matrix after this
+	sceneGraph_.UpdateWorldTransforms([this](uint32_t nodeIndex, const glm::mat4& world)
+	{
+		modelSSBOs_[nodeIndex].model = world;
+	});
+
+	// Prepare bounding boxes for frustum culling, instances that share a matrix are transformed together
+	originalBoundingBoxes_.Resize(globalInstanceCounter);
+	for (uint32_t i = 0; i < globalInstanceCounter; ++i)
+	{
+		originalBoundingBoxes_.Set(i, instanceDataArray_[i].originalBoundingBox_);
+	}
+	transformedBoundingBoxes_.resize(globalInstanceCounter);
+	for (uint32_t i = 0; i < matrixCounter; ++i)
+	{
+		originalBoundingBoxes_.Transform(
+			matrixInstanceIndices_[i],
+			modelSSBOs_[i].model,
+			transformedBoundingBoxes_.data());
+	}
+
+	// Models are only appended so the mesh BVHs that are already built are kept
+	meshBVHs_.resize(models_.size());
+	for (size_t i = 0; i < models_.size(); ++i)
+	{
+		meshBVHs_[i].resize(models_[i].GetMeshCount());
+	}
+
+	// Instances are added when a model finishes loading so the tree is rebuilt, not refitted
+	instanceBVH_.Build(transformedBoundingBoxes_);
+	instanceBVHDirty_ = false;
 }
 
 void Scene::UpdateModelMatrix(VulkanContext& ctx,
@@ -390,14 +983,30 @@ void Scene::UpdateModelMatrix(VulkanContext& ctx,
 	const uint32_t modelIndex,
 	const uint32_t perModelInstanceIndex)
 {
+	if (modelIndex >= models_.size() && modelIndex < modelCount_)
+	{
+		// The model is still loading, see CreateDataStructures()
+		pendingModelMatrices_[{ modelIndex, perModelInstanceIndex }] = modelUBO;
+		return;
+	}
+
 	if (modelIndex < 0 || modelIndex >= models_.size())
 	{
 		std::cerr << "Cannot update ModelUBO because of invalid modelIndex " << modelIndex << "\n";
 		return;
 	}
 
-	const uint32_t instanceCount = models_[modelIndex].modelInfo_.instanceCount;
-	if (perModelInstanceIndex < 0 || perModelInstanceIndex >= instanceCount)
+	const uint32_t instanceCount = static_cast<uint32_t>(instanceMapArray_[modelIndex].size());
+	const InstanceState state = perModelInstanceIndex < instanceCount ?
+		instanceMapArray_[modelIndex][perModelInstanceIndex].state_ :
+		InstanceState::Removed;
+	if (state == InstanceState::Adding)
+	{
+		// Applied by ApplyInstanceChanges()
+		pendingModelMatrices_[{ modelIndex, perModelInstanceIndex }] = modelUBO;
+		return;
+	}
+	if (state == InstanceState::Removed)
 	{
 		std::cerr << "Cannot update ModelUBO because of invalid instanceIndex " << perModelInstanceIndex << "\n";
 		return;
@@ -405,11 +1014,10 @@ void Scene::UpdateModelMatrix(VulkanContext& ctx,
 
 	const uint32_t matrixIndex = instanceMapArray_[modelIndex][perModelInstanceIndex].modelMatrixIndex_;
 
-	// Update transformation matrix
+	// The root node has no parent so its local transform is the model matrix.
+	// modelSSBOs_ is updated right away for code that reads it on the CPU, the children follow in UploadModelMatrices()
 	modelSSBOs_[matrixIndex] = modelUBO;
-
-	// Update the buffer
-	UpdateModelMatrixBuffer(ctx, modelIndex, perModelInstanceIndex);
+	sceneGraph_.SetLocalTransform(matrixIndex, modelUBO.model);
 }
 
 void Scene::UpdateModelMatrixBuffer(
@@ -417,34 +1025,526 @@ void Scene::UpdateModelMatrixBuffer(
 	const uint32_t modelIndex,
 	const uint32_t perModelInstanceIndex)
 {
-	const uint32_t matrixIndex = instanceMapArray_[modelIndex][perModelInstanceIndex].modelMatrixIndex_;
-	const ModelUBO& modelUBO = modelSSBOs_[matrixIndex];
+	UpdateNodeWorldMatrix(instanceMapArray_[modelIndex][perModelInstanceIndex].modelMatrixIndex_);
+}
+
+void Scene::UpdateNodeWorldMatrix(uint32_t matrixIndex)
+{
+	sceneGraph_.SetWorldTransform(matrixIndex, modelSSBOs_[matrixIndex].model);
+}
 
-	// Update SSBO
+bool Scene::FindNode(
+	const uint32_t modelIndex,
+	const uint32_t perModelInstanceIndex,
+	const std::string& nodeName,
+	uint32_t& matrixIndex) const
+{
+	if (modelIndex >= models_.size() ||
+		perModelInstanceIndex >= instanceMapArray_[modelIndex].size() ||
+		instanceMapArray_[modelIndex][perModelInstanceIndex].state_ != InstanceState::Alive)
+	{
+		return false;
+	}
+
+	const std::vector<ModelNode>& nodes = models_[modelIndex].nodes_;
+	const auto it = std::ranges::find(nodes, nodeName, &ModelNode::name_);
+	if (it == nodes.end())
+	{
+		return false;
+	}
+	matrixIndex = instanceMapArray_[modelIndex][perModelInstanceIndex].modelMatrixIndex_ +
+		static_cast<uint32_t>(it - nodes.begin());
+	return true;
+}
+
+void Scene::SetNodeLocalTransform(uint32_t matrixIndex, const glm::mat4& localTransform)
+{
+	sceneGraph_.SetLocalTransform(matrixIndex, localTransform);
+}
+
+void Scene::MarkModelMatrixDirty(uint32_t matrixIndex)
+{
+	const uint64_t bit = 1ull << (matrixIndex % 64);
 	for (uint32_t i = 0; i < AppConfig::FrameCount; ++i)
 	{
-		modelSSBOBuffers_[i].UploadOffsetBufferData(
-			ctx,
-			&(modelSSBOs_[matrixIndex]),
-			sizeof(ModelUBO) * matrixIndex,
-			sizeof(ModelUBO));
+		dirtyMatrixBits_[i][matrixIndex / 64] |= bit;
+		matricesDirty_[i] = true;
+	}
+	dirtyBoundingBoxBits_[matrixIndex / 64] |= bit;
+	boundingBoxesDirty_ = true;
+}
+
+// CreateBindlessResources() uploads every matrix and bounding box
+void Scene::ClearDirtyModelMatrices()
+{
+	const size_t wordCount = (modelSSBOs_.size() + 63) / 64;
+	for (uint32_t i = 0; i < AppConfig::FrameCount; ++i)
+	{
+		dirtyMatrixBits_[i].assign(wordCount, 0ull);
+		matricesDirty_[i] = false;
 	}
+	dirtyBoundingBoxBits_.assign(wordCount, 0ull);
+	boundingBoxesDirty_ = false;
+}
 
-	// Update bounding box buffer
-	const std::vector<uint32_t>& mappedIndices = instanceMapArray_[modelIndex][perModelInstanceIndex].instanceDataIndices_;
-	if (!mappedIndices.empty())
+void Scene::ResizeDirtyModelMatrixBits()
+{
+	const size_t wordCount = (modelSSBOs_.size() + 63) / 64;
+	for (uint32_t i = 0; i < AppConfig::FrameCount; ++i)
 	{
-		for (uint32_t i : mappedIndices)
+		dirtyMatrixBits_[i].resize(wordCount, 0ull);
+	}
+	dirtyBoundingBoxBits_.resize(wordCount, 0ull);
+}
+
+bool Scene::SortDraws(const glm::vec3& viewPosition)
+{
+	if (!CanEditInstances())
+	{
+		return false;
+	}
+	drawSortViewPosition_ = viewPosition;
+	drawSortRequested_ = true;
+	return true;
+}
+
+bool Scene::CanEditInstances() const
+{
+	return !IsLoading() &&
+		models_.size() == modelCount_ &&
+		std::ranges::all_of(models_, &Model::TexturesLoaded);
+}
+
+int Scene::AddModelInstance(const uint32_t modelIndex, const glm::mat4& modelMatrix)
+{
+	if (!CanEditInstances())
+	{
+		std::cerr << "Cannot add an instance while the scene is loading\n";
+		return -1;
+	}
+	if (modelIndex >= models_.size())
+	{
+		std::cerr << "Cannot add an instance because of invalid modelIndex " << modelIndex << "\n";
+		return -1;
+	}
+
+	std::vector<InstanceMap>& instanceMaps = instanceMapArray_[modelIndex];
+	const auto it = std::ranges::find(instanceMaps, InstanceState::Removed, &InstanceMap::state_);
+	const uint32_t perModelInstanceIndex = static_cast<uint32_t>(it - instanceMaps.begin());
+	if (it == instanceMaps.end())
+	{
+		instanceMaps.emplace_back();
+	}
+	instanceMaps[perModelInstanceIndex].state_ = InstanceState::Adding;
+	pendingModelMatrices_[{ modelIndex, perModelInstanceIndex }] = { .model = modelMatrix };
+	addedInstances_.emplace_back(modelIndex, perModelInstanceIndex);
+	return static_cast<int>(perModelInstanceIndex);
+}
+
+void Scene::RemoveModelInstance(const uint32_t modelIndex, const uint32_t perModelInstanceIndex)
+{
+	if (modelIndex >= instanceMapArray_.size() || perModelInstanceIndex >= instanceMapArray_[modelIndex].size())
+	{
+		std::cerr << "Cannot remove instance " << perModelInstanceIndex << " of model " << modelIndex << "\n";
+		return;
+	}
+
+	InstanceMap& instanceMap = instanceMapArray_[modelIndex][perModelInstanceIndex];
+	const std::pair<uint32_t, uint32_t> key = { modelIndex, perModelInstanceIndex };
+	if (instanceMap.state_ == InstanceState::Adding)
+	{
+		// Never reached the GPU
+		std::erase(addedInstances_, key);
+		pendingModelMatrices_.erase(key);
+		instanceMap.state_ = InstanceState::Removed;
+	}
+	else if (instanceMap.state_ == InstanceState::Alive)
+	{
+		instanceMap.state_ = InstanceState::Removing;
+		removedInstances_.push_back(key);
+	}
+}
+
+// Called by Update() after the device is idle
+// Returns true if the buffers were recreated
+bool Scene::ApplyInstanceChanges(VulkanContext& ctx)
+{
+	ZoneScopedNC("ApplyInstanceChanges", tracy::Color::Orange);
+
+	const uint32_t slotCount = GetInstanceCount();
+	std::vector<uint32_t> changedSlots;
+	for (const auto [modelIndex, perModelInstanceIndex] : removedInstances_)
+	{
+		InstanceMap& instanceMap = instanceMapArray_[modelIndex][perModelInstanceIndex];
+		for (uint32_t k = 0; k < models_[modelIndex].GetNodeCount(); ++k)
 		{
-			transformedBoundingBoxes_[i] = instanceDataArray_[i].originalBoundingBox_.GetTransformed(modelUBO.model);
+			std::vector<uint32_t>& slots = matrixInstanceIndices_[instanceMap.modelMatrixIndex_ + k];
+			for (const uint32_t slot : slots)
+			{
+				FreeDrawSlot(slot);
+				changedSlots.push_back(slot);
+			}
+			slots.clear();
 		}
-		// Update bounding box buffers
-		const uint32_t firstIndex = mappedIndices[0];
-		transformedBoundingBoxBuffer_.UploadOffsetBufferData(
-			ctx,
-			transformedBoundingBoxes_.data() + firstIndex,
-			sizeof(BoundingBox) * firstIndex,
-			sizeof(BoundingBox) * mappedIndices.size());
+		freeMatrixBlocks_[modelIndex].push_back(instanceMap.modelMatrixIndex_);
+		instanceMap.state_ = InstanceState::Removed;
+	}
+	removedInstances_.clear();
+
+	// A range without enough free slots is reallocated, which also drops the holes of every range
+	std::array<uint32_t, MaterialTypeCount> requiredSlots{};
+	for (const auto [modelIndex, perModelInstanceIndex] : addedInstances_)
+	{
+		for (const Mesh& mesh : models_[modelIndex].meshes_)
+		{
+			++requiredSlots[static_cast<uint32_t>(mesh.GetMaterialType())];
+		}
+	}
+	bool relayout = false;
+	uint32_t holeCount = 0;
+	uint32_t usedCount = 0;
+	std::array<uint32_t, MaterialTypeCount> capacities{};
+	for (uint32_t i = 0; i < MaterialTypeCount; ++i)
+	{
+		const DrawSlotRange& range = drawSlotRanges_[i];
+		const uint32_t freeCount = static_cast<uint32_t>(range.freeSlots_.size()) + range.capacity_ - range.used_;
+		const uint32_t liveCount = range.used_ - static_cast<uint32_t>(range.freeSlots_.size());
+		capacities[i] = range.capacity_;
+		if (requiredSlots[i] > freeCount)
+		{
+			capacities[i] = std::max(2 * range.capacity_, std::bit_ceil(liveCount + requiredSlots[i]));
+			relayout = true;
+		}
+		holeCount += static_cast<uint32_t>(range.freeSlots_.size());
+		usedCount += range.used_;
+	}
+	if (relayout)
+	{
+		RelayoutDrawSlots(capacities, changedSlots);
+	}
+
+	const uint32_t matrixCount = static_cast<uint32_t>(modelSSBOs_.size());
+	for (const auto [modelIndex, perModelInstanceIndex] : addedInstances_)
+	{
+		const uint32_t matrixIndex = AllocateMatrixBlock(modelIndex);
+		InstanceMap& instanceMap = instanceMapArray_[modelIndex][perModelInstanceIndex];
+		instanceMap.modelMatrixIndex_ = matrixIndex;
+		instanceMap.state_ = InstanceState::Alive;
+
+		const auto it = pendingModelMatrices_.find({ modelIndex, perModelInstanceIndex });
+		if (it != pendingModelMatrices_.end())
+		{
+			modelSSBOs_[matrixIndex] = it->second;
+			sceneGraph_.SetLocalTransform(matrixIndex, it->second.model);
+			pendingModelMatrices_.erase(it);
+		}
+
+		Model& model = models_[modelIndex];
+		for (uint32_t j = 0; j < model.GetMeshCount(); ++j)
+		{
+			Mesh& mesh = model.meshes_[j];
+			const uint32_t slot = AllocateDrawSlot(mesh.GetMaterialType());
+			const uint32_t nodeMatrixIndex = matrixIndex + mesh.GetNodeIndex();
+			instanceDataArray_[slot] =
+			{
+				.modelIndex_ = modelIndex,
+				.perModelInstanceIndex_ = perModelInstanceIndex,
+				.perModelMeshIndex_ = j,
+				.meshData_ = mesh.GetMeshData(nodeMatrixIndex, meshMaterialIndices_[modelIndex][j]),
+				.material_ = mesh.GetMaterialType(),
+				.originalBoundingBox_ = meshBoundingBoxes_[modelIndex][j]
+			};
+			meshDataArray_[slot] = instanceDataArray_[slot].meshData_;
+			originalBoundingBoxes_.Set(slot, meshBoundingBoxes_[modelIndex][j]);
+
+			// A reused hole can be before the other slots of the matrix
+			std::vector<uint32_t>& slots = matrixInstanceIndices_[nodeMatrixIndex];
+			slots.insert(std::ranges::upper_bound(slots, slot), slot);
+			changedSlots.push_back(slot);
+		}
+	}
+	addedInstances_.clear();
+
+	// Holes are drawn as empty commands so too many of them are compacted, a relayout also sorts the draws
+	const bool compact = holeCount >= DrawSlotCompactionMinHoles && 2 * holeCount > usedCount;
+	if (!relayout && (compact || drawSortRequested_))
+	{
+		for (uint32_t i = 0; i < MaterialTypeCount; ++i)
+		{
+			const DrawSlotRange& range = drawSlotRanges_[i];
+			const uint32_t liveCount = range.used_ - static_cast<uint32_t>(range.freeSlots_.size());
+			capacities[i] = !compact ? range.capacity_ : (liveCount > 0 ? std::bit_ceil(liveCount) : 0);
+		}
+		RelayoutDrawSlots(capacities, changedSlots);
+	}
+	drawSortRequested_ = false;
+
+	// The world matrices and the bounding boxes of the new instances are computed by UploadModelMatrices()
+	bool buffersRecreated = false;
+	if (modelSSBOs_.size() > matrixCapacity_)
+	{
+		for (auto& buffer : modelSSBOBuffers_)
+		{
+			buffer.Destroy();
+		}
+		CreateModelMatrixBuffers(ctx, std::bit_ceil(static_cast<uint32_t>(modelSSBOs_.size())));
+		buffersRecreated = true;
+	}
+	if (modelSSBOs_.size() > matrixCount)
+	{
+		ResizeDirtyModelMatrixBits();
+	}
+
+	// Growth and compaction change the slot count, a re-sort only moves the draws inside the same slots
+	if (GetInstanceCount() != slotCount)
+	{
+		meshDataBuffer_.Destroy();
+		transformedBoundingBoxBuffer_.Destroy();
+		indirectBuffer_.Destroy();
+		CreateDrawSlotBuffers(ctx);
+		instanceBVH_.Build(transformedBoundingBoxes_);
+		instanceBVHDirty_ = false;
+		return true;
+	}
+
+	// Only the changed slots are written, the buffers are not in use. A reused slot is listed twice
+	// but the regions of a copy must not overlap
+	std::ranges::sort(changedSlots);
+	changedSlots.erase(std::ranges::unique(changedSlots).begin(), changedSlots.end());
+	UploadSlots<MeshData>(ctx, meshDataBuffer_, changedSlots,
+		[this](uint32_t slot) { return meshDataArray_[slot]; });
+	UploadSlots<VkDrawIndirectCommand>(ctx, indirectBuffer_, changedSlots,
+		[this](uint32_t slot) { return GetDrawCommand(slot); });
+	BoundingBox* mappedBoxes = static_cast<BoundingBox*>(transformedBoundingBoxBuffer_.vmaInfo_.pMappedData);
+	for (const uint32_t slot : changedSlots)
+	{
+		mappedBoxes[slot] = transformedBoundingBoxes_[slot];
+	}
+	vmaFlushAllocation(transformedBoundingBoxBuffer_.vmaAllocator_, transformedBoundingBoxBuffer_.vmaAllocation_, 0, VK_WHOLE_SIZE);
+
+	// The instance counts of the meshes or the slots in the groups changed, the groups are small so they are rebuilt
+	if (instancedDraws_ && CreateInstancedDrawBuffers(ctx))
+	{
+		buffersRecreated = true;
+	}
+
+	// The slot count did not change so the tree can be refitted
+	instanceBVHDirty_ = true;
+	return buffersRecreated;
+}
+
+// Moves the live draws of each material to the start of a range with the new capacity, holes are dropped.
+// The draws are sorted with GetDrawSortKey() from the last position passed to SortDraws().
+// Slots that now hold another draw are appended to changedSlots, a free slot is only listed if it held a draw
+void Scene::RelayoutDrawSlots(const std::array<uint32_t, MaterialTypeCount>& capacities, std::vector<uint32_t>& changedSlots)
+{
+	ZoneScopedNC("RelayoutDrawSlots", tracy::Color::Orange);
+
+	const uint32_t slotCount = std::accumulate(capacities.begin(), capacities.end(), 0u);
+	std::vector<InstanceData> instanceDataArray(slotCount);
+	std::vector<BoundingBox> transformedBoundingBoxes(slotCount);
+	std::vector<uint32_t> newSlots(instanceDataArray_.size(), 0u);
+	std::vector<std::pair<uint64_t, uint32_t>> sortedSlots; // Key and old slot
+	uint32_t first = 0;
+	for (uint32_t i = 0; i < MaterialTypeCount; ++i)
+	{
+		DrawSlotRange& range = drawSlotRanges_[i];
+		sortedSlots.clear();
+		for (uint32_t slot = range.first_; slot < range.first_ + range.used_; ++slot)
+		{
+			if (!instanceDataArray_[slot].removed_)
+			{
+				const float viewDistance = glm::distance(drawSortViewPosition_, transformedBoundingBoxes_[slot].GetCenter());
+				sortedSlots.emplace_back(GetDrawSortKey(instanceDataArray_[slot], viewDistance), slot);
+			}
+		}
+		std::ranges::sort(sortedSlots);
+
+		uint32_t next = first;
+		for (const auto [key, slot] : sortedSlots)
+		{
+			newSlots[slot] = next;
+			if (slot != next)
+			{
+				changedSlots.push_back(next);
+			}
+			instanceDataArray[next] = instanceDataArray_[slot];
+			transformedBoundingBoxes[next] = transformedBoundingBoxes_[slot];
+			++next;
+		}
+		for (uint32_t slot = next; slot < first + capacities[i]; ++slot)
+		{
+			instanceDataArray[slot] = CreateFreeDrawSlot(static_cast<MaterialType>(i));
+			if (slot >= instanceDataArray_.size() || !instanceDataArray_[slot].removed_)
+			{
+				changedSlots.push_back(slot);
+			}
+		}
+		range =
+		{
+			.first_ = first,
+			.used_ = next - first,
+			.capacity_ = capacities[i]
+		};
+		first += capacities[i];
+	}
+
+	instanceDataArray_ = std::move(instanceDataArray);
+	transformedBoundingBoxes_ = std::move(transformedBoundingBoxes);
+	meshDataArray_.resize(slotCount);
+	originalBoundingBoxes_.Resize(slotCount);
+	for (uint32_t i = 0; i < slotCount; ++i)
+	{
+		meshDataArray_[i] = instanceDataArray_[i].meshData_;
+		originalBoundingBoxes_.Set(i, instanceDataArray_[i].originalBoundingBox_);
+	}
+	for (std::vector<uint32_t>& slots : matrixInstanceIndices_)
+	{
+		for (uint32_t& slot : slots)
+		{
+			slot = newSlots[slot];
+		}
+		std::ranges::sort(slots);
+	}
+}
+
+// The range must have a free slot, see ApplyInstanceChanges()
+uint32_t Scene::AllocateDrawSlot(MaterialType material)
+{
+	DrawSlotRange& range = drawSlotRanges_[static_cast<uint32_t>(material)];
+	if (!range.freeSlots_.empty())
+	{
+		const uint32_t slot = range.freeSlots_.back();
+		range.freeSlots_.pop_back();
+		return slot;
+	}
+	return range.first_ + range.used_++;
+}
+
+// The slot keeps its material so the range stays contiguous
+void Scene::FreeDrawSlot(uint32_t slot)
+{
+	const MaterialType material = instanceDataArray_[slot].material_;
+	instanceDataArray_[slot] = CreateFreeDrawSlot(material);
+	meshDataArray_[slot] = instanceDataArray_[slot].meshData_;
+	originalBoundingBoxes_.Set(slot, {});
+	transformedBoundingBoxes_[slot] = {};
+	drawSlotRanges_[static_cast<uint32_t>(material)].freeSlots_.push_back(slot);
+}
+
+// Returns the first matrix of a block with one matrix per node, the nodes start with the transforms of the model
+uint32_t Scene::AllocateMatrixBlock(uint32_t modelIndex)
+{
+	const std::vector<ModelNode>& nodes = models_[modelIndex].nodes_;
+	std::vector<uint32_t>& freeBlocks = freeMatrixBlocks_[modelIndex];
+	if (!freeBlocks.empty())
+	{
+		const uint32_t matrixIndex = freeBlocks.back();
+		freeBlocks.pop_back();
+		for (uint32_t k = 0; k < nodes.size(); ++k)
+		{
+			sceneGraph_.SetLocalTransform(matrixIndex + k, nodes[k].localTransform_);
+		}
+		return matrixIndex;
+	}
+
+	const uint32_t matrixIndex = sceneGraph_.GetNodeCount();
+	for (uint32_t k = 0; k < nodes.size(); ++k)
+	{
+		sceneGraph_.AddNode(
+			k == 0 ? SceneGraphNoParent : matrixIndex + nodes[k].parentIndex_,
+			nodes[k].localTransform_);
+	}
+	modelSSBOs_.resize(modelSSBOs_.size() + nodes.size(), { .model = glm::mat4(1.0f) });
+	matrixInstanceIndices_.resize(modelSSBOs_.size());
+	return matrixIndex;
+}
+
+// Returns the index of an equal material if there is one, the table only has a few entries per model
+uint32_t Scene::AddMaterial(const MaterialData& materialData)
+{
+	const auto it = std::ranges::find(materialDataArray_, materialData);
+	if (it != materialDataArray_.end())
+	{
+		return static_cast<uint32_t>(std::distance(materialDataArray_.begin(), it));
+	}
+	materialDataArray_.push_back(materialData);
+	return static_cast<uint32_t>(materialDataArray_.size() - 1);
+}
+
+VkDrawIndirectCommand Scene::GetDrawCommand(uint32_t slot) const
+{
+	const InstanceData& iData = instanceDataArray_[slot];
+	return
+	{
+		.vertexCount = iData.removed_ ? 0u : models_[iData.modelIndex_].meshes_[iData.perModelMeshIndex_].GetIndexCount(),
+		.instanceCount = 1u,
+		.firstVertex = 0,
+		.firstInstance = slot
+	};
+}
+
+void Scene::UploadModelMatrices(VulkanContext& ctx)
+{
+	ZoneScopedNC("UploadModelMatrices", tracy::Color::Orange);
+
+	sceneGraph_.UpdateWorldTransforms([this](uint32_t nodeIndex, const glm::mat4& world)
+	{
+		modelSSBOs_[nodeIndex].model = world;
+		MarkModelMatrixDirty(nodeIndex);
+	});
+
+	// The bounding box buffer is shared by all frames so the boxes are only transformed once.
+	// They are written to the mapped buffer directly, the indices of a model instance are sorted
+	// but not contiguous because instances are sorted by material
+	if (boundingBoxesDirty_)
+	{
+		BoundingBox* mappedBoxes = static_cast<BoundingBox*>(transformedBoundingBoxBuffer_.vmaInfo_.pMappedData);
+		uint32_t firstBox = std::numeric_limits<uint32_t>::max();
+		uint32_t lastBox = 0;
+		ConsumeBitRanges(dirtyBoundingBoxBits_, [&](uint32_t first, uint32_t count)
+		{
+			for (uint32_t matrixIndex = first; matrixIndex < first + count; ++matrixIndex)
+			{
+				const std::vector<uint32_t>& mappedIndices = matrixInstanceIndices_[matrixIndex];
+				if (mappedIndices.empty())
+				{
+					continue;
+				}
+				originalBoundingBoxes_.Transform(
+					mappedIndices,
+					modelSSBOs_[matrixIndex].model,
+					transformedBoundingBoxes_.data(),
+					mappedBoxes);
+				firstBox = std::min(firstBox, mappedIndices.front());
+				lastBox = std::max(lastBox, mappedIndices.back());
+			}
+		});
+		if (firstBox <= lastBox)
+		{
+			vmaFlushAllocation(
+				transformedBoundingBoxBuffer_.vmaAllocator_,
+				transformedBoundingBoxBuffer_.vmaAllocation_,
+				sizeof(BoundingBox) * firstBox,
+				sizeof(BoundingBox) * (lastBox - firstBox + 1));
+		}
+		instanceBVHDirty_ = true;
+		boundingBoxesDirty_ = false;
+	}
+
+	const uint32_t frameIndex = ctx.GetFrameIndex();
+	if (matricesDirty_[frameIndex])
+	{
+		VulkanBuffer& buffer = modelSSBOBuffers_[frameIndex];
+		ConsumeBitRanges(dirtyMatrixBits_[frameIndex], [&](uint32_t first, uint32_t count)
+		{
+			buffer.UploadOffsetBufferData(
+				ctx,
+				&(modelSSBOs_[first]),
+				sizeof(ModelUBO) * first,
+				sizeof(ModelUBO) * count);
+		});
+		matricesDirty_[frameIndex] = false;
 	}
 }
 
@@ -453,72 +1553,160 @@ void Scene::CreateIndirectBuffer(
 	VulkanBuffer& indirectBuffer)
 {
 	const uint32_t instanceCount = static_cast<uint32_t>(meshDataArray_.size());
-	const uint32_t indirectDataSize = instanceCount * sizeof(VkDrawIndirectCommand);
 
-	std::vector<VkDrawIndirectCommand> iCommands(instanceCount);
+	// At least one command because the buffer cannot be empty, the draw count is still zero
+	std::vector<VkDrawIndirectCommand> iCommands(std::max(instanceCount, 1u));
+	const uint32_t indirectDataSize = static_cast<uint32_t>(iCommands.size() * sizeof(VkDrawIndirectCommand));
 	for (uint32_t i = 0; i < instanceCount; ++i)
 	{
-		const uint32_t modelIndex = instanceDataArray_[i].modelIndex_;
-		const uint32_t perModelMeshIndex = instanceDataArray_[i].perModelMeshIndex_;
-
-		iCommands[i] =
-		{
-			.vertexCount = models_[modelIndex].meshes_[perModelMeshIndex].GetIndexCount(),
-			.instanceCount = 1u,
-			.firstVertex = 0,
-			.firstInstance = i
-		};
+		iCommands[i] = GetDrawCommand(i);
 	}
 
 	// This type of buffer is not accessible from CPU
 	indirectBuffer.CreateGPUOnlyIndirectBuffer(ctx, iCommands.data(), indirectDataSize);
 }
 
-// This is for descriptor indexing
+// This is for descriptor indexing, the default textures come first
 std::vector<VkDescriptorImageInfo> Scene::GetImageInfos() const
 {
-	std::vector<VkDescriptorImageInfo> textureInfoArray;
+	std::vector<VkDescriptorImageInfo> textureInfoArray = defaultTextures_.GetImageInfos();
+	const VkDescriptorImageInfo blackInfo = textureInfoArray[static_cast<uint32_t>(DefaultTexture::Black)];
 	for (auto& model : models_)
 	{
+		if (!model.TexturesLoaded())
+		{
+			// Keep the indices of the next models, these are not sampled
+			textureInfoArray.insert(textureInfoArray.end(), model.GetTextureCount(), blackInfo);
+			continue;
+		}
 		for (auto& texture : model.textureList_)
 		{
-			textureInfoArray.emplace_back(texture.GetDescriptorImageInfo());
+			const uint32_t textureIndex = static_cast<uint32_t>(textureInfoArray.size());
+			textureInfoArray.emplace_back(textureStreamer_.IsStreamed(textureIndex) ?
+				textureStreamer_.GetDescriptorImageInfo(textureIndex) :
+				texture.GetDescriptorImageInfo());
 		}
 	}
+
+	// A scene that is loaded asynchronously always has the same descriptor count
+	if (textureCapacity_ > 0 && textureInfoArray.size() < DefaultTextureCount + textureCapacity_)
+	{
+		textureInfoArray.resize(DefaultTextureCount + textureCapacity_, blackInfo);
+	}
 	return textureInfoArray;
 }
 
-// This is currently a brute force but can be improved with BVH or pixel perfect technique
 int Scene::GetClickedInstanceIndex(const Ray& ray)
 {
-	float tMin = std::numeric_limits<float>::max();
-	//int modelIndex = -1; // Debug
-	int instanceIndex = -1;
+	ScenePickResult result;
+	return PickTriangle(ray, result) ? result.instanceIndex_ : -1;
+}
+
+bool Scene::IsInstanceClickable(uint32_t instanceIndex) const
+{
+	const InstanceData& iData = instanceDataArray_[instanceIndex];
+	return !iData.removed_ && models_[iData.modelIndex_].modelInfo_.clickable;
+}
+
+bool Scene::PickTriangle(const Ray& ray, ScenePickResult& result)
+{
+	// Refitting is cheaper than rebuilding while a gizmo moves an instance every frame
+	if (instanceBVHDirty_)
+	{
+		instanceBVH_.Refit(transformedBoundingBoxes_);
+		instanceBVHDirty_ = false;
+	}
+
+	auto getPosition = [this](const MeshData& meshData, uint32_t index)
+	{
+		return sceneData_.vertices_[sceneData_.indices_[meshData.indexOffset_ + index] + meshData.vertexOffset_].position;
+	};
 
-	for (size_t i = 0; i < transformedBoundingBoxes_.size(); ++i)
+	float closestT = std::numeric_limits<float>::max();
+	uint32_t instanceIndex = 0;
+	uint32_t triangleIndex = 0;
+	glm::vec2 barycentric{};
+	const bool hit = instanceBVH_.Traverse(ray, closestT, instanceIndex, [&](uint32_t i, float& t)
 	{
-		InstanceData& iData = instanceDataArray_[i];
-		Model& m = models_[iData.modelIndex_];
-		if (!m.modelInfo_.clickable) { continue; }
+		if (!IsInstanceClickable(i))
+		{
+			return false;
+		}
+		const InstanceData& iData = instanceDataArray_[i];
+
+		// The direction is not normalized so t in object space is the same as in world space
+		const glm::mat4 inverseModel = glm::inverse(modelSSBOs_[iData.meshData_.modelMatrixIndex_].model);
+		const Ray objectRay(
+			glm::vec3(inverseModel * glm::vec4(ray.origin_, 1.0f)),
+			glm::vec3(inverseModel * glm::vec4(ray.direction_, 0.0f)));
 
-		float t;
-		if (transformedBoundingBoxes_[i].Hit(ray, t))
+		// Only triangles closer than the closest hit of the other instances are accepted
+		float meshT = closestT;
+		uint32_t meshTriangle = 0;
+		glm::vec2 meshBarycentric{};
+		const bool meshHit = GetMeshBVH(iData.modelIndex_, iData.perModelMeshIndex_).Traverse(
+			objectRay, meshT, meshTriangle, [&](uint32_t triangle, float& triangleT)
 		{
-			if (t < tMin)
+			glm::vec2 uv;
+			if (!IntersectTriangle(
+				objectRay,
+				getPosition(iData.meshData_, 3 * triangle),
+				getPosition(iData.meshData_, 3 * triangle + 1),
+				getPosition(iData.meshData_, 3 * triangle + 2),
+				triangleT,
+				uv) || triangleT >= meshT)
 			{
-				tMin = t;
-				//modelIndex = iData.modelIndex;
-				instanceIndex = static_cast<int>(i);
+				return false;
 			}
+			meshBarycentric = uv;
+			return true;
+		});
+		if (!meshHit)
+		{
+			return false;
 		}
+
+		t = meshT;
+		triangleIndex = meshTriangle;
+		barycentric = meshBarycentric;
+		return true;
+	});
+
+	if (!hit)
+	{
+		return false;
 	}
+	result =
+	{
+		.instanceIndex_ = static_cast<int>(instanceIndex),
+		.triangleIndex_ = triangleIndex,
+		.barycentric_ = barycentric,
+		.distance_ = closestT
+	};
+	return true;
+}
 
-	// Debug 
-	/*if (modelIndex >= 0)
+const BVH& Scene::GetMeshBVH(uint32_t modelIndex, uint32_t perModelMeshIndex)
+{
+	BVH& bvh = meshBVHs_[modelIndex][perModelMeshIndex];
+	if (!bvh.IsEmpty())
 	{
-		Model& m = models_[modelIndex];
-		std::cout << m.filepath_ << '\n';
-	}*/
+		return bvh;
+	}
 
-	return instanceIndex;
+	ZoneScopedNC("Build mesh BVH", tracy::Color::Orange);
+	const Mesh& mesh = models_[modelIndex].meshes_[perModelMeshIndex];
+	const uint32_t* indices = sceneData_.indices_.data() + mesh.GetIndexOffset();
+	const VertexData* vertices = sceneData_.vertices_.data() + mesh.GetVertexOffset();
+	std::vector<BoundingBox> triangleBoxes(mesh.GetIndexCount() / 3);
+	for (size_t i = 0; i < triangleBoxes.size(); ++i)
+	{
+		const glm::vec3& p0 = vertices[indices[3 * i]].position;
+		const glm::vec3& p1 = vertices[indices[3 * i + 1]].position;
+		const glm::vec3& p2 = vertices[indices[3 * i + 2]].position;
+		triangleBoxes[i].min_ = glm::vec4(glm::min(glm::min(p0, p1), p2), 1.0f);
+		triangleBoxes[i].max_ = glm::vec4(glm::max(glm::max(p0, p1), p2), 1.0f);
+	}
+	bvh.Build(triangleBoxes);
+	return bvh;
 }
\ No newline at end of file
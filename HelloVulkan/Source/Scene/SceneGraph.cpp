@@ -0,0 +1,51 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+uint32_t SceneGraph::AddNode(uint32_t parentIndex, const glm::mat4& localTransform)
+{
+	const uint32_t nodeIndex = GetNodeCount();
+	if (parentIndex != SceneGraphNoParent && parentIndex >= nodeIndex)
+	{
+		throw std::runtime_error("Scene graph node " + std::to_string(nodeIndex) +
+			" is added before its parent " + std::to_string(parentIndex));
+	}
+
+	localTransforms_.push_back(localTransform);
+	worldTransforms_.emplace_back(1.0f);
+	parents_.push_back(parentIndex);
+	dirty_.push_back(0);
+	MarkDirty(nodeIndex);
+	return nodeIndex;
+}
+
+void SceneGraph::Clear()
+{
+	localTransforms_.clear();
+	worldTransforms_.clear();
+	parents_.clear();
+	dirty_.clear();
+	firstDirty_ = std::numeric_limits<uint32_t>::max();
+}
+
+void SceneGraph::SetLocalTransform(uint32_t nodeIndex, const glm::mat4& localTransform)
+{
+	localTransforms_[nodeIndex] = localTransform;
+	MarkDirty(nodeIndex);
+}
+
+void SceneGraph::SetWorldTransform(uint32_t nodeIndex, const glm::mat4& worldTransform)
+{
+	const uint32_t parent = parents_[nodeIndex];
+	SetLocalTransform(nodeIndex, parent == SceneGraphNoParent ?
+		worldTransform :
+		glm::inverse(worldTransforms_[parent]) * worldTransform);
+}
+
+void SceneGraph::MarkDirty(uint32_t nodeIndex)
+{
+	dirty_[nodeIndex] = 1;
+	firstDirty_ = std::min(firstDirty_, nodeIndex);
+}
@@ -0,0 +1,282 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+// Same encoding as Bindless/TextureFeedback.glsl
+constexpr uint32_t FeedbackNotUsed = 0xffffffffu;
+constexpr float FeedbackLodOffset = 32.0f;
+constexpr float FeedbackLodScale = 256.0f;
+
+constexpr VkFormat StreamedTextureFormat = VK_FORMAT_R8G8B8A8_UNORM;
+constexpr uint32_t StreamedTextureBytesPerPixel = 4;
+
+void TextureStreamer::Create(VulkanContext& ctx, uint32_t textureCount)
+{
+	textureCount_ = textureCount;
+	for (uint32_t i = 0; i < AppConfig::FrameCount; ++i)
+	{
+		feedbackBuffers_[i].CreateBuffer(
+			ctx,
+			sizeof(uint32_t) * std::max(textureCount, 1u),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_AUTO,
+			VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+		ClearFeedback(i);
+	}
+}
+
+void TextureStreamer::Destroy()
+{
+	for (auto& [index, texture] : textures_)
+	{
+		texture.image_.Destroy();
+	}
+	for (RetiredImage& retired : retiredImages_)
+	{
+		retired.image_.Destroy();
+	}
+	for (VulkanBuffer& buffer : feedbackBuffers_)
+	{
+		buffer.Destroy();
+	}
+	textures_.clear();
+	retiredImages_.clear();
+	residentSize_ = 0;
+}
+
+void TextureStreamer::AddTexture(VulkanContext& ctx, uint32_t textureIndex, VulkanImage& image)
+{
+	if (textureIndex >= textureCount_ || image.imageFormat_ != StreamedTextureFormat)
+	{
+		std::cerr << "Texture " << textureIndex << " cannot be streamed\n";
+		return;
+	}
+
+	StreamedTexture& texture = textures_[textureIndex];
+	texture.width_ = image.width_;
+	texture.height_ = image.height_;
+	texture.mipCount_ = image.mipCount_;
+	texture.mipData_ = image.DownloadImageData(ctx);
+	image.Destroy();
+
+	size_t offset = 0;
+	texture.mipOffsets_.resize(texture.mipCount_);
+	for (uint32_t i = 0; i < texture.mipCount_; ++i)
+	{
+		texture.mipOffsets_[i] = offset;
+		offset += static_cast<size_t>(std::max(texture.width_ >> i, 1u)) *
+			std::max(texture.height_ >> i, 1u) *
+			StreamedTextureBytesPerPixel;
+	}
+
+	// Start with the mip levels that are not larger than TextureStreamingInitialSize
+	texture.initialMip_ = 0;
+	while (texture.initialMip_ + 1 < texture.mipCount_ &&
+		(std::max(texture.width_, texture.height_) >> texture.initialMip_) > AppConfig::TextureStreamingInitialSize)
+	{
+		++texture.initialMip_;
+	}
+	texture.requestedMip_ = texture.initialMip_;
+	texture.residentMip_ = texture.mipCount_; // Nothing is resident yet
+	texture.lastUsedFrame_ = frameCounter_;
+	SetResidentMip(ctx, textureIndex, texture, texture.initialMip_);
+}
+
+void TextureStreamer::Update(VulkanContext& ctx)
+{
+	++frameCounter_;
+
+	// Every frame in flight has stopped using these images
+	std::erase_if(retiredImages_, [this](RetiredImage& retired)
+	{
+		if (retired.frame_ + AppConfig::FrameCount > frameCounter_)
+		{
+			return false;
+		}
+		retired.image_.Destroy();
+		return true;
+	});
+
+	// The feedback was written by the last frame that used this frame index
+	const uint32_t frameIndex = ctx.GetFrameIndex();
+	ReadFeedback(frameIndex);
+	ClearFeedback(frameIndex);
+
+	StreamIn(ctx);
+}
+
+VkDescriptorImageInfo TextureStreamer::GetDescriptorImageInfo(uint32_t textureIndex) const
+{
+	return textures_.at(textureIndex).image_.GetDescriptorImageInfo();
+}
+
+std::vector<uint32_t> TextureStreamer::TakeChangedTextures(uint32_t frameIndex)
+{
+	return std::exchange(changedTextures_[frameIndex], {});
+}
+
+void TextureStreamer::ReadFeedback(uint32_t frameIndex)
+{
+	VulkanBuffer& buffer = feedbackBuffers_[frameIndex];
+	vmaInvalidateAllocation(buffer.vmaAllocator_, buffer.vmaAllocation_, 0, VK_WHOLE_SIZE);
+	const uint32_t* feedback = static_cast<const uint32_t*>(buffer.vmaInfo_.pMappedData);
+
+	for (auto& [index, texture] : textures_)
+	{
+		if (feedback[index] == FeedbackNotUsed)
+		{
+			continue;
+		}
+
+		// The shader does not know the texture size so it writes the mip level of a 1x1 texture
+		const float uvLod = static_cast<float>(feedback[index]) / FeedbackLodScale - FeedbackLodOffset;
+		const float mip = uvLod + std::log2(static_cast<float>(std::max(texture.width_, texture.height_)));
+		texture.requestedMip_ = static_cast<uint32_t>(
+			std::clamp(std::floor(mip), 0.0f, static_cast<float>(texture.mipCount_ - 1)));
+		texture.lastUsedFrame_ = frameCounter_;
+	}
+}
+
+void TextureStreamer::ClearFeedback(uint32_t frameIndex)
+{
+	VulkanBuffer& buffer = feedbackBuffers_[frameIndex];
+	memset(buffer.vmaInfo_.pMappedData, 0xff, static_cast<size_t>(buffer.size_));
+	vmaFlushAllocation(buffer.vmaAllocator_, buffer.vmaAllocation_, 0, VK_WHOLE_SIZE);
+}
+
+void TextureStreamer::StreamIn(VulkanContext& ctx)
+{
+	std::vector<uint32_t> requests;
+	for (const auto& [index, texture] : textures_)
+	{
+		if (texture.requestedMip_ < texture.residentMip_)
+		{
+			requests.push_back(index);
+		}
+	}
+
+	// Textures that are furthest from their requested mip level first
+	std::ranges::sort(requests, [this](uint32_t a, uint32_t b)
+	{
+		const StreamedTexture& texA = textures_.at(a);
+		const StreamedTexture& texB = textures_.at(b);
+		return texA.residentMip_ - texA.requestedMip_ > texB.residentMip_ - texB.requestedMip_;
+	});
+
+	// Each upload waits for the queue so only a few are done per frame
+	const size_t uploadCount = std::min<size_t>(requests.size(), AppConfig::TextureStreamingUploadsPerFrame);
+	for (size_t i = 0; i < uploadCount; ++i)
+	{
+		const uint32_t index = requests[i];
+		StreamedTexture& texture = textures_.at(index);
+
+		uint32_t mip = texture.requestedMip_;
+		const VkDeviceSize currentSize = GetMipChainSize(texture, texture.residentMip_);
+		const VkDeviceSize requiredSize = GetMipChainSize(texture, mip) - currentSize;
+		if (residentSize_ + requiredSize > AppConfig::TextureStreamingBudget &&
+			!EvictLeastRecentlyUsed(ctx, residentSize_ + requiredSize - AppConfig::TextureStreamingBudget, index))
+		{
+			// Not enough memory can be freed, stream in as many mip levels as the budget allows
+			while (mip < texture.residentMip_ &&
+				residentSize_ + GetMipChainSize(texture, mip) - currentSize > AppConfig::TextureStreamingBudget)
+			{
+				++mip;
+			}
+		}
+
+		if (mip < texture.residentMip_)
+		{
+			SetResidentMip(ctx, index, texture, mip);
+		}
+	}
+}
+
+bool TextureStreamer::EvictLeastRecentlyUsed(VulkanContext& ctx, VkDeviceSize requiredSize, uint32_t excludedIndex)
+{
+	// Textures not visible in the last feedback go back to their initial mip level,
+	// visible ones only drop the mip levels finer than requested
+	auto getEvictedMip = [this](const StreamedTexture& texture)
+	{
+		const uint32_t mip = texture.lastUsedFrame_ == frameCounter_ ? texture.requestedMip_ : texture.initialMip_;
+		return std::min(mip, texture.initialMip_);
+	};
+
+	std::vector<uint32_t> candidates;
+	for (const auto& [index, texture] : textures_)
+	{
+		if (index != excludedIndex && getEvictedMip(texture) > texture.residentMip_)
+		{
+			candidates.push_back(index);
+		}
+	}
+	std::ranges::sort(candidates, [this](uint32_t a, uint32_t b)
+	{
+		return textures_.at(a).lastUsedFrame_ < textures_.at(b).lastUsedFrame_;
+	});
+
+	VkDeviceSize freedSize = 0;
+	for (uint32_t index : candidates)
+	{
+		if (freedSize >= requiredSize)
+		{
+			break;
+		}
+		StreamedTexture& texture = textures_.at(index);
+		const uint32_t mip = getEvictedMip(texture);
+		freedSize += GetMipChainSize(texture, texture.residentMip_) - GetMipChainSize(texture, mip);
+		SetResidentMip(ctx, index, texture, mip);
+	}
+	return freedSize >= requiredSize;
+}
+
+void TextureStreamer::SetResidentMip(VulkanContext& ctx, uint32_t textureIndex, StreamedTexture& texture, uint32_t mip)
+{
+	VulkanImage image;
+	image.CreateImageFromMipData(
+		ctx,
+		texture.mipData_.data() + texture.mipOffsets_[mip],
+		std::max(texture.width_ >> mip, 1u),
+		std::max(texture.height_ >> mip, 1u),
+		texture.mipCount_ - mip,
+		1u, // layerCount
+		StreamedTextureFormat);
+	image.CreateImageView(
+		ctx,
+		StreamedTextureFormat,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_IMAGE_VIEW_TYPE_2D,
+		0u,
+		image.mipCount_,
+		0u,
+		1u);
+	image.CreateDefaultSampler(ctx,
+		0.f, // minLod
+		VK_LOD_CLAMP_NONE); // maxLod
+
+	// The previous image is destroyed in Update()
+	if (texture.image_.image_)
+	{
+		retiredImages_.push_back({ .frame_ = frameCounter_, .image_ = texture.image_ });
+	}
+
+	residentSize_ = residentSize_ - GetMipChainSize(texture, texture.residentMip_) + GetMipChainSize(texture, mip);
+	texture.image_ = image;
+	texture.residentMip_ = mip;
+	for (std::vector<uint32_t>& changedTextures : changedTextures_)
+	{
+		changedTextures.push_back(textureIndex);
+	}
+}
+
+VkDeviceSize TextureStreamer::GetMipChainSize(const StreamedTexture& texture, uint32_t mip)
+{
+	if (mip >= texture.mipCount_)
+	{
+		return 0;
+	}
+	return static_cast<VkDeviceSize>(texture.mipData_.size() - texture.mipOffsets_[mip]);
+}
@@ -132,7 +132,8 @@ void VulkanBuffer::CreateGPUOnlyBuffer
 
 void VulkanBuffer::CopyFrom(VulkanContext& ctx, VkBuffer srcBuffer, VkDeviceSize size)
 {
-	VkCommandBuffer commandBuffer = ctx.BeginOneTimeGraphicsCommand();
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
 
 	const VkBufferCopy copyRegion = {
 		.srcOffset = 0,
@@ -142,7 +143,7 @@ void VulkanBuffer::CopyFrom(VulkanContext& ctx, VkBuffer srcBuffer, VkDeviceSize
 
 	vkCmdCopyBuffer(commandBuffer, srcBuffer, buffer_, 1, &copyRegion);
 
-	ctx.EndOneTimeGraphicsCommand(commandBuffer);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
 }
 
 void VulkanBuffer::UploadOffsetBufferData(
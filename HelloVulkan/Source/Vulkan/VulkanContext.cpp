@@ -1,12 +1,24 @@
 #include "VulkanContext.h"
+#include "VulkanMipmapGenerator.h"
 #include "VulkanCheck.h"
 #include "Configs.h"
+#include "Utility.h"
 
 #define VMA_IMPLEMENTATION
 #define VMA_STATIC_VULKAN_FUNCTIONS 0
 #include "vk_mem_alloc.h"
 
 #include <iostream>
+#include <fstream>
+#include <cstring>
+
+VulkanContext::~VulkanContext() = default;
+
+size_t SamplerKeyHash::operator()(const SamplerKey& key) const
+{
+	// Every member is four bytes so there is no padding
+	return static_cast<size_t>(Utility::Hash(&key, sizeof(SamplerKey)));
+}
 
 void VulkanContext::Create(VulkanInstance& instance, ContextConfig config)
 {
@@ -32,19 +44,34 @@ void VulkanContext::Create(VulkanInstance& instance, ContextConfig config)
 	VK_CHECK(CreateSwapchain(instance.GetSurface()));
 	CreateSwapchainImages();
 
-	// Command pools
-	VK_CHECK(CreateCommandPool(graphicsFamily_, &graphicsCommandPool_));
-	VK_CHECK(CreateCommandPool(computeFamily_, &computeCommandPool_));
+	// Command pools, the one-time commands have their own because they are also recorded on worker threads
+	VK_CHECK(CreateCommandPool(graphicsFamily_, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, &graphicsCommandPool_));
+	VK_CHECK(CreateCommandPool(computeFamily_, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, &computeCommandPool_));
+	VK_CHECK(CreateCommandPool(graphicsFamily_, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &oneTimeGraphicsCommandPool_));
+	VK_CHECK(CreateCommandPool(computeFamily_, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, &oneTimeComputeCommandPool_));
 
 	// Frame in flight
 	AllocateFrameInFlightData();
 
 	// VMA
 	AllocateVMA(instance);
+
+	// Seeded from disk so pipelines compiled in a previous run are reused
+	CreatePipelineCache();
 }
 
 void VulkanContext::Destroy()
 {
+	if (mipmapGenerator_)
+	{
+		mipmapGenerator_->Destroy();
+		mipmapGenerator_.reset();
+	}
+	for (auto& [key, sampler] : samplerCache_)
+	{
+		vkDestroySampler(device_, sampler, nullptr);
+	}
+	samplerCache_.clear();
 	for (uint32_t i = 0; i < AppConfig::FrameCount; ++i)
 	{
 		frameDataArray_[i].Destroy(device_);
@@ -56,6 +83,10 @@ void VulkanContext::Destroy()
 	vkDestroySwapchainKHR(device_, swapchain_, nullptr);
 	vkDestroyCommandPool(device_, graphicsCommandPool_, nullptr);
 	vkDestroyCommandPool(device_, computeCommandPool_, nullptr);
+	vkDestroyCommandPool(device_, oneTimeGraphicsCommandPool_, nullptr);
+	vkDestroyCommandPool(device_, oneTimeComputeCommandPool_, nullptr);
+	SavePipelineCache();
+	vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
 	vmaDestroyAllocator(vmaAllocator_);
 	vkDestroyDevice(device_, nullptr);
 }
@@ -103,6 +134,77 @@ void VulkanContext::AllocateVMA(VulkanInstance& instance)
 	vmaCreateAllocator(&allocatorInfo, &vmaAllocator_);
 }
 
+void VulkanContext::CreatePipelineCache()
+{
+	std::vector<char> cacheData;
+	std::ifstream file(AppConfig::PipelineCacheFile, std::ios::binary | std::ios::ate);
+	if (file.is_open())
+	{
+		const std::streamsize byteCount = file.tellg();
+		cacheData.resize(static_cast<size_t>(byteCount));
+		file.seekg(0, std::ios::beg);
+		if (!file.read(cacheData.data(), byteCount) || !IsPipelineCacheCompatible(cacheData))
+		{
+			// Driver or GPU has changed, start from an empty cache
+			cacheData.clear();
+		}
+	}
+
+	const VkPipelineCacheCreateInfo cacheInfo =
+	{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.initialDataSize = cacheData.size(),
+		.pInitialData = cacheData.empty() ? nullptr : cacheData.data()
+	};
+
+	VK_CHECK(vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_));
+}
+
+bool VulkanContext::IsPipelineCacheCompatible(const std::vector<char>& cacheData) const
+{
+	VkPipelineCacheHeaderVersionOne header{};
+	if (cacheData.size() < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, cacheData.data(), sizeof(header));
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+
+	return
+		header.headerSize >= sizeof(header) &&
+		header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		header.vendorID == properties.vendorID &&
+		header.deviceID == properties.deviceID &&
+		memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void VulkanContext::SavePipelineCache() const
+{
+	if (!pipelineCache_)
+	{
+		return;
+	}
+
+	size_t dataSize = 0;
+	VK_CHECK(vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, nullptr));
+	if (dataSize == 0)
+	{
+		return;
+	}
+	std::vector<char> cacheData(dataSize);
+	VK_CHECK(vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, cacheData.data()));
+
+	// Another instance of the app can save at the same time, see Utility::WriteFileAtomically()
+	if (!Utility::WriteFileAtomically(AppConfig::PipelineCacheFile, std::span<const char>(cacheData.data(), dataSize)))
+	{
+		std::cerr << "Cannot write pipeline cache to " << AppConfig::PipelineCacheFile << '\n';
+	}
+}
+
 void VulkanContext::CheckSurfaceSupport(VulkanInstance& instance) const
 {
 	VkBool32 presentSupported = 0;
@@ -160,6 +262,8 @@ void VulkanContext::ChainFeatures()
 			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT,
 			.pNext = &features11_,
 			.shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
+			.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE, // Texture streaming
+			.descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
 			.descriptorBindingVariableDescriptorCount = VK_TRUE,
 			.runtimeDescriptorArray = VK_TRUE
 		};
@@ -212,7 +316,15 @@ void VulkanContext::ChainFeatures()
 		features_.multiDrawIndirect = VK_TRUE;
 		features_.drawIndirectFirstInstance = VK_TRUE;
 		features_.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+		// Texture streaming feedback is written with atomics in a fragment shader
+		features_.fragmentStoresAndAtomics = VK_TRUE;
 	}
+	// Compute shaders write two channel storage images like the BRDF LUT
+	features_.shaderStorageImageExtendedFormats = VK_TRUE;
+	// The IBL compute shaders write storage images without a format qualifier
+	features_.shaderStorageImageWriteWithoutFormat = VK_TRUE;
+	// SinglePassDownsample.comp indexes an array of storage images, one per mip level
+	features_.shaderStorageImageArrayDynamicIndexing = VK_TRUE;
 
 	// NOTE features2_ and features13_ are always created
 	features13_ =
@@ -580,13 +692,13 @@ VkResult VulkanContext::CreateCommandBuffer(VkCommandPool pool, VkCommandBuffer*
 	return vkAllocateCommandBuffers(device_, &allocInfo, commandBuffer);
 }
 
-VkResult VulkanContext::CreateCommandPool(uint32_t family, VkCommandPool* pool) const
+VkResult VulkanContext::CreateCommandPool(uint32_t family, VkCommandPoolCreateFlags flags, VkCommandPool* pool) const
 {
 	const VkCommandPoolCreateInfo cpi =
 	{
 		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
 		.pNext = nullptr,
-		.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+		.flags = flags,
 		.queueFamilyIndex = family
 	};
 
@@ -610,10 +722,19 @@ bool VulkanContext::IsDeviceSuitable(VkPhysicalDevice d)
 	return isGPU && deviceFeatures.geometryShader;
 }
 
-VkCommandBuffer VulkanContext::BeginOneTimeGraphicsCommand() const
+OneTimeCommand::OneTimeCommand(VkDevice device, VkCommandPool pool, std::recursive_mutex& mutex) :
+	lock_(mutex),
+	device_(device),
+	pool_(pool)
 {
-	VkCommandBuffer commandBuffer;
-	CreateCommandBuffer(graphicsCommandPool_, &commandBuffer);
+	const VkCommandBufferAllocateInfo allocInfo = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		.pNext = nullptr,
+		.commandPool = pool_,
+		.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		.commandBufferCount = 1
+	};
+	VK_CHECK(vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer_));
 
 	constexpr VkCommandBufferBeginInfo beginInfo = {
 		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -621,15 +742,21 @@ VkCommandBuffer VulkanContext::BeginOneTimeGraphicsCommand() const
 		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
 		.pInheritanceInfo = nullptr
 	};
+	VK_CHECK(vkBeginCommandBuffer(commandBuffer_, &beginInfo));
+}
 
-	VK_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
-
-	return commandBuffer;
+OneTimeCommand::~OneTimeCommand()
+{
+	// Not submitted, the lock is still held so the pool can be used
+	if (commandBuffer_ != VK_NULL_HANDLE)
+	{
+		vkFreeCommandBuffers(device_, pool_, 1, &commandBuffer_);
+	}
 }
 
-void VulkanContext::EndOneTimeGraphicsCommand(VkCommandBuffer commandBuffer) const
+void OneTimeCommand::Submit(VkQueue queue)
 {
-	vkEndCommandBuffer(commandBuffer);
+	vkEndCommandBuffer(commandBuffer_);
 
 	const VkSubmitInfo submitInfo = {
 		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
@@ -638,52 +765,37 @@ void VulkanContext::EndOneTimeGraphicsCommand(VkCommandBuffer commandBuffer) con
 		.pWaitSemaphores = nullptr,
 		.pWaitDstStageMask = nullptr,
 		.commandBufferCount = 1,
-		.pCommandBuffers = &commandBuffer,
+		.pCommandBuffers = &commandBuffer_,
 		.signalSemaphoreCount = 0,
 		.pSignalSemaphores = nullptr
 	};
 
-	vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(graphicsQueue_);
-	vkFreeCommandBuffers(device_, graphicsCommandPool_, 1, &commandBuffer);
+	vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+	vkQueueWaitIdle(queue);
+	vkFreeCommandBuffers(device_, pool_, 1, &commandBuffer_);
+	commandBuffer_ = VK_NULL_HANDLE;
+
+	lock_.unlock();
 }
 
-VkCommandBuffer VulkanContext::BeginOneTimeComputeCommand() const
+OneTimeCommand VulkanContext::BeginOneTimeGraphicsCommand() const
 {
-	VkCommandBuffer commandBuffer;
-	CreateCommandBuffer(computeCommandPool_, &commandBuffer);
-
-	constexpr VkCommandBufferBeginInfo beginInfo = {
-		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-		.pNext = nullptr,
-		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-		.pInheritanceInfo = nullptr
-	};
-
-	VK_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
-
-	return commandBuffer;
+	return OneTimeCommand(device_, oneTimeGraphicsCommandPool_, oneTimeCommandMutex_);
 }
 
-void VulkanContext::EndOneTimeComputeCommand(VkCommandBuffer commandBuffer) const
+void VulkanContext::EndOneTimeGraphicsCommand(OneTimeCommand& command) const
 {
-	vkEndCommandBuffer(commandBuffer);
+	command.Submit(graphicsQueue_);
+}
 
-	const VkSubmitInfo submitInfo = {
-		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-		.pNext = nullptr,
-		.waitSemaphoreCount = 0,
-		.pWaitSemaphores = nullptr,
-		.pWaitDstStageMask = nullptr,
-		.commandBufferCount = 1,
-		.pCommandBuffers = &commandBuffer,
-		.signalSemaphoreCount = 0,
-		.pSignalSemaphores = nullptr
-	};
+OneTimeCommand VulkanContext::BeginOneTimeComputeCommand() const
+{
+	return OneTimeCommand(device_, oneTimeComputeCommandPool_, oneTimeCommandMutex_);
+}
 
-	vkQueueSubmit(computeQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(computeQueue_);
-	vkFreeCommandBuffers(device_, computeCommandPool_, 1, &commandBuffer);
+void VulkanContext::EndOneTimeComputeCommand(OneTimeCommand& command) const
+{
+	command.Submit(computeQueue_);
 }
 
 void VulkanContext::AllocateFrameInFlightData()
@@ -732,14 +844,7 @@ VkFormat VulkanContext::FindSupportedFormat(
 {
 	for (VkFormat format : candidates)
 	{
-		VkFormatProperties props;
-		vkGetPhysicalDeviceFormatProperties(physicalDevice_, format, &props);
-
-		if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features)
-		{
-			return format;
-		}
-		else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features)
+		if (IsFormatSupported(format, tiling, features))
 		{
 			return format;
 		}
@@ -748,6 +853,71 @@ VkFormat VulkanContext::FindSupportedFormat(
 	throw std::runtime_error("Failed to find supported format\n");
 }
 
+VulkanMipmapGenerator* VulkanContext::GetMipmapGenerator()
+{
+	// Pipelines that generate mipmaps can be created on worker threads
+	std::lock_guard<std::recursive_mutex> lock(oneTimeCommandMutex_);
+	if (!mipmapGenerator_)
+	{
+		mipmapGenerator_ = std::make_unique<VulkanMipmapGenerator>();
+		mipmapGenerator_->Create(*this);
+	}
+	return mipmapGenerator_.get();
+}
+
+VkSampler VulkanContext::GetSampler(const VkSamplerCreateInfo& samplerInfo)
+{
+	const SamplerKey key =
+	{
+		.flags_ = samplerInfo.flags,
+		.magFilter_ = samplerInfo.magFilter,
+		.minFilter_ = samplerInfo.minFilter,
+		.mipmapMode_ = samplerInfo.mipmapMode,
+		.addressModeU_ = samplerInfo.addressModeU,
+		.addressModeV_ = samplerInfo.addressModeV,
+		.addressModeW_ = samplerInfo.addressModeW,
+		.mipLodBias_ = samplerInfo.mipLodBias,
+		.anisotropyEnable_ = samplerInfo.anisotropyEnable,
+		.maxAnisotropy_ = samplerInfo.maxAnisotropy,
+		.compareEnable_ = samplerInfo.compareEnable,
+		.compareOp_ = samplerInfo.compareOp,
+		.minLod_ = samplerInfo.minLod,
+		.maxLod_ = samplerInfo.maxLod,
+		.borderColor_ = samplerInfo.borderColor,
+		.unnormalizedCoordinates_ = samplerInfo.unnormalizedCoordinates
+	};
+
+	std::lock_guard<std::mutex> lock(samplerCacheMutex_);
+	if (const auto it = samplerCache_.find(key); it != samplerCache_.end())
+	{
+		return it->second;
+	}
+
+	VkSampler sampler;
+	VK_CHECK(vkCreateSampler(device_, &samplerInfo, nullptr, &sampler));
+	samplerCache_[key] = sampler;
+	return sampler;
+}
+
+bool VulkanContext::IsFormatSupported(
+	VkFormat format,
+	VkImageTiling tiling,
+	VkFormatFeatureFlags features) const
+{
+	VkFormatProperties props;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice_, format, &props);
+
+	if (tiling == VK_IMAGE_TILING_LINEAR)
+	{
+		return (props.linearTilingFeatures & features) == features;
+	}
+	else if (tiling == VK_IMAGE_TILING_OPTIMAL)
+	{
+		return (props.optimalTilingFeatures & features) == features;
+	}
+	return false;
+}
+
 void VulkanContext::SetVkObjectName(void* objectHandle, VkObjectType objType, const char* name) const
 {
 	const VkDebugUtilsObjectNameInfoEXT nameInfo = {
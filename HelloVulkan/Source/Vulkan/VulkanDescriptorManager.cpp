@@ -101,6 +101,21 @@ void VulkanDescriptorManager::CreatePoolAndLayout(
 			});
 	}
 
+	// Binding flags, update-after-bind needs a flag on the pool and on the layout
+	std::vector<VkDescriptorBindingFlags> bindingFlags(descriptorInfo.writes_.size());
+	bool hasBindingFlags = false;
+	bool updateAfterBind = false;
+	for (size_t i = 0; i < descriptorInfo.writes_.size(); ++i)
+	{
+		bindingFlags[i] = descriptorInfo.writes_[i].bindingFlags_;
+		hasBindingFlags |= bindingFlags[i] != 0;
+		updateAfterBind |= (bindingFlags[i] & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0;
+	}
+	if (updateAfterBind)
+	{
+		poolFlags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	}
+
 	const VkDescriptorPoolCreateInfo poolInfo = {
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
 		.pNext = nullptr,
@@ -126,11 +141,18 @@ void VulkanDescriptorManager::CreatePoolAndLayout(
 				write.descriptorCount_
 			);
 	}
+	const VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo =
+	{
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+		.pNext = nullptr,
+		.bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+		.pBindingFlags = bindingFlags.data()
+	};
 	const VkDescriptorSetLayoutCreateInfo layoutInfo =
 	{
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
+		.pNext = hasBindingFlags ? &bindingFlagsInfo : nullptr,
+		.flags = updateAfterBind ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : 0u,
 		.bindingCount = static_cast<uint32_t>(layoutBindings.size()),
 		.pBindings = layoutBindings.data()
 	};
@@ -197,6 +219,30 @@ void VulkanDescriptorManager::UpdateSet(
 	);
 }
 
+void VulkanDescriptorManager::UpdateImageArrayElement(
+	VulkanContext& ctx,
+	VkDescriptorSet set,
+	uint32_t bindingIndex,
+	uint32_t arrayElement,
+	const VkDescriptorImageInfo& imageInfo,
+	VkDescriptorType dsType)
+{
+	const VkWriteDescriptorSet descriptorWrite =
+	{
+		.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+		.pNext = nullptr,
+		.dstSet = set,
+		.dstBinding = bindingIndex,
+		.dstArrayElement = arrayElement,
+		.descriptorCount = 1u,
+		.descriptorType = dsType,
+		.pImageInfo = &imageInfo,
+		.pBufferInfo = nullptr,
+		.pTexelBufferView = nullptr
+	};
+	vkUpdateDescriptorSets(ctx.GetDevice(), 1u, &descriptorWrite, 0u, nullptr);
+}
+
 void VulkanDescriptorManager::Destroy()
 {
 	if (layout_)
@@ -50,11 +50,30 @@ void VulkanDescriptorSetInfo::AddImage(
 		});
 }
 
+void VulkanDescriptorSetInfo::AddImage(
+	const VkDescriptorImageInfo& imageInfo,
+	VkDescriptorType dsType,
+	VkShaderStageFlags stageFlags
+)
+{
+	const size_t index = writes_.size();
+	imageMap_[index] = imageInfo;
+
+	writes_.push_back
+	({
+		.imageInfoPtr_ = &(imageMap_[index]),
+		.descriptorCount_ = 1u,
+		.descriptorType_ = dsType,
+		.shaderStage_ = stageFlags
+		});
+}
+
 // Special case for descriptor indexing
 void VulkanDescriptorSetInfo::AddImageArray(
 	const std::vector<VkDescriptorImageInfo>& imageArray,
 	VkDescriptorType dsType,
-	VkShaderStageFlags stageFlags)
+	VkShaderStageFlags stageFlags,
+	VkDescriptorBindingFlags bindingFlags)
 {
 	imageArrays_ = imageArray;
 
@@ -63,10 +82,20 @@ void VulkanDescriptorSetInfo::AddImageArray(
 		.imageInfoPtr_ = imageArrays_.data(),
 		.descriptorCount_ = static_cast<uint32_t>(imageArrays_.size()),
 		.descriptorType_ = dsType,
-		.shaderStage_ = stageFlags
+		.shaderStage_ = stageFlags,
+		.bindingFlags_ = bindingFlags
 		});
 }
 
+void VulkanDescriptorSetInfo::UpdateImageArray(const std::vector<VkDescriptorImageInfo>& imageArray, size_t bindingIndex)
+{
+	CheckBound(bindingIndex);
+
+	imageArrays_ = imageArray;
+	writes_[bindingIndex].imageInfoPtr_ = imageArrays_.data();
+	writes_[bindingIndex].descriptorCount_ = static_cast<uint32_t>(imageArrays_.size());
+}
+
 // Raytracing
 void VulkanDescriptorSetInfo::AddAccelerationStructure(VkShaderStageFlags stageFlags)
 {
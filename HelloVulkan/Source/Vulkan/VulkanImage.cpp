@@ -1,22 +1,23 @@
 #include "VulkanImage.h"
 #include "VulkanBuffer.h"
 #include "VulkanBarrier.h"
+#include "VulkanMipmapGenerator.h"
 #include "VulkanCheck.h"
+#include "Configs.h"
 #include "Utility.h"
+#include "HDRLoader.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 
 void VulkanImage::Destroy()
 {
-	if (defaultImageSampler_)
-	{
-		vkDestroySampler(device_, defaultImageSampler_, nullptr);
-		defaultImageSampler_ = nullptr;
-	}
+	// The default sampler is owned by the sampler cache of VulkanContext
+	defaultImageSampler_ = nullptr;
 
 	if (imageView_)
 	{
@@ -41,7 +42,7 @@ void VulkanImage::CreateImageResources(
 		mipCount_,
 		width_,
 		height_,
-		VK_IMAGE_LAYOUT_UNDEFINED);
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	CreateImageView(
 		ctx,
 		VK_FORMAT_R8G8B8A8_UNORM,
@@ -51,9 +52,10 @@ void VulkanImage::CreateImageResources(
 		mipCount_,
 		0u,
 		layerCount_);
+	// No LOD clamp so textures with different mip counts share a sampler
 	CreateDefaultSampler(ctx,
 		0.f, // minLod
-		static_cast<float>(mipCount_)); // maxLod
+		VK_LOD_CLAMP_NONE); // maxLod
 }
 
 void VulkanImage::CreateImageResources(
@@ -74,7 +76,7 @@ void VulkanImage::CreateImageResources(
 		mipCount_,
 		width_,
 		height_,
-		VK_IMAGE_LAYOUT_UNDEFINED);
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	CreateImageView(
 		ctx,
 		VK_FORMAT_R8G8B8A8_UNORM,
@@ -84,9 +86,10 @@ void VulkanImage::CreateImageResources(
 		mipCount_,
 		0u,
 		layerCount_);
+	// No LOD clamp so textures with different mip counts share a sampler
 	CreateDefaultSampler(ctx,
 		0.f, // minLod
-		static_cast<float>(mipCount_)); // maxLod
+		VK_LOD_CLAMP_NONE); // maxLod
 }
 
 void VulkanImage::CreateFromFile(
@@ -121,6 +124,11 @@ void VulkanImage::CreateFromHDR(
 	VulkanContext& ctx,
 	const char* filename)
 {
+	if (AppConfig::UseHalfFloatHDR && CreateFromHalfFloatHDR(ctx, filename))
+	{
+		return;
+	}
+
 	stbi_set_flip_vertically_on_load(true);
 	int texWidth, texHeight, texChannels;
 	float* pixels = stbi_loadf(filename, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
@@ -144,6 +152,48 @@ void VulkanImage::CreateFromHDR(
 	stbi_image_free(pixels);
 }
 
+bool VulkanImage::CreateFromHalfFloatHDR(
+	VulkanContext& ctx,
+	const char* filename)
+{
+	HDRLoader loader;
+	if (!loader.Open(filename))
+	{
+		return false;
+	}
+
+	VulkanBuffer stagingBuffer{};
+	stagingBuffer.CreateBuffer(
+		ctx,
+		loader.GetDataSize(),
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VMA_MEMORY_USAGE_CPU_ONLY);
+	if (!loader.Load(stagingBuffer.vmaInfo_.pMappedData))
+	{
+		stagingBuffer.Destroy();
+		return false;
+	}
+	VK_CHECK(vmaFlushAllocation(stagingBuffer.vmaAllocator_, stagingBuffer.vmaAllocation_, 0, VK_WHOLE_SIZE));
+
+	constexpr VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT;
+	CreateImage(
+		ctx,
+		loader.GetWidth(),
+		loader.GetHeight(),
+		1u, // mip
+		1u, // layer
+		format,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY);
+	TransitionLayout(ctx, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0u, 1u, 0u, 1u);
+	CopyBufferToImage(ctx, stagingBuffer.buffer_, width_, height_, 1u);
+	TransitionLayout(ctx, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0u, 1u, 0u, 1u);
+
+	stagingBuffer.Destroy();
+	return true;
+}
+
 // Framebuffer attachment
 void VulkanImage::CreateColorAttachment(
 	VulkanContext& ctx, 
@@ -223,6 +273,15 @@ void VulkanImage::CreateImageFromData(
 	VkFormat texFormat,
 	VkImageCreateFlags flags)
 {
+	// Storage usage lets the mipmaps be generated with a compute shader
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	if (AppConfig::UseComputeMipmap &&
+		mipmapCount > 1 &&
+		ctx.IsFormatSupported(texFormat, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT))
+	{
+		usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+	}
+
 	CreateImage(
 		ctx, 
 		texWidth, 
@@ -231,12 +290,158 @@ void VulkanImage::CreateImageFromData(
 		layerCount,
 		texFormat, 
 		VK_IMAGE_TILING_OPTIMAL, 
-		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		usage,
 		VMA_MEMORY_USAGE_GPU_ONLY,
 		flags);
 	UpdateImage(ctx, texWidth, texHeight, texFormat, layerCount, imageData);
 }
 
+void VulkanImage::CreateImageFromMipData(
+	VulkanContext& ctx,
+	const void* imageData,
+	uint32_t texWidth,
+	uint32_t texHeight,
+	uint32_t mipmapCount,
+	uint32_t layerCount,
+	VkFormat texFormat,
+	VkImageCreateFlags flags)
+{
+	CreateImage(
+		ctx,
+		texWidth,
+		texHeight,
+		mipmapCount,
+		layerCount,
+		texFormat,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY,
+		flags);
+
+	VkDeviceSize imageSize = 0;
+	const std::vector<VkBufferImageCopy> regions = GetMipCopyRegions(imageSize);
+
+	VulkanBuffer stagingBuffer{};
+	stagingBuffer.CreateBuffer(
+		ctx,
+		imageSize,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VMA_MEMORY_USAGE_CPU_ONLY);
+	stagingBuffer.UploadBufferData(ctx, imageData, imageSize);
+
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
+	TransitionLayoutCommand(commandBuffer, image_, imageFormat_,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0u, mipCount_, 0u, layerCount_);
+	vkCmdCopyBufferToImage(
+		commandBuffer,
+		stagingBuffer.buffer_,
+		image_,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(regions.size()),
+		regions.data());
+	TransitionLayoutCommand(commandBuffer, image_, imageFormat_,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0u, mipCount_, 0u, layerCount_);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
+
+	stagingBuffer.Destroy();
+}
+
+std::vector<char> VulkanImage::DownloadImageData(VulkanContext& ctx)
+{
+	VkDeviceSize imageSize = 0;
+	const std::vector<VkBufferImageCopy> regions = GetMipCopyRegions(imageSize);
+
+	VulkanBuffer stagingBuffer{};
+	stagingBuffer.CreateBuffer(
+		ctx,
+		imageSize,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VMA_MEMORY_USAGE_AUTO,
+		VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
+	TransitionLayoutCommand(commandBuffer, image_, imageFormat_,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0u, mipCount_, 0u, layerCount_);
+	vkCmdCopyImageToBuffer(
+		commandBuffer,
+		image_,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		stagingBuffer.buffer_,
+		static_cast<uint32_t>(regions.size()),
+		regions.data());
+	TransitionLayoutCommand(commandBuffer, image_, imageFormat_,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0u, mipCount_, 0u, layerCount_);
+
+	// Make the copy visible to the host
+	constexpr VkMemoryBarrier2 barrier = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+		.pNext = nullptr,
+		.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+		.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+		.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT
+	};
+	VulkanBarrier::CreateMemoryBarrier(commandBuffer, &barrier, 1u);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
+
+	std::vector<char> imageData(static_cast<size_t>(imageSize));
+	stagingBuffer.DownloadBufferData(ctx, imageData.data(), imageData.size());
+	stagingBuffer.Destroy();
+
+	return imageData;
+}
+
+VkDeviceSize VulkanImage::GetMipDataSize(
+	uint32_t texWidth,
+	uint32_t texHeight,
+	uint32_t mipmapCount,
+	uint32_t layerCount,
+	VkFormat texFormat)
+{
+	const uint32_t bytesPerPixel = BytesPerTexFormat(texFormat);
+
+	// Same layout as GetMipCopyRegions()
+	VkDeviceSize totalSize = 0;
+	for (uint32_t i = 0; i < mipmapCount; ++i)
+	{
+		const uint32_t mipWidth = std::max(texWidth >> i, 1u);
+		const uint32_t mipHeight = std::max(texHeight >> i, 1u);
+		totalSize += static_cast<VkDeviceSize>(mipWidth) * mipHeight * bytesPerPixel * layerCount;
+	}
+	return totalSize;
+}
+
+std::vector<VkBufferImageCopy> VulkanImage::GetMipCopyRegions(VkDeviceSize& totalSize)
+{
+	const uint32_t bytesPerPixel = BytesPerTexFormat(imageFormat_);
+
+	std::vector<VkBufferImageCopy> regions(mipCount_);
+	totalSize = 0;
+	for (uint32_t i = 0; i < mipCount_; ++i)
+	{
+		const uint32_t mipWidth = std::max(width_ >> i, 1u);
+		const uint32_t mipHeight = std::max(height_ >> i, 1u);
+		regions[i] =
+		{
+			.bufferOffset = totalSize,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = VkImageSubresourceLayers {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = i,
+				.baseArrayLayer = 0,
+				.layerCount = layerCount_
+			},
+			.imageOffset = VkOffset3D {.x = 0, .y = 0, .z = 0 },
+			.imageExtent = VkExtent3D {.width = mipWidth, .height = mipHeight, .depth = 1 }
+		};
+		totalSize += static_cast<VkDeviceSize>(mipWidth) * mipHeight * bytesPerPixel * layerCount_;
+	}
+	return regions;
+}
+
 void VulkanImage::CopyBufferToImage(
 	VulkanContext& ctx,
 	VkBuffer buffer,
@@ -244,7 +449,8 @@ void VulkanImage::CopyBufferToImage(
 	uint32_t height,
 	uint32_t layerCount)
 {
-	VkCommandBuffer commandBuffer = ctx.BeginOneTimeGraphicsCommand();
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
 	const VkBufferImageCopy region = {
 		.bufferOffset = 0,
 		.bufferRowLength = 0,
@@ -259,7 +465,7 @@ void VulkanImage::CopyBufferToImage(
 		.imageExtent = VkExtent3D {.width = width, .height = height, .depth = 1 }
 	};
 	vkCmdCopyBufferToImage(commandBuffer, buffer, image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-	ctx.EndOneTimeGraphicsCommand(commandBuffer);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
 }
 
 void VulkanImage::CreateImage(
@@ -280,6 +486,7 @@ void VulkanImage::CreateImage(
 	mipCount_ = mipCount;
 	layerCount_ = layerCount;
 	imageFormat_ = format;
+	imageUsage_ = imageUsage;
 	multisampleCount_ = sampleCount; // MSAA
 	
 	const VkImageCreateInfo imageInfo = {
@@ -377,15 +584,13 @@ void VulkanImage::CreateDefaultSampler(
 	VkFilter maxFilter,
 	VkSamplerAddressMode addressMode)
 {
-	CreateSampler(
-		ctx,
-		defaultImageSampler_,
+	const VkSamplerCreateInfo samplerInfo = GetSamplerCreateInfo(
 		minLod,
 		maxLod,
 		minFilter,
 		maxFilter,
-		addressMode
-	);
+		addressMode);
+	defaultImageSampler_ = ctx.GetSampler(samplerInfo);
 }
 
 void VulkanImage::CreateSampler(
@@ -397,12 +602,28 @@ void VulkanImage::CreateSampler(
 	VkFilter maxFilter,
 	VkSamplerAddressMode addressMode)
 {
-	const VkSamplerCreateInfo samplerInfo = {
+	const VkSamplerCreateInfo samplerInfo = GetSamplerCreateInfo(
+		minLod,
+		maxLod,
+		minFilter,
+		maxFilter,
+		addressMode);
+	VK_CHECK(vkCreateSampler(ctx.GetDevice(), &samplerInfo, nullptr, &sampler));
+}
+
+VkSamplerCreateInfo VulkanImage::GetSamplerCreateInfo(
+	float minLod,
+	float maxLod,
+	VkFilter minFilter,
+	VkFilter maxFilter,
+	VkSamplerAddressMode addressMode)
+{
+	return {
 		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = 0,
-		.magFilter = VK_FILTER_LINEAR,
-		.minFilter = VK_FILTER_LINEAR,
+		.magFilter = maxFilter,
+		.minFilter = minFilter,
 		.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
 		.addressModeU = addressMode,
 		.addressModeV = addressMode,
@@ -417,7 +638,6 @@ void VulkanImage::CreateSampler(
 		.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
 		.unnormalizedCoordinates = VK_FALSE
 	};
-	VK_CHECK(vkCreateSampler(ctx.GetDevice(), &samplerInfo, nullptr, &sampler));
 }
 
 void VulkanImage::UpdateImage(
@@ -468,7 +688,8 @@ void VulkanImage::TransitionLayout(
 	uint32_t layerLevel,
 	uint32_t layerCount)
 {
-	VkCommandBuffer commandBuffer = ctx.BeginOneTimeGraphicsCommand();
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
 	TransitionLayoutCommand(commandBuffer, 
 		image_, 
 		format, 
@@ -478,7 +699,7 @@ void VulkanImage::TransitionLayout(
 		mipCount,
 		layerLevel,
 		layerCount);
-	ctx.EndOneTimeGraphicsCommand(commandBuffer);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
 }
 
 void VulkanImage::TransitionLayoutCommand(
@@ -641,6 +862,41 @@ void VulkanImage::TransitionLayoutCommand(
 		barrier.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
 		barrier.dstStageMask = VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT;
 	}
+	// Read back an attachment
+	else if (oldLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+	{
+		barrier.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+	}
+	// The attachment is written again after it was read back
+	else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+	{
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+	}
+	// Read back a sampled image
+	else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+	{
+		barrier.srcAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+	}
+	else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+	{
+		barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+	}
 	// Convert from updateable texture to shader read-only
 	else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
 	{
@@ -672,7 +928,14 @@ void VulkanImage::GenerateMipmap(
 	VkImageLayout currentImageLayout
 )
 {
-	VkCommandBuffer commandBuffer = ctx.BeginOneTimeGraphicsCommand();
+	if (AppConfig::UseComputeMipmap && VulkanMipmapGenerator::IsSupported(ctx, this, maxMipLevels))
+	{
+		ctx.GetMipmapGenerator()->GenerateMipmap(ctx, this, maxMipLevels, currentImageLayout);
+		return;
+	}
+
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
 
 	VulkanBarrier::CreateImageBarrier(
 		{
@@ -723,11 +986,11 @@ void VulkanImage::GenerateMipmap(
 			.layerCount = layerCount_
 		};
 
-		// Transition current mip level to transfer dest
+		// Transition current mip level to transfer dest, its content is overwritten
 		VulkanBarrier::CreateImageBarrier(
 			{
 				.commandBuffer = commandBuffer,
-				.oldLayout = currentImageLayout,
+				.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
 				.sourceStage = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
 				.sourceAccess = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
 				.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
@@ -782,7 +1045,7 @@ void VulkanImage::GenerateMipmap(
 	image_
 	);
 
-	ctx.EndOneTimeGraphicsCommand(commandBuffer);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
 }
 
 uint32_t VulkanImage::BytesPerTexFormat(VkFormat fmt)
@@ -798,6 +1061,8 @@ uint32_t VulkanImage::BytesPerTexFormat(VkFormat fmt)
 	case VK_FORMAT_R16G16_SNORM:
 	case VK_FORMAT_B8G8R8A8_UNORM:
 	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+	case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
 		return 4;
 	case VK_FORMAT_R32G32_SFLOAT:
 		return 2 * sizeof(float);
@@ -0,0 +1,356 @@
+#include "VulkanMipmapGenerator.h"
+#include "VulkanImage.h"
+#include "VulkanBarrier.h"
+#include "VulkanShader.h"
+#include "VulkanCheck.h"
+#include "PushConstants.h"
+#include "Configs.h"
+
+#include <algorithm>
+
+// Must match SinglePassDownsample.comp
+constexpr uint32_t MaxMipCount = 13u; // Including mip 0
+constexpr uint32_t TileSideLength = 64u; // Texels of mip 0 per workgroup side
+constexpr uint32_t Mip6SideLength = 64u;
+constexpr uint32_t MaxLayerCount = 6u;
+constexpr uint32_t MaxTargetCount = 16u; // Pool size, targets kept by the callers plus the one of GenerateMipmap()
+
+void VulkanMipmapGenerator::Create(VulkanContext& ctx)
+{
+	device_ = ctx.GetDevice();
+	CreateSampler(ctx);
+	CreateBuffers(ctx);
+	CreateDescriptorLayout(ctx);
+	CreatePipeline(ctx);
+}
+
+void VulkanMipmapGenerator::Destroy()
+{
+	vkDestroyPipeline(device_, pipeline_, nullptr);
+	vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
+	vkDestroySampler(device_, sampler_, nullptr);
+	descriptorManager_.Destroy();
+	mip6Buffer_.Destroy();
+	counterBuffer_.Destroy();
+}
+
+bool VulkanMipmapGenerator::IsSupported(VulkanContext& ctx, const VulkanImage* image, uint32_t mipCount)
+{
+	constexpr VkImageUsageFlags usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	constexpr VkFormatFeatureFlags features =
+		VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT |
+		VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+		VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	const uint32_t maxSideLength = TileSideLength * Mip6SideLength;
+
+	return (image->imageUsage_ & usage) == usage &&
+		image->multisampleCount_ == VK_SAMPLE_COUNT_1_BIT &&
+		mipCount > 1u && mipCount <= MaxMipCount && mipCount <= image->mipCount_ &&
+		image->layerCount_ <= MaxLayerCount &&
+		image->width_ <= maxSideLength && image->height_ <= maxSideLength &&
+		ctx.IsFormatSupported(image->imageFormat_, VK_IMAGE_TILING_OPTIMAL, features);
+}
+
+void VulkanMipmapGenerator::GenerateMipmap(
+	VulkanContext& ctx,
+	VulkanImage* image,
+	uint32_t mipCount,
+	VkImageLayout currentImageLayout)
+{
+	// The descriptor pool is externally synchronized and images are loaded on worker threads,
+	// the set is allocated, used, and freed under one lock
+	const auto lock = ctx.LockQueues();
+
+	MipmapTarget target;
+	CreateTarget(ctx, image, mipCount, target);
+
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
+	RecordCommand(commandBuffer, target, currentImageLayout);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
+
+	DestroyTarget(ctx, target);
+}
+
+void VulkanMipmapGenerator::CreateTarget(
+	VulkanContext& ctx,
+	VulkanImage* image,
+	uint32_t mipCount,
+	MipmapTarget& target)
+{
+	target.image_ = image;
+	target.mipCount_ = mipCount;
+	target.workGroupCountX_ = (image->width_ + TileSideLength - 1) / TileSideLength;
+	target.workGroupCountY_ = (image->height_ + TileSideLength - 1) / TileSideLength;
+
+	// Mip 0 is sampled, the other mip levels are storage images
+	VulkanImage::CreateImageView(
+		ctx,
+		image->image_,
+		target.sourceView_,
+		image->imageFormat_,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+		0u,
+		1u,
+		0u,
+		image->layerCount_);
+	target.mipViews_ = std::vector<VkImageView>(mipCount - 1, VK_NULL_HANDLE);
+	for (uint32_t i = 1; i < mipCount; ++i)
+	{
+		VulkanImage::CreateImageView(
+			ctx,
+			image->image_,
+			target.mipViews_[i - 1],
+			image->imageFormat_,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+			i,
+			1u,
+			0u,
+			image->layerCount_);
+	}
+
+	// Every array element needs a valid view, the unused ones are never written
+	std::vector<VkDescriptorImageInfo> mipInfos(MaxMipCount - 1);
+	for (uint32_t i = 0; i < mipInfos.size(); ++i)
+	{
+		mipInfos[i] =
+		{
+			.imageView = target.mipViews_[std::min(i, static_cast<uint32_t>(target.mipViews_.size() - 1))],
+			.imageLayout = VK_IMAGE_LAYOUT_GENERAL
+		};
+	}
+
+	VulkanDescriptorSetInfo dsInfo;
+	dsInfo.AddImage(
+		{
+			.sampler = sampler_,
+			.imageView = target.sourceView_,
+			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		},
+		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		VK_SHADER_STAGE_COMPUTE_BIT);
+	dsInfo.AddImageArray(mipInfos, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+	dsInfo.AddBuffer(&mip6Buffer_, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+	dsInfo.AddBuffer(&counterBuffer_, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+	descriptorManager_.CreateSet(ctx, dsInfo, &target.descriptorSet_);
+}
+
+void VulkanMipmapGenerator::DestroyTarget(VulkanContext& ctx, MipmapTarget& target)
+{
+	VK_CHECK(vkFreeDescriptorSets(ctx.GetDevice(), descriptorManager_.pool_, 1u, &target.descriptorSet_));
+	vkDestroyImageView(ctx.GetDevice(), target.sourceView_, nullptr);
+	for (VkImageView& view : target.mipViews_)
+	{
+		vkDestroyImageView(ctx.GetDevice(), view, nullptr);
+	}
+	target = {};
+}
+
+void VulkanMipmapGenerator::RecordCommand(
+	VkCommandBuffer commandBuffer,
+	const MipmapTarget& target,
+	VkImageLayout currentImageLayout)
+{
+	const VulkanImage* image = target.image_;
+
+	// The buffers are shared by every dispatch
+	const VkMemoryBarrier2 bufferBarrier =
+	{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+		.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+		.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+		.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT
+	};
+	VulkanBarrier::CreateMemoryBarrier(commandBuffer, &bufferBarrier, 1u);
+
+	const VkImageSubresourceRange sourceRange =
+	{
+		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		.baseMipLevel = 0u,
+		.levelCount = 1u,
+		.baseArrayLayer = 0u,
+		.layerCount = image->layerCount_
+	};
+	const VkImageSubresourceRange mipRange =
+	{
+		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		.baseMipLevel = 1u,
+		.levelCount = target.mipCount_ - 1u,
+		.baseArrayLayer = 0u,
+		.layerCount = image->layerCount_
+	};
+
+	VulkanBarrier::CreateImageBarrier({
+			.commandBuffer = commandBuffer,
+			.oldLayout = currentImageLayout,
+			.sourceStage = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+			.sourceAccess = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			.destinationStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.destinationAccess = VK_ACCESS_2_SHADER_READ_BIT
+		},
+		sourceRange,
+		image->image_);
+
+	// The old content is discarded, but the previous frame may still be sampling it
+	VulkanBarrier::CreateImageBarrier({
+			.commandBuffer = commandBuffer,
+			.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.sourceStage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.sourceAccess = VK_ACCESS_2_NONE,
+			.newLayout = VK_IMAGE_LAYOUT_GENERAL,
+			.destinationStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.destinationAccess = VK_ACCESS_2_SHADER_WRITE_BIT
+		},
+		mipRange,
+		image->image_);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+	vkCmdBindDescriptorSets(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		pipelineLayout_,
+		0, // firstSet
+		1, // descriptorSetCount
+		&target.descriptorSet_,
+		0, // dynamicOffsetCount
+		0); // pDynamicOffsets
+
+	const PushConstSinglePassDownsample pc =
+	{
+		.mipCount = target.mipCount_,
+		.workGroupCountX = target.workGroupCountX_,
+		.workGroupCountY = target.workGroupCountY_
+	};
+	vkCmdPushConstants(
+		commandBuffer,
+		pipelineLayout_,
+		VK_SHADER_STAGE_COMPUTE_BIT,
+		0,
+		sizeof(PushConstSinglePassDownsample), &pc);
+
+	vkCmdDispatch(commandBuffer,
+		target.workGroupCountX_,
+		target.workGroupCountY_,
+		image->layerCount_);
+
+	// Convention is to change the layout to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	VulkanBarrier::CreateImageBarrier({
+			.commandBuffer = commandBuffer,
+			.oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+			.sourceStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.sourceAccess = VK_ACCESS_2_SHADER_WRITE_BIT,
+			.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			.destinationStage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.destinationAccess = VK_ACCESS_2_SHADER_READ_BIT
+		},
+		mipRange,
+		image->image_);
+}
+
+void VulkanMipmapGenerator::CreateSampler(VulkanContext& ctx)
+{
+	// Clamped so the bilinear footprint of an edge texel stays inside the image
+	const VkSamplerCreateInfo samplerInfo = {
+		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.magFilter = VK_FILTER_LINEAR,
+		.minFilter = VK_FILTER_LINEAR,
+		.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+		.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.mipLodBias = 0.0f,
+		.anisotropyEnable = VK_FALSE,
+		.maxAnisotropy = 1.0f,
+		.compareEnable = VK_FALSE,
+		.compareOp = VK_COMPARE_OP_ALWAYS,
+		.minLod = 0.0f,
+		.maxLod = 0.0f,
+		.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+		.unnormalizedCoordinates = VK_FALSE
+	};
+	VK_CHECK(vkCreateSampler(ctx.GetDevice(), &samplerInfo, nullptr, &sampler_));
+}
+
+void VulkanMipmapGenerator::CreateBuffers(VulkanContext& ctx)
+{
+	mip6Buffer_.CreateBuffer(
+		ctx,
+		static_cast<VkDeviceSize>(MaxLayerCount) * Mip6SideLength * Mip6SideLength * 4 * sizeof(float),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY,
+		0);
+
+	counterBuffer_.CreateBuffer(
+		ctx,
+		MaxLayerCount * sizeof(uint32_t),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY,
+		0);
+
+	// The counters start at zero and the last workgroup of each dispatch resets them
+	OneTimeCommand oneTimeCommand = ctx.BeginOneTimeGraphicsCommand();
+	VkCommandBuffer commandBuffer = oneTimeCommand.GetCommandBuffer();
+	vkCmdFillBuffer(commandBuffer, counterBuffer_.buffer_, 0, VK_WHOLE_SIZE, 0u);
+	ctx.EndOneTimeGraphicsCommand(oneTimeCommand);
+}
+
+void VulkanMipmapGenerator::CreateDescriptorLayout(VulkanContext& ctx)
+{
+	VulkanDescriptorSetInfo dsInfo;
+	dsInfo.AddImage(nullptr, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
+	dsInfo.AddImageArray(std::vector<VkDescriptorImageInfo>(MaxMipCount - 1), VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT);
+	dsInfo.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+	dsInfo.AddBuffer(nullptr, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+	descriptorManager_.CreatePoolAndLayout(ctx, dsInfo, 1u, MaxTargetCount, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+}
+
+void VulkanMipmapGenerator::CreatePipeline(VulkanContext& ctx)
+{
+	const VkPushConstantRange pcRange =
+	{
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0u,
+		.size = sizeof(PushConstSinglePassDownsample)
+	};
+	const VkPipelineLayoutCreateInfo pipelineLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptorManager_.layout_,
+		.pushConstantRangeCount = 1u,
+		.pPushConstantRanges = &pcRange
+	};
+	VK_CHECK(vkCreatePipelineLayout(ctx.GetDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout_));
+
+	const std::string shaderFile = AppConfig::ShaderFolder + "Common/SinglePassDownsample.comp";
+	VulkanShader shader;
+	VK_CHECK(shader.Create(ctx.GetDevice(), shaderFile.c_str()));
+
+	const VkComputePipelineCreateInfo computePipelineCreateInfo = {
+		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.stage = {  // ShaderStageInfo
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+			.module = shader.GetShaderModule(),
+			.pName = "main",
+			.pSpecializationInfo = nullptr
+		},
+		.layout = pipelineLayout_,
+		.basePipelineHandle = 0,
+		.basePipelineIndex = 0
+	};
+	VK_CHECK(vkCreateComputePipelines(ctx.GetDevice(), ctx.GetPipelineCache(), 1, &computePipelineCreateInfo, nullptr, &pipeline_));
+
+	shader.Destroy();
+}
\ No newline at end of file
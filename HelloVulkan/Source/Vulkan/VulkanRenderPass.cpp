@@ -697,6 +697,15 @@ void VulkanRenderPass::CreateBeginInfo()
 	};
 }
 
+void VulkanRenderPass::SetClearColor(uint32_t attachmentIndex, const VkClearColorValue& color)
+{
+	// Only set if the render pass has RenderPassBit::ColorClear
+	if (attachmentIndex < colorAttachmentCount_ && attachmentIndex < clearValues_.size())
+	{
+		clearValues_[attachmentIndex].color = color;
+	}
+}
+
 void VulkanRenderPass::BeginRenderPass(
 	VulkanContext& ctx,
 	VkCommandBuffer commandBuffer, 
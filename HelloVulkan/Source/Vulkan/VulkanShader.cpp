@@ -1,8 +1,15 @@
 #include "VulkanShader.h"
 #include "Configs.h"
+#include "Utility.h"
 
 #include <iostream>
+#include <fstream>
 #include <cstring>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
 
 #include <glslang/Public/resource_limits_c.h>
 
@@ -15,6 +22,26 @@ inline int EndsWith(const char* s, const char* part)
 	return (strstr(s, part) - s) == (strlen(s) - strlen(part));
 }
 
+// glslang target, these are also part of the SPIR-V cache key
+constexpr glslang_target_client_version_t ClientVersion = GLSLANG_TARGET_VULKAN_1_3;
+constexpr glslang_target_language_version_t TargetLanguageVersion = GLSLANG_TARGET_SPV_1_5;
+
+// Include files with their own includes already resolved
+struct ResolvedInclude
+{
+	std::string code_;
+	std::vector<std::string> files_; // Every file pasted into code_, including itself
+};
+
+// Shared by all shaders, pipelines can be created on multiple threads
+static std::mutex includeMutex;
+static std::unordered_map<std::string, ResolvedInclude> includeCache;
+static std::unordered_map<std::string, std::unordered_set<std::string>> dependentShaders; // Include file to shaders that use it
+
+// Increment this if the compilation settings change in a way that is not covered by the key
+constexpr uint32_t SPIRVCacheVersion = 1u;
+constexpr uint32_t SPIRVMagicNumber = 0x07230203u;
+
 VkResult VulkanShader::Create(VkDevice device, const char* fileName)
 {
 	if (CompileShaderFile(fileName) < 1)
@@ -61,15 +88,207 @@ VkPipelineShaderStageCreateInfo VulkanShader::GetShaderStageInfo(
 size_t VulkanShader::CompileShaderFile(const char* file)
 {
 	std::string shaderSource = ReadShaderFile(file);
-	if (!shaderSource.empty())
+	if (shaderSource.empty())
+	{
+		return 0;
+	}
+
+	if (AppConfig::UsePrecompiledShaders && LoadPrecompiled(file, shaderSource))
+	{
+		return spirv_.size();
+	}
+
+	const glslang_stage_t stage = GLSLangShaderStageFromFileName(file);
+	if constexpr (!AppConfig::UseShaderCache)
+	{
+		return CompileShader(stage, shaderSource.c_str());
+	}
+
+	// A cache hit skips preprocess, parse, link, and codegen entirely
+	const std::string cacheFile = GetCacheFilePath(stage, shaderSource);
+	if (LoadFromCache(cacheFile))
+	{
+		return spirv_.size();
+	}
+
+	if (CompileShader(stage, shaderSource.c_str()) > 0)
+	{
+		SaveToCache(cacheFile);
+	}
+
+	return spirv_.size();
+}
+
+std::string VulkanShader::GetCacheFilePath(glslang_stage_t stage, const std::string& shaderSource) const
+{
+	const uint32_t settings[] =
+	{
+		SPIRVCacheVersion,
+		static_cast<uint32_t>(stage),
+		static_cast<uint32_t>(ClientVersion),
+		static_cast<uint32_t>(TargetLanguageVersion)
+	};
+	uint64_t hash = Utility::Hash(shaderSource.data(), shaderSource.size());
+	hash = Utility::Hash(settings, sizeof(settings), hash);
+
+	return Utility::GetCacheFilePath(AppConfig::ShaderCacheFolder, hash, ".spv");
+}
+
+bool VulkanShader::LoadFromCache(const std::string& cacheFile)
+{
+	std::ifstream file(cacheFile, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	const std::streamsize byteCount = file.tellg();
+	if (byteCount < static_cast<std::streamsize>(sizeof(uint32_t)) || byteCount % sizeof(uint32_t) != 0)
+	{
+		return false;
+	}
+
+	std::vector<unsigned int> code(static_cast<size_t>(byteCount) / sizeof(unsigned int));
+	file.seekg(0, std::ios::beg);
+	if (!file.read(reinterpret_cast<char*>(code.data()), byteCount) || code[0] != SPIRVMagicNumber)
+	{
+		std::cerr << "Ignoring corrupted SPIR-V cache file " << cacheFile << '\n';
+		return false;
+	}
+
+	spirv_ = std::move(code);
+	return true;
+}
+
+bool VulkanShader::LoadPrecompiled(const std::string& file, const std::string& shaderSource)
+{
+	if (!file.starts_with(AppConfig::ShaderFolder))
+	{
+		return false;
+	}
+	const std::string basePath = AppConfig::PrecompiledShaderFolder + file.substr(AppConfig::ShaderFolder.size());
+
+	std::ifstream sourceFile(basePath + ".src", std::ios::binary);
+	if (!sourceFile.is_open())
+	{
+		return false;
+	}
+	std::string builtSource((std::istreambuf_iterator<char>(sourceFile)), std::istreambuf_iterator<char>());
+
+	// The build strips carriage returns, the runtime source may still have them
+	std::string currentSource = shaderSource;
+	std::erase(currentSource, '\r');
+	std::erase(builtSource, '\r');
+	if (builtSource != currentSource)
+	{
+		// Edited after the build, compile it at runtime instead
+		return false;
+	}
+
+	return LoadFromCache(basePath + ".spv");
+}
+
+void VulkanShader::SaveToCache(const std::string& cacheFile) const
+{
+	// Two pipelines can compile the same shader concurrently, see Utility::WriteFileAtomically()
+	const std::span<const char> bytes(reinterpret_cast<const char*>(spirv_.data()), spirv_.size() * sizeof(unsigned int));
+	if (!Utility::WriteFileAtomically(cacheFile, bytes))
+	{
+		std::cerr << "Cannot write SPIR-V cache file " << cacheFile << '\n';
+	}
+}
+
+std::vector<std::string> VulkanShader::GetDependentShaders(const std::string& file)
+{
+	std::scoped_lock lock(includeMutex);
+	const auto it = dependentShaders.find(file);
+	if (it == dependentShaders.end())
 	{
-		return CompileShader(GLSLangShaderStageFromFileName(file), shaderSource.c_str());
+		return {};
 	}
+	return { it->second.begin(), it->second.end() };
+}
 
-	return 0;
+void VulkanShader::InvalidateIncludeCache(const std::string& file)
+{
+	std::scoped_lock lock(includeMutex);
+	std::erase_if(includeCache, [&file](const auto& item)
+	{
+		const std::vector<std::string>& files = item.second.files_;
+		return std::find(files.begin(), files.end(), file) != files.end();
+	});
 }
 
 std::string VulkanShader::ReadShaderFile(const char* fileName)
+{
+	std::vector<std::string> includedFiles;
+	std::string code = ResolveIncludes(ReadTextFile(fileName), includedFiles);
+
+	std::scoped_lock lock(includeMutex);
+	for (const std::string& include : includedFiles)
+	{
+		dependentShaders[include].insert(fileName);
+	}
+
+	return code;
+}
+
+std::string VulkanShader::ResolveIncludes(const std::string& code, std::vector<std::string>& includedFiles)
+{
+	// Single forward pass, each include is appended once instead of splicing into the whole source
+	std::string result;
+	result.reserve(code.size());
+
+	size_t start = 0;
+	size_t pos = code.find("#include ");
+	while (pos != code.npos)
+	{
+		const auto p1 = code.find('<', pos);
+		const auto p2 = code.find('>', pos);
+		if (p1 == code.npos || p2 == code.npos || p2 <= p1)
+		{
+			std::cerr << "Error while loading shader program: " << code.c_str() << '\n';
+			return std::string();
+		}
+		const std::string name = AppConfig::ShaderFolder + code.substr(p1 + 1, p2 - p1 - 1);
+
+		ResolvedInclude include;
+		bool cached = false;
+		{
+			std::scoped_lock lock(includeMutex);
+			if (const auto it = includeCache.find(name); it != includeCache.end())
+			{
+				include = it->second;
+				cached = true;
+			}
+		}
+		if (!cached)
+		{
+			const std::string includeCode = ReadTextFile(name.c_str());
+			include.code_ = ResolveIncludes(includeCode, include.files_);
+			include.files_.push_back(name);
+
+			// A missing file is not cached so it is read again once it exists
+			if (!includeCode.empty())
+			{
+				std::scoped_lock lock(includeMutex);
+				includeCache[name] = include;
+			}
+		}
+
+		result.append(code, start, pos - start);
+		result.append(include.code_);
+		includedFiles.insert(includedFiles.end(), include.files_.begin(), include.files_.end());
+
+		start = p2 + 1;
+		pos = code.find("#include ", start);
+	}
+	result.append(code, start, code.npos);
+
+	return result;
+}
+
+std::string VulkanShader::ReadTextFile(const char* fileName)
 {
 	FILE* file = fopen(fileName, "r");
 
@@ -100,24 +319,7 @@ std::string VulkanShader::ReadShaderFile(const char* fileName)
 		}
 	}
 
-	std::string code(buffer.data());
-
-	while (code.find("#include ") != code.npos)
-	{
-		const auto pos = code.find("#include ");
-		const auto p1 = code.find('<', pos);
-		const auto p2 = code.find('>', pos);
-		if (p1 == code.npos || p2 == code.npos || p2 <= p1)
-		{
-			std::cerr << "Error while loading shader program: " << code.c_str() << '\n';
-			return std::string();
-		}
-		const std::string name = AppConfig::ShaderFolder + code.substr(p1 + 1, p2 - p1 - 1);
-		const std::string include = ReadShaderFile(name.c_str());
-		code.replace(pos, p2 - pos + 1, include.c_str());
-	}
-
-	return code;
+	return std::string(buffer.data());
 }
 
 size_t VulkanShader::CompileShader(glslang_stage_t stage, const char* shaderSource)
@@ -127,9 +329,9 @@ size_t VulkanShader::CompileShader(glslang_stage_t stage, const char* shaderSour
 		.language = GLSLANG_SOURCE_GLSL,
 		.stage = stage,
 		.client = GLSLANG_CLIENT_VULKAN,
-		.client_version = GLSLANG_TARGET_VULKAN_1_3,
+		.client_version = ClientVersion,
 		.target_language = GLSLANG_TARGET_SPV,
-		.target_language_version = GLSLANG_TARGET_SPV_1_5,
+		.target_language_version = TargetLanguageVersion,
 		.code = shaderSource,
 		.default_version = 100,
 		.default_profile = GLSLANG_NO_PROFILE,
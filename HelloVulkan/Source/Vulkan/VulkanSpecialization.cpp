@@ -23,12 +23,12 @@ void VulkanSpecialization::Inject(std::vector<VkPipelineShaderStageCreateInfo>&
 		return;
 	}
 
+	// Every stage in shaderStages_ gets the same constants
 	for (auto& stageInfo : shaderInfoArray)
 	{
 		if (stageInfo.stage & shaderStages_)
 		{
 			stageInfo.pSpecializationInfo = &specializationInfo_;
-			break;
 		}
 	}
 }
\ No newline at end of file